@@ -0,0 +1,137 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vbr::allocator {
+
+// two level segregated fit free list over one [0, size) range, only does
+// the offset bookkeeping, memory is owned by the caller
+class Tlsf {
+  public:
+    static constexpr uint32_t invalid = UINT32_MAX;
+
+  private:
+    // second level classes per first level
+    static constexpr uint32_t sl_bits = 4;
+    static constexpr uint32_t sl_count = 1u << sl_bits;
+    // sizes below it share the first level 0 with linear classes
+    static constexpr uint32_t small_bits = 8;
+    static constexpr VkDeviceSize small_size = 1ull << small_bits;
+    static constexpr uint32_t fl_count = 64 - small_bits + 1;
+
+    struct Node {
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // neighbours in address order
+        uint32_t prev_phys = invalid;
+        uint32_t next_phys = invalid;
+        // neighbours in the free list
+        uint32_t prev_free = invalid;
+        uint32_t next_free = invalid;
+        bool free = false;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_unused_nodes;
+    uint64_t m_fl_bitmap = 0;
+    std::array<uint32_t, fl_count> m_sl_bitmap{};
+    std::array<uint32_t, fl_count * sl_count> m_heads;
+    VkDeviceSize m_size = 0;
+    VkDeviceSize m_used = 0;
+    uint32_t m_count = 0;
+
+  private:
+    static void mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+    uint32_t newNode();
+    void insertFree(uint32_t node);
+    void removeFree(uint32_t node);
+    uint32_t findFree(VkDeviceSize size);
+    // cut the head of node off into a new free node
+    void splitFront(uint32_t node, VkDeviceSize size);
+    // cut the tail of node off into a new free node
+    void splitBack(uint32_t node, VkDeviceSize size);
+    void merge(uint32_t front, uint32_t back);
+
+  public:
+    explicit Tlsf(VkDeviceSize size);
+
+    // return node handle for free(), invalid when no range fits
+    uint32_t allocate(VkDeviceSize size, VkDeviceSize alignment,
+                      VkDeviceSize &offset);
+    void free(uint32_t node);
+
+    VkDeviceSize size() const { return m_size; }
+    VkDeviceSize used() const { return m_used; }
+    uint32_t count() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+};
+
+struct Allocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // host visible blocks are mapped for their whole lifetime
+    void *mapped = nullptr;
+    uint32_t block = Tlsf::invalid;
+    uint32_t node = Tlsf::invalid;
+
+    bool valid() const { return memory != VK_NULL_HANDLE; }
+};
+
+class Allocator {
+  private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr;
+        uint32_t type = 0;
+        // buffers and linear images never share a block with optimal images,
+        // this keeps every block free of bufferImageGranularity conflicts
+        bool linear = true;
+        // dedicated blocks hold one large resource and have no free list
+        std::unique_ptr<Tlsf> tlsf;
+    };
+
+    VkDevice &m_device;
+    const VkPhysicalDeviceMemoryProperties &m_memory_properties;
+    VkDeviceSize m_block_size;
+    VkDeviceSize m_granularity;
+    // freed blocks leave an empty slot so block index stay stable
+    std::vector<Block> m_blocks;
+    std::vector<uint32_t> m_unused_blocks;
+    uint32_t m_count = 0;
+
+  private:
+    VkDeviceSize blockSize(uint32_t type) const;
+    uint32_t createBlock(uint32_t type, VkDeviceSize size, bool linear,
+                         bool dedicated);
+    void destroyBlock(uint32_t index);
+
+  public:
+    Allocator(VkDevice &device,
+              const VkPhysicalDeviceMemoryProperties &memory_properties,
+              VkDeviceSize granularity,
+              VkDeviceSize block_size = 64ull * 1024 * 1024);
+    ~Allocator();
+
+    bool allocate(const VkMemoryRequirements &requirements, uint32_t type,
+                  bool linear, Allocation &allocation);
+    void free(Allocation &allocation);
+
+    // live sub allocations and vkAllocateMemory blocks
+    uint32_t count() const { return m_count; }
+    uint32_t blockCount() const {
+        return static_cast<uint32_t>(m_blocks.size() - m_unused_blocks.size());
+    }
+
+    Allocator(Allocator &) = delete;
+    Allocator(Allocator &&) = delete;
+    Allocator &operator=(Allocator &) = delete;
+    Allocator &operator=(Allocator &&) = delete;
+};
+
+} // namespace vbr::allocator
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <vector>
+
+namespace vbr::device {
+class Device;
+}
+
+namespace vbr::acompute {
+
+// timeline value a compute batch signals once it is done on the gpu
+using Ticket = uint64_t;
+
+// submits compute batches to the compute family beside the graphics
+// queue, compute batches signal one timeline and graphics frames another
+// so each side waits on the other on the gpu, resources both sides touch
+// need concurrent sharing, see Device::createStorageBuffer()
+class Scheduler {
+  private:
+    // one batch per frame in flight
+    struct Slot {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        Ticket ticket = 0;
+    };
+
+    vbr::device::Device &m_device;
+    VkQueue m_queue = VK_NULL_HANDLE;
+    uint32_t m_family = 0;
+    uint32_t m_graphics_family = 0;
+    std::vector<Slot> m_slots;
+    // slot being recorded, none when out of range
+    uint32_t m_recording = UINT32_MAX;
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    VkSemaphore m_graphics_timeline = VK_NULL_HANDLE;
+    Ticket m_next = 1;
+    Ticket m_submitted = 0;
+    // value the next graphics frame signals
+    uint64_t m_graphics_next = 1;
+    // batch the next graphics frame waits on, and where
+    Ticket m_consume = 0;
+    VkPipelineStageFlags m_consume_stages = 0;
+
+  private:
+    bool initSlots(uint32_t count);
+    void destroySlots();
+    VkSemaphore createTimeline();
+
+  public:
+    Scheduler(vbr::device::Device &device);
+    ~Scheduler();
+
+    bool init(uint32_t family, VkQueue queue, uint32_t graphics_family,
+              uint32_t frames);
+    // recreate the batches, the device must be idle
+    bool frames(uint32_t count);
+
+    // start the batch of frame, null on failure
+    VkCommandBuffer begin(uint32_t frame);
+    // submit the batch, it starts once the graphics frame with value
+    // after is done at the compute stage, 0 waits on nothing
+    Ticket submit(uint64_t after = 0);
+    // the next graphics frame waits on ticket at stages
+    void consume(Ticket ticket, VkPipelineStageFlags stages);
+    bool done(Ticket ticket);
+    void wait(Ticket ticket);
+
+    // for the graphics submit, the wait is cleared once read
+    Ticket takeConsume(VkPipelineStageFlags &stages);
+    // value the graphics frame being recorded signals, the previous
+    // frame's is one less
+    uint64_t graphicsValue() const { return m_graphics_next; }
+    void graphicsSubmitted() { m_graphics_next++; }
+
+    VkSemaphore &timeline() { return m_timeline; }
+    VkSemaphore &graphicsTimeline() { return m_graphics_timeline; }
+    // compute has its own family, batches may overlap graphics
+    bool async() const { return m_family != m_graphics_family; }
+    uint32_t family() const { return m_family; }
+
+    Scheduler(Scheduler &) = delete;
+    Scheduler(Scheduler &&) = delete;
+    Scheduler &operator=(Scheduler &) = delete;
+    Scheduler &operator=(Scheduler &&) = delete;
+};
+
+} // namespace vbr::acompute
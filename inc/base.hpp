@@ -8,17 +8,40 @@
 #include "vulkan/vulkan_core.h"
 #include <SDL3/SDL_init.h>
 #include <SDL3/SDL_video.h>
+#include <array>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 
 namespace vbr::gpipeline {
 class Pipeline;
 }
 
+namespace vbr::cpipeline {
+class Pipeline;
+}
+
+namespace vbr::draw {
+class Queue;
+}
+
 namespace vbr::app {
 
+// vertex bindings tracked for redundant binds, the minimum
+// maxVertexInputBindings
+constexpr uint32_t max_vertex_bindings = 16;
+// dynamic offsets of a set tracked for redundant binds, sets with more
+// are always bound
+constexpr uint32_t max_dynamic_offsets = 8;
+
 class App {
   protected:
     bool m_debug = true;
+    // no window and swapchain, render into device offscreen targets
+    bool m_headless = false;
     glm::ivec2 m_window_size;
     struct WindowDeleter {
         void operator()(SDL_Window *window) {
@@ -30,40 +53,168 @@ class App {
     };
     std::unique_ptr<SDL_Window, WindowDeleter> m_window;
     bool m_quit = false;
+    // frames recorded by cpu while gpu still works on previous ones
+    uint32_t m_frames_in_flight = 2;
+    // device pipeline cache file, set before init, empty disables it
+    std::string m_pipeline_cache_path = "pipeline_cache.bin";
 
     // vulkan things
-    VkInstance m_vk_instance;
-    VkDebugUtilsMessengerEXT m_vk_dbg_messager;
-    VkSurfaceKHR m_vk_surface;
+    VkInstance m_vk_instance = VK_NULL_HANDLE;
+    VkDebugUtilsMessengerEXT m_vk_dbg_messager = VK_NULL_HANDLE;
+    VkSurfaceKHR m_vk_surface = VK_NULL_HANDLE;
     std::unique_ptr<vbr::device::Device> m_vk_device;
     std::unique_ptr<vbr::swapchain::Swapchain> m_vk_swapchain;
 
   protected:
-    bool begin(float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 0.0f);
+    // frame with one cleared pass on the render target, pass
+    // VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT to draw it with
+    // recordParallel() only
+    bool begin(float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 0.0f,
+               VkRenderingFlags flags = 0);
     bool end();
+    // bare frame, the caller records its own rendering and leaves the
+    // target ready for present, or transfer source when headless
+    bool beginFrame();
+    bool endFrame();
+    // the pass of begin() and end() on its own, for work recorded outside
+    // rendering such as dispatches between beginFrame() and the pass
+    void beginRendering(float r = 0.0f, float g = 0.0f, float b = 0.0f,
+                        float a = 0.0f, VkRenderingFlags flags = 0);
+    void endRendering();
+    // depth attachment of the following beginRendering() passes, cleared
+    // to clear, the caller keeps it in depth stencil attachment optimal
+    // layout while they run, a null view removes it, format is the view's
+    // and is inherited by recordParallel()
+    void depthAttachment(VkImageView view, VkFormat format,
+                         float clear = 1.0f) {
+        m_depth_view = view;
+        m_depth_format = format;
+        m_depth_clear = clear;
+    }
+    VkCommandBuffer &commandBuffer() { return m_vk_device->cmd(); }
+    // current render target, swapchain image or offscreen target
+    VkImage &targetImage();
+    VkImageView &targetView();
+    // what the target may be used for beyond rendering, e.g. blits
+    VkImageUsageFlags targetUsage() const;
     void setViewport(float w = 0.0f, float h = 0.0f, float x = 0.0f,
                      float y = 0.0f, float min = 0.0f, float max = 1.0f);
     void setScissor(uint32_t w = 0, uint32_t h = 0, int32_t x = 0,
                     int32_t y = 0);
-    void bindPipeline(vbr::gpipeline::Pipeline &pipeline);
-    void bindVertex(vbr::buffer::Buffer &buffer);
-    void draw(uint32_t count);
+    // false when neither the pipeline nor its fallback is ready
+    bool bindPipeline(vbr::gpipeline::Pipeline &pipeline);
+    // compute, dispatches must be recorded outside rendering
+    bool bindPipeline(vbr::cpipeline::Pipeline &pipeline);
+    void dispatch(uint32_t x, uint32_t y = 1, uint32_t z = 1);
+    // VkDispatchIndirectCommand at offset
+    void dispatchIndirect(vbr::buffer::Buffer &buffer,
+                          VkDeviceSize offset = 0);
+    void bindVertex(vbr::buffer::Buffer &buffer, uint32_t binding = 0,
+                    VkDeviceSize offset = 0);
+    // consecutive bindings from first, offsets default to 0
+    void bindVertex(uint32_t first, std::span<const VkBuffer> buffers,
+                    std::span<const VkDeviceSize> offsets = {});
+    void draw(uint32_t count, uint32_t instances = 1, uint32_t first = 0,
+              uint32_t first_instance = 0);
     void bindIndex(vbr::buffer::Buffer &buffer);
-    void drawIndex(uint32_t count);
+    void drawIndex(uint32_t count, uint32_t instances = 1, uint32_t first = 0,
+                   int32_t vertex_offset = 0, uint32_t first_instance = 0);
+    // commands [first, first + draws) of an indirect buffer in one call,
+    // one call per command without multiDrawIndirect
+    void drawIndexedIndirect(vbr::indirect::Buffer &buffer, uint32_t draws,
+                             uint32_t first = 0);
+    // draw count read by the gpu from the buffer, clamped to max_draws and
+    // the capacity, false without drawIndirectCount
+    bool drawIndexedIndirectCount(vbr::indirect::Buffer &buffer,
+                                  uint32_t max_draws = UINT32_MAX);
+    // items [0, count) recorded by job on the workers into secondary
+    // command buffers of the current pass
+    bool recordParallel(uint32_t count, const vbr::record::Job &job,
+                        uint32_t min_chunk = 1024);
+    // one offset per dynamic binding of the set, in binding order
     void bindDescriptorSet(const VkDescriptorSet &set,
-                           const VkPipelineLayout &layout);
+                           const VkPipelineLayout &layout,
+                           const std::vector<uint32_t> &dynamic_offsets = {},
+                           VkPipelineBindPoint point =
+                               VK_PIPELINE_BIND_POINT_GRAPHICS);
     void pushConstant(VkPipelineLayout &layout, VkShaderStageFlags stage,
                       uint32_t offset, uint32_t size, void *data);
+    // sort the queue and record its draws, state shared by neighbours is
+    // bound once
+    void submit(vbr::draw::Queue &queue);
+    // index of the frame being recorded, in [0, framesInFlight())
+    uint32_t frameIndex() const;
+    uint32_t framesInFlight() const { return m_frames_in_flight; }
+    bool framesInFlight(uint32_t count);
+    // frames per second over the last second
+    float fps() const { return m_fps; }
+    // forget the tracked state after raw vkCmd* calls on commandBuffer()
+    void invalidateState() { m_bound = {}; }
+    // binds and dynamic state sets of the last frame, and how many of
+    // them were skipped as already current
+    uint32_t stateCalls() const { return m_state_calls; }
+    uint32_t elidedStateCalls() const { return m_elided_state_calls; }
+    // log the rolling gpu time of the frame, passes and uploads
+    void reportProfile() const;
+    // count vertices, primitives and shader invocations of every draw and
+    // dispatch recorded through App into the bound pipeline's statistics(),
+    // from the next frame on, draws of recordParallel() are not counted
+    void pipelineStatistics(bool on) {
+        m_vk_device->pipelineStats().enable(on);
+    }
+
+  private:
+    // state bound in the current pass, redundant binds are skipped
+    struct Bound {
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipeline compute = VK_NULL_HANDLE;
+        // statistics of the pipelines above, a fallback counts for itself
+        vbr::pstats::Counters *pipeline_counters = nullptr;
+        vbr::pstats::Counters *compute_counters = nullptr;
+        std::array<VkBuffer, max_vertex_bindings> vertex{};
+        std::array<VkDeviceSize, max_vertex_bindings> vertex_offsets{};
+        VkBuffer index = VK_NULL_HANDLE;
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        std::array<uint32_t, max_dynamic_offsets> dynamic_offsets{};
+        uint32_t dynamic_offset_count = 0;
+        std::optional<VkViewport> viewport;
+        std::optional<VkRect2D> scissor;
+    };
+    Bound m_bound;
+    VkImageView m_depth_view = VK_NULL_HANDLE;
+    VkFormat m_depth_format = VK_FORMAT_UNDEFINED;
+    float m_depth_clear = 1.0f;
+    // open gpu timestamp scopes of the frame and of beginRendering()
+    uint32_t m_frame_scope = vbr::profile::invalid_scope;
+    uint32_t m_pass_scope = vbr::profile::invalid_scope;
+    uint32_t m_state_calls = 0;
+    uint32_t m_elided_state_calls = 0;
+    uint32_t m_frame_state_calls = 0;
+    uint32_t m_frame_elided_state_calls = 0;
+    // throughput counter
+    std::chrono::steady_clock::time_point m_fps_start;
+    uint32_t m_fps_frames = 0;
+    float m_fps = 0.0f;
+    // last upload batch submitted before this frame, the frame waits on it
+    vbr::upload::Ticket m_upload_ticket = 0;
 
   private:
     // internal function for sdl
     void updateWindowSize();
+    void countFrame();
+    // count a state call, true when it is already current
+    bool elide(bool current);
+    // pipeline statistics query around one draw or dispatch
+    uint32_t beginQuery(vbr::pstats::Counters *counters);
+    void endQuery(uint32_t query);
+    VkImageView targetColorView();
     // internal function for vulkan init
     [[nodiscard]] bool initInstance();
     [[nodiscard]] bool initSurface();
 
   public:
-    App(const glm::ivec2 &window_size = {1024, 980});
+    App(const glm::ivec2 &window_size = {1024, 980}, bool headless = false);
     virtual ~App();
 
     bool shouldQuit() const { return m_quit; }
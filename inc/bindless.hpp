@@ -0,0 +1,82 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace vbr::bindless {
+
+// kind of a slot, also its binding in the set
+enum class Kind : uint32_t {
+    image = 0,
+    sampler = 1,
+    buffer = 2,
+};
+
+constexpr uint32_t invalid_index = UINT32_MAX;
+
+// one update after bind set with arrays of every sampled image, sampler and
+// storage buffer, bound once per pipeline layout while draws pick resources
+// by index, e.g. through push constants:
+//   layout(set = 0, binding = 0) uniform texture2D images[];
+//   layout(set = 0, binding = 1) uniform sampler samplers[];
+//   layout(set = 0, binding = 2) readonly buffer Data { ... } buffers[];
+class Table {
+  private:
+    struct Slots {
+        uint32_t capacity = 0;
+        // slots past this one were never handed out
+        uint32_t next = 0;
+        std::vector<uint32_t> free;
+        // slots handed out and not released yet
+        std::vector<bool> live;
+    };
+
+    VkDevice &m_device;
+    VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+    std::array<Slots, 3> m_slots;
+    // textures may load on worker threads, writes to the set need the lock
+    std::mutex m_mutex;
+
+  private:
+    // free slot of that kind, invalid_index when full
+    uint32_t take(Kind kind);
+    void write(Kind kind, uint32_t index, const VkDescriptorImageInfo *image,
+               const VkDescriptorBufferInfo *buffer);
+
+  public:
+    Table(VkDevice &device);
+    ~Table();
+
+    // capacities must fit the device update after bind limits
+    bool init(uint32_t images, uint32_t samplers, uint32_t buffers);
+    void destroy();
+
+    // slot index for shaders, invalid_index when the table is full
+    uint32_t
+    addImage(VkImageView view,
+             VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t addSampler(VkSampler sampler);
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset = 0,
+                       VkDeviceSize range = VK_WHOLE_SIZE);
+    // the gpu must be done with the slot, it is reused by the next add,
+    // a slot that is not live is rejected
+    void release(Kind kind, uint32_t index);
+
+    uint32_t capacity(Kind kind) const {
+        return m_slots[static_cast<uint32_t>(kind)].capacity;
+    }
+    VkDescriptorSetLayout layout() const { return m_layout; }
+    VkDescriptorSet operator*() const { return m_set; }
+
+    Table(Table &) = delete;
+    Table(Table &&) = delete;
+    Table &operator=(Table &) = delete;
+    Table &operator=(Table &&) = delete;
+};
+
+} // namespace vbr::bindless
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "allocator.hpp"
+#include "bindless.hpp"
 #include "vulkan/vulkan_core.h"
 #include <vulkan/vulkan.h>
 
@@ -8,15 +10,22 @@ class Device;
 
 }
 
+namespace vbr::upload {
+class Uploader;
+}
+
 namespace vbr::buffer {
 
 struct Buffer {
     friend class vbr::device::Device;
+    friend class vbr::upload::Uploader;
 
     VkBuffer buffer = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    vbr::allocator::Allocation allocation;
     void *data = nullptr; // mapped data
     VkDeviceSize size;
+    // storage buffer slot in the device bindless table
+    uint32_t index = vbr::bindless::invalid_index;
 
     Buffer(vbr::device::Device &d);
     ~Buffer();
@@ -25,7 +34,9 @@ struct Buffer {
     vbr::device::Device &device;
 
   private:
-    void bind(VkDeviceSize offset = 0);
+    void bind();
+    // release without waiting the device, caller knows the gpu is done
+    void destroy();
     void *map(VkDeviceSize size);
     void unmap();
     void copyFrom(const Buffer &src, VkDeviceSize size);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "device.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace vbr::cpipeline {
+
+// compute counterpart of gpipeline::Pipeline, one shader and the
+// specialization constants it is built with
+class Pipeline {
+  public:
+    enum class State { empty, building, ready, failed };
+
+  private:
+    vbr::device::Device &m_device;
+    VkPipeline m_pipeline = VK_NULL_HANDLE;
+    // written by the building thread, m_pipeline is valid once ready
+    std::atomic<State> m_state = State::empty;
+    std::mutex m_build_mutex;
+    std::condition_variable m_build_cv;
+
+    std::string m_path;
+    std::string m_name = "main";
+    // shared module held while the pipeline lives
+    VkShaderModule m_module = VK_NULL_HANDLE;
+    // constant values packed back to back, entries point into them
+    std::vector<VkSpecializationMapEntry> m_constant_entries;
+    std::vector<uint8_t> m_constant_data;
+    // dispatches measured while pipeline statistics are enabled
+    vbr::pstats::Counters m_statistics;
+
+  private:
+    void releaseShaderModule();
+    // load the shader and create the pipeline, safe to run on a worker
+    bool build(VkPipelineLayout layout);
+    void finish(bool ret);
+
+  public:
+    Pipeline(vbr::device::Device &device);
+    ~Pipeline();
+
+    bool init(VkPipelineLayout &layout);
+    // build on the device worker pool, the pipeline must not be changed
+    // until ready() or failed()
+    void initAsync(VkPipelineLayout layout);
+    // block until a pending build is done
+    bool wait();
+    State state() const { return m_state.load(std::memory_order_acquire); }
+    bool ready() const { return state() == State::ready; }
+    bool failed() const { return state() == State::failed; }
+
+    void setShader(std::string_view shader_path,
+                   std::string_view name = "main");
+    // value of constant_id in the shader, e.g. local_size_x_id
+    template <typename T> void addConstant(uint32_t id, const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        m_constant_entries.push_back({
+            .constantID = id,
+            .offset = static_cast<uint32_t>(m_constant_data.size()),
+            .size = sizeof(T),
+        });
+        m_constant_data.resize(m_constant_data.size() + sizeof(T));
+        memcpy(m_constant_data.data() + m_constant_entries.back().offset,
+               &value, sizeof(T));
+    }
+
+    // totals of the dispatches recorded with it through app::App
+    vbr::pstats::Counters &statistics() { return m_statistics; }
+    const vbr::pstats::Counters &statistics() const { return m_statistics; }
+
+    // null until ready
+    VkPipeline operator*() { return ready() ? m_pipeline : VK_NULL_HANDLE; }
+
+    Pipeline(Pipeline &) = delete;
+    Pipeline(Pipeline &&) = delete;
+    Pipeline &operator=(Pipeline &) = delete;
+    Pipeline &operator=(Pipeline &&) = delete;
+};
+
+} // namespace vbr::cpipeline
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <vector>
 
 namespace vbr::buffer {
@@ -12,20 +16,157 @@ class Texture;
 
 }
 
+namespace vbr::layout {
+class Cache;
+}
+
 namespace vbr::descriptor {
 
+// descriptors per set of each type in a new pool
+struct PoolRatio {
+    VkDescriptorType type;
+    float ratio;
+};
+
+// hands out sets from a list of pools, a new pool is created whenever the
+// current one runs out
+class Allocator {
+  public:
+    static constexpr uint32_t max_sets_per_pool = 4096;
+
+  private:
+    VkDevice &m_device;
+    // sets can be freed one by one, otherwise only reset() returns them
+    bool m_freeable;
+    // size of the next pool, doubles with every new pool
+    uint32_t m_sets_per_pool;
+    std::vector<PoolRatio> m_ratios;
+    VkDescriptorPool m_current = VK_NULL_HANDLE;
+    // pools that ran out, reused after reset or free
+    std::vector<VkDescriptorPool> m_full;
+    // empty pools waiting for use
+    std::vector<VkDescriptorPool> m_ready;
+
+  private:
+    VkDescriptorPool grab();
+
+  public:
+    Allocator(VkDevice &device, bool freeable = false,
+              uint32_t sets_per_pool = 64,
+              std::vector<PoolRatio> ratios = {
+                  {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+                  {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+                  {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+                  {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2.0f},
+                  {VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f},
+                  {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+                  {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+              });
+    ~Allocator();
+
+    // null on failure, pool receives the owning pool for free()
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout,
+                             VkDescriptorPool *pool = nullptr);
+    // only for freeable allocators
+    void free(VkDescriptorPool pool, VkDescriptorSet set);
+    // return every set at once, e.g. a transient allocator per frame
+    void reset();
+    void destroy();
+
+    uint32_t poolCount() const {
+        return static_cast<uint32_t>(m_full.size() + m_ready.size()) +
+               (m_current != VK_NULL_HANDLE ? 1 : 0);
+    }
+
+    Allocator(Allocator &) = delete;
+    Allocator(Allocator &&) = delete;
+    Allocator &operator=(Allocator &) = delete;
+    Allocator &operator=(Allocator &&) = delete;
+};
+
+// queues set writes and applies them with one vkUpdateDescriptorSets
+class Writer {
+  private:
+    VkDevice &m_device;
+    std::vector<VkWriteDescriptorSet> m_writes;
+    // deque keeps the infos in place while writes point at them
+    std::deque<VkDescriptorBufferInfo> m_buffer_infos;
+    std::deque<VkDescriptorImageInfo> m_image_infos;
+
+  public:
+    Writer(VkDevice &device);
+
+    void writeBuffer(VkDescriptorSet set, uint32_t binding,
+                     const VkDescriptorBufferInfo &info, VkDescriptorType type,
+                     uint32_t element = 0);
+    void writeImage(VkDescriptorSet set, uint32_t binding,
+                    const VkDescriptorImageInfo &info, VkDescriptorType type,
+                    uint32_t element = 0);
+    // apply and drop every queued write, returns how many
+    uint32_t flush();
+    void clear();
+
+    size_t size() const { return m_writes.size(); }
+
+    Writer(Writer &) = delete;
+    Writer(Writer &&) = delete;
+    Writer &operator=(Writer &) = delete;
+    Writer &operator=(Writer &&) = delete;
+};
+
+// writes a whole set from one struct of descriptor infos with a single
+// vkUpdateDescriptorSetWithTemplate call
+class Template {
+  private:
+    VkDevice &m_device;
+    VkDescriptorUpdateTemplate m_template = VK_NULL_HANDLE;
+    std::vector<VkDescriptorUpdateTemplateEntry> m_entries;
+
+  public:
+    Template(VkDevice &device);
+    ~Template();
+
+    // offset of the first info in the struct, stride 0 picks the size of
+    // the info matching type
+    void addEntry(uint32_t binding, VkDescriptorType type, size_t offset,
+                  uint32_t count = 1, size_t stride = 0,
+                  uint32_t element = 0);
+    // layout of the sets to update, entries must be added before
+    bool init(VkDescriptorSetLayout layout);
+    void destroy();
+    void update(VkDescriptorSet set, const void *data);
+
+    VkDescriptorUpdateTemplate operator*() const { return m_template; }
+
+    Template(Template &) = delete;
+    Template(Template &&) = delete;
+    Template &operator=(Template &) = delete;
+    Template &operator=(Template &&) = delete;
+};
+
 class Descriptor {
   private:
     VkDevice &m_device;
+    // shared allocator, the descriptor owns a pool when it is null
+    Allocator *m_allocator;
+    // shared set layouts, the descriptor owns its layout when it is null
+    vbr::layout::Cache *m_cache;
     VkDescriptorSetLayout m_descriptor_layout = VK_NULL_HANDLE;
     VkDescriptorPool m_descriptor_pool = VK_NULL_HANDLE;
-    VkDescriptorSet m_descriptor_set = VK_NULL_HANDLE;
+    // one set per maxSet(), with their owning pools
+    std::vector<VkDescriptorSet> m_descriptor_sets;
+    std::vector<VkDescriptorPool> m_set_pools;
     uint32_t m_max_set = 1;
     std::vector<VkDescriptorPoolSize> m_pool_size;
     std::vector<VkDescriptorSetLayoutBinding> m_descriptor_bindings;
 
+  private:
+    bool initLayout();
+    bool initPool();
+
   public:
-    Descriptor(VkDevice &device);
+    Descriptor(VkDevice &device, Allocator *allocator = nullptr,
+               vbr::layout::Cache *cache = nullptr);
     ~Descriptor();
 
     bool init();
@@ -35,14 +176,32 @@ class Descriptor {
                          uint32_t count = 1,
                          const VkSampler *sampler = nullptr);
     void updateBuffer(const vbr::buffer::Buffer &buffer, uint32_t dst_binding,
-                      uint32_t dst_array_element, VkDescriptorType type);
+                      uint32_t dst_array_element, VkDescriptorType type,
+                      uint32_t index = 0);
     void updateTexture(vbr::image::Texture &texture, uint32_t dst_binding,
-                       uint32_t dst_array_element);
+                       uint32_t dst_array_element, uint32_t index = 0);
+    // any buffer range, e.g. the uniform ring with a dynamic type
+    void updateBuffer(const VkDescriptorBufferInfo &info, uint32_t dst_binding,
+                      uint32_t dst_array_element, VkDescriptorType type,
+                      uint32_t index = 0);
+    // storage image in VK_IMAGE_LAYOUT_GENERAL, written by compute
+    void updateStorageImage(VkImageView view, uint32_t dst_binding,
+                            uint32_t dst_array_element, uint32_t index = 0);
+    // queue the write instead, applied by writer.flush()
+    void updateBuffer(Writer &writer, const vbr::buffer::Buffer &buffer,
+                      uint32_t dst_binding, uint32_t dst_array_element,
+                      VkDescriptorType type, uint32_t index = 0);
+    void updateTexture(Writer &writer, vbr::image::Texture &texture,
+                       uint32_t dst_binding, uint32_t dst_array_element,
+                       uint32_t index = 0);
 
     VkDescriptorSetLayout &operator*() { return m_descriptor_layout; }
-    VkDescriptorSet &set() { return m_descriptor_set; }
+    VkDescriptorSet &set(uint32_t index = 0) {
+        return m_descriptor_sets[index];
+    }
 
-    void maxSet(uint32_t v) { m_max_set = v; }
+    // number of sets with this layout, must be set before init
+    void maxSet(uint32_t v) { m_max_set = std::max(v, 1u); }
     uint32_t maxSet() const { return m_max_set; }
     Descriptor(Descriptor &) = delete;
     Descriptor(Descriptor &&) = delete;
@@ -1,13 +1,28 @@
 #pragma once
 
+#include "allocator.hpp"
+#include "async_compute.hpp"
+#include "bindless.hpp"
 #include "buffer.hpp"
+#include "descriptor.hpp"
 #include "glm/glm.hpp"
 #include "image.hpp"
+#include "indirect.hpp"
+#include "layout.hpp"
+#include "pipeline_cache.hpp"
+#include "pipeline_stats.hpp"
+#include "profiler.hpp"
+#include "record.hpp"
+#include "shader_cache.hpp"
 #include "spdlog/spdlog.h"
+#include "uniform_ring.hpp"
+#include "upload.hpp"
+#include "worker.hpp"
 #include "util.hpp"
 #include "vulkan/vulkan_core.h"
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -33,14 +48,34 @@ struct Queues {
     VkQueue compute;
 };
 
-struct SyncObjs {
+// per frame in flight objects, render done semaphores live in swapchain
+// because they are keyed by swapchain image
+struct FrameObjs {
+    VkCommandPool cmd_pool = VK_NULL_HANDLE;
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
     VkSemaphore image_available = VK_NULL_HANDLE;
-    VkSemaphore render_done = VK_NULL_HANDLE;
     VkFence in_flight_fence = VK_NULL_HANDLE;
+    // transient sets, reset once the frame is done on the gpu
+    std::unique_ptr<vbr::descriptor::Allocator> descriptors;
 
     void destroy(const VkDevice device);
 };
 
+class Device;
+
+// usage of the offscreen targets, always read back and blit targets
+constexpr VkImageUsageFlags offscreen_usage =
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+    VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+// offscreen color target, replaces swapchain images in headless mode
+struct Target {
+    std::unique_ptr<vbr::image::Image> image;
+    vbr::allocator::Allocation allocation;
+
+    void destroy(Device &device);
+};
+
 class Device {
     friend class vbr::app::App;
     friend class vbr::swapchain::Swapchain;
@@ -51,60 +86,147 @@ class Device {
     vbr::util::GPUInfo m_vk_phy_info;
     VkPhysicalDevice m_vk_phy_device;
     vbr::util::QueueFamilyIndices m_vk_queue_indices;
-    VkDevice m_vk_device;
+    VkDevice m_vk_device = VK_NULL_HANDLE;
     Queues m_vk_queues;
-    VkCommandPool m_vk_cmd_pool;
-    VkCommandBuffer m_vk_cmd;
-    SyncObjs m_vk_sync;
+    // sub allocator every buffer and image draws memory from
+    std::unique_ptr<vbr::allocator::Allocator> m_allocator;
+    // shared by all pipelines, saved at shutdown
+    std::unique_ptr<vbr::pcache::PipelineCache> m_pipeline_cache;
+    // read by init() and written back at shutdown, empty disables the file
+    std::string m_pipeline_cache_path;
+    // spir-v modules shared by pipelines
+    std::unique_ptr<vbr::shader::ShaderCache> m_shader_cache;
+    // background jobs such as pipeline builds
+    std::unique_ptr<vbr::worker::Pool> m_workers;
+    // long lived sets, freed one by one
+    std::unique_ptr<vbr::descriptor::Allocator> m_descriptor_allocator;
+    // set and pipeline layouts shared by equal signatures
+    std::unique_ptr<vbr::layout::Cache> m_layout_cache;
+    // every texture and storage buffer by index, null without descriptor
+    // indexing support
+    std::unique_ptr<vbr::bindless::Table> m_bindless;
+    bool m_descriptor_indexing = false;
+    // optional indirect draw features
+    bool m_multi_draw_indirect = false;
+    bool m_draw_indirect_count = false;
+    // indirect commands may set firstInstance
+    bool m_draw_indirect_first_instance = false;
+    // async staging copies on the transfer queue
+    std::unique_ptr<vbr::upload::Uploader> m_uploader;
+    // per draw uniforms, recycled with the frames in flight
+    std::unique_ptr<vbr::uniform::Ring> m_uniform_ring;
+    // pool for temporary commands
+    VkCommandPool m_vk_cmd_pool = VK_NULL_HANDLE;
+    // frames in flight ring
+    std::vector<FrameObjs> m_vk_frames;
+    // secondary command buffers recorded on the workers
+    std::unique_ptr<vbr::record::Recorder> m_recorder;
+    // compute batches on the compute family, overlapping graphics
+    std::unique_ptr<vbr::acompute::Scheduler> m_async_compute;
+    // gpu timestamps of the graphics queue, one slot per frame in flight
+    std::unique_ptr<vbr::profile::Profiler> m_profiler;
+    // opt-in draw and dispatch counters of the graphics queue
+    std::unique_ptr<vbr::pstats::Collector> m_pipeline_stats;
+    bool m_host_query_reset = false;
+    bool m_pipeline_statistics = false;
+    uint32_t m_frames_in_flight = 2;
+    uint32_t m_current_frame = 0;
+    // headless targets, one per frame in flight
+    std::vector<Target> m_offscreen_targets;
+    Target m_offscreen_color;
+    glm::ivec2 m_offscreen_size{0, 0};
     // sample count
     VkSampleCountFlagBits m_sample_count = VK_SAMPLE_COUNT_1_BIT;
 
   private:
+    [[nodiscard]] bool querySurface();
     [[nodiscard]] bool pickupPhyDevice(const VkInstance &instance);
+    // first family with all of flags and none of excluded
+    std::optional<uint32_t> findQueueFamily(VkQueueFlags flags,
+                                            VkQueueFlags excluded);
+    [[nodiscard]] bool pickupQueues();
     [[nodiscard]] bool initLogicDevice();
+    [[nodiscard]] bool initBindless();
+    [[nodiscard]] bool initUniformRing();
     [[nodiscard]] bool initCmds();
-    [[nodiscard]] bool initSync();
+    [[nodiscard]] bool initFrames();
+    void destroyFrames();
+    [[nodiscard]] bool initOffscreen(const glm::ivec2 &size);
+    void destroyOffscreen();
 
-    VkFence &inFlightFence() { return m_vk_sync.in_flight_fence; }
-    VkSemaphore &imageAvailable() { return m_vk_sync.image_available; }
-    VkSemaphore &renderDone() { return m_vk_sync.render_done; }
-    VkCommandBuffer &cmd() { return m_vk_cmd; }
+    VkFence &inFlightFence() {
+        return m_vk_frames[m_current_frame].in_flight_fence;
+    }
+    VkSemaphore &imageAvailable() {
+        return m_vk_frames[m_current_frame].image_available;
+    }
+    VkCommandPool &cmdPool() { return m_vk_frames[m_current_frame].cmd_pool; }
+    VkCommandBuffer &cmd() { return m_vk_frames[m_current_frame].cmd; }
+    void nextFrame() {
+        m_current_frame = (m_current_frame + 1) % m_frames_in_flight;
+    }
+    VkImage &offscreenImage() {
+        return m_offscreen_targets[m_current_frame].image->image;
+    }
+    VkImageView &offscreenView() {
+        return m_offscreen_targets[m_current_frame].image->view;
+    }
+    VkImageView offscreenColorView() {
+        return m_offscreen_color.image ? m_offscreen_color.image->view
+                                       : VK_NULL_HANDLE;
+    }
     void updateWindowSize();
 
   private:
-    uint32_t findMemoryType(uint32_t type_filter,
-                            VkMemoryPropertyFlags properties);
+    // concurrent sharing across families when more than one is given
     std::unique_ptr<vbr::buffer::Buffer>
     createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
-                 VkMemoryPropertyFlags properties);
+                 VkMemoryPropertyFlags properties,
+                 const std::vector<uint32_t> &families = {});
     bool internalCreateSampleImage(uint32_t w, uint32_t h, VkFormat format,
                                    VkImageTiling tilling,
                                    VkImageUsageFlags usage,
                                    VkMemoryPropertyFlags properties,
-                                   VkImage &image, VkDeviceMemory &memory);
+                                   VkImage &image,
+                                   vbr::allocator::Allocation &allocation);
     bool internalCreateImage(uint32_t w, uint32_t h, VkFormat format,
                              VkImageTiling tilling, VkImageUsageFlags usage,
                              VkMemoryPropertyFlags properties, VkImage &image,
-                             VkDeviceMemory &memory);
-    void transitionImageLayout(VkImage &image, VkImageLayout old_layout,
-                               VkImageLayout new_layout);
+                             vbr::allocator::Allocation &allocation);
 
   public:
     Device(VkSurfaceKHR &surface,
            VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT,
-           bool debug = false);
+           bool debug = false, uint32_t frames_in_flight = 2,
+           std::string_view pipeline_cache_path = "pipeline_cache.bin");
     ~Device();
 
     bool init(const VkInstance &instance);
+    // no surface given, render into offscreen targets
+    bool headless() const { return m_vk_surface == VK_NULL_HANDLE; }
     VkDevice &operator*() { return m_vk_device; }
     VkQueue &graphicsQueue() { return m_vk_queues.graphics; }
     VkQueue &presentQueue() { return m_vk_queues.present; }
     VkQueue &transferQueue() { return m_vk_queues.transfer; }
     VkQueue &computeQueue() { return m_vk_queues.compute; }
+    const vbr::util::QueueFamilyIndices &queueFamilies() const {
+        return m_vk_queue_indices;
+    }
     const VkPhysicalDeviceProperties &propreties() const {
         return m_vk_phy_info.properties;
     }
+    const VkQueueFamilyProperties &
+    queueFamilyProperties(uint32_t family) const {
+        return m_vk_phy_info.queue_family_properties[family];
+    }
+    // queries may be reset with vkResetQueryPool
+    bool hostQueryReset() const { return m_host_query_reset; }
+    bool pipelineStatisticsQuery() const { return m_pipeline_statistics; }
     VkSampleCountFlagBits sampleCount() const { return m_sample_count; }
+    uint32_t frameIndex() const { return m_current_frame; }
+    uint32_t framesInFlight() const { return m_frames_in_flight; }
+    // recreate the frame ring, wait all in flight frames done
+    bool framesInFlight(uint32_t count);
     void sampleCount(VkSampleCountFlagBits flag) {
         VkSampleCountFlags max_counts =
             m_vk_phy_info.properties.limits.framebufferColorSampleCounts;
@@ -117,16 +239,47 @@ class Device {
         m_sample_count = VK_SAMPLE_COUNT_1_BIT;
     }
 
+    uint32_t findMemoryType(uint32_t type_filter,
+                            VkMemoryPropertyFlags properties);
+    // linear is false only for optimal tiling images
+    bool allocateMemory(const VkMemoryRequirements &requirements,
+                        VkMemoryPropertyFlags properties, bool linear,
+                        vbr::allocator::Allocation &allocation);
+    void freeMemory(vbr::allocator::Allocation &allocation);
+    vbr::allocator::Allocator &allocator() { return *m_allocator; }
+    vbr::upload::Uploader &uploader() { return *m_uploader; }
+    vbr::uniform::Ring &uniformRing() { return *m_uniform_ring; }
+    vbr::pcache::PipelineCache &pipelineCache() { return *m_pipeline_cache; }
+    vbr::worker::Pool &workers() { return *m_workers; }
+    vbr::record::Recorder &recorder() { return *m_recorder; }
+    vbr::acompute::Scheduler &asyncCompute() { return *m_async_compute; }
+    vbr::profile::Profiler &profiler() { return *m_profiler; }
+    vbr::pstats::Collector &pipelineStats() { return *m_pipeline_stats; }
+    vbr::shader::ShaderCache &shaders() { return *m_shader_cache; }
+    vbr::layout::Cache &layouts() { return *m_layout_cache; }
+    // null when the device lacks descriptor indexing
+    vbr::bindless::Table *bindless() { return m_bindless.get(); }
+    vbr::descriptor::Allocator &descriptorAllocator() {
+        return *m_descriptor_allocator;
+    }
+    // sets valid until this frame slot comes around again
+    vbr::descriptor::Allocator &frameDescriptors() {
+        return *m_vk_frames[m_current_frame].descriptors;
+    }
+
     VkCommandBuffer beginTemporaryCommand();
     void endTemporaryCommand(VkCommandBuffer &cmd);
 
     VkFormat format() const { return m_vk_phy_info.surface_format.format; }
 
-    // for vertex & index buffer
+    // for vertex & index buffer, the copy is queued on the uploader and
+    // the buffer is usable by frames begun after it, ticket is for callers
+    // that need to wait on it themselves, storage buffers also get a
+    // bindless index
     template <typename T>
     std::unique_ptr<vbr::buffer::Buffer>
-    createUsageBuffer(const std::vector<T> &datas,
-                      VkBufferUsageFlagBits usage) {
+    createUsageBuffer(const std::vector<T> &datas, VkBufferUsageFlagBits usage,
+                      vbr::upload::Ticket *ticket = nullptr) {
         VkDeviceSize total_size = sizeof(T) * datas.size();
         auto stage = createBuffer(total_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
@@ -144,13 +297,19 @@ class Device {
             createBuffer(total_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         if (ret) {
-            ret->cutFrom(*stage, total_size);
-            stage.reset();
+            auto t = m_uploader->copyBuffer(std::move(stage), *ret, total_size);
+            if (ticket) {
+                *ticket = t;
+            }
             ret->size = sizeof(T);
+            if (m_bindless && (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) {
+                ret->index = m_bindless->addBuffer(ret->buffer);
+            }
         }
         return ret;
     }
-    // for uniform buffer
+    // for uniform buffer that outlives frames, per draw data goes to
+    // uniformRing() instead
     template <typename T>
     std::unique_ptr<vbr::buffer::Buffer> createUniformBuffer() {
         VkDeviceSize size = sizeof(T);
@@ -165,7 +324,37 @@ class Device {
         return ret;
     }
 
-    std::unique_ptr<vbr::image::Texture> createTexture(std::string_view path);
+    // device local storage buffer without initial data, e.g. written by
+    // compute, usage adds to the storage usage, gets a bindless index,
+    // shared buffers are concurrent between graphics and async compute
+    std::unique_ptr<vbr::buffer::Buffer>
+    createStorageBuffer(VkDeviceSize size, VkBufferUsageFlags usage = 0,
+                        bool shared = false);
+    // capacity draws, a cpu filled buffer holds one region per frame in
+    // flight so create it after framesInFlight() is set
+    std::unique_ptr<vbr::indirect::Buffer>
+    createIndirectBuffer(uint32_t capacity, vbr::indirect::Fill fill);
+    // host visible buffer mapped for its lifetime, copy destination for
+    // results the cpu reads once their frame is done
+    std::unique_ptr<vbr::buffer::Buffer>
+    createReadbackBuffer(VkDeviceSize size);
+    // device local optimal tiling image with memory bound, e.g. depth
+    // buffers and storage images, views and layouts are up to the caller
+    bool createImage(const VkImageCreateInfo &info, VkImage &image,
+                     vbr::allocator::Allocation &allocation);
+    void destroyImage(VkImage &image, vbr::allocator::Allocation &allocation);
+    // more than one draw per vkCmdDrawIndexedIndirect
+    bool multiDrawIndirect() const { return m_multi_draw_indirect; }
+    // vkCmdDrawIndexedIndirectCount
+    bool drawIndirectCount() const { return m_draw_indirect_count; }
+    // firstInstance other than 0 in indirect commands
+    bool drawIndirectFirstInstance() const {
+        return m_draw_indirect_first_instance;
+    }
+
+    // with bindless, the texture view and sampler get table indices
+    std::unique_ptr<vbr::image::Texture>
+    createTexture(std::string_view path, vbr::upload::Ticket *ticket = nullptr);
 
     void waitIdle() { vkDeviceWaitIdle(m_vk_device); }
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace vbr::gpipeline {
+class Pipeline;
+}
+
+namespace vbr::buffer {
+struct Buffer;
+}
+
+namespace vbr::draw {
+
+constexpr uint32_t max_dynamic_offsets = 4;
+
+// one draw, pipeline, layout, set and buffers must outlive the replay
+struct Packet {
+    vbr::gpipeline::Pipeline *pipeline = nullptr;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    std::array<uint32_t, max_dynamic_offsets> dynamic_offsets{};
+    // at most max_dynamic_offsets, checked by Queue::push()
+    uint32_t dynamic_offset_count = 0;
+    vbr::buffer::Buffer *vertex = nullptr;
+    // indexed draw when set
+    vbr::buffer::Buffer *index = nullptr;
+    // vertices, or indices with an index buffer
+    uint32_t count = 0;
+    uint32_t instances = 1;
+    VkShaderStageFlags push_stages = 0;
+    uint32_t push_size = 0;
+    // view space distance, opaque draws go front to back, transparent
+    // ones back to front
+    float depth = 0.0f;
+    bool transparent = false;
+};
+
+// collects the draws of a frame and orders them by a 64 bit key so equal
+// state ends up adjacent, opaque keys are pipeline, set and depth,
+// transparent keys are inverted depth first
+class Queue {
+  public:
+    struct Item {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+  private:
+    std::vector<Packet> m_packets;
+    // push constants copied at push(), one offset per packet
+    std::vector<uint8_t> m_push_data;
+    std::vector<uint32_t> m_push_offsets;
+    std::vector<Item> m_items;
+    std::vector<Item> m_scratch;
+    // small ids keep the key short, given in order of first use
+    std::unordered_map<const void *, uint32_t> m_pipeline_ids;
+    std::unordered_map<VkDescriptorSet, uint32_t> m_set_ids;
+    bool m_sorted = true;
+
+  private:
+    uint64_t key(const Packet &packet);
+
+  public:
+    // push_data holds packet.push_size bytes, false and dropped when the
+    // packet has too many dynamic offsets
+    bool push(const Packet &packet, const void *push_data = nullptr);
+    // stable lsd radix sort, skips bytes all keys share
+    void sort();
+    void clear();
+
+    // sorted after sort()
+    const std::vector<Item> &items() const { return m_items; }
+    const Packet &packet(uint32_t index) const { return m_packets[index]; }
+    const void *pushData(uint32_t index) const {
+        return m_push_data.data() + m_push_offsets[index];
+    }
+    size_t size() const { return m_packets.size(); }
+    bool empty() const { return m_packets.empty(); }
+};
+
+} // namespace vbr::draw
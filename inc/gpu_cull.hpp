@@ -0,0 +1,135 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "compute_pipeline.hpp"
+#include "descriptor.hpp"
+#include "device.hpp"
+#include "glm/glm.hpp"
+#include "indirect.hpp"
+#include "layout.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace vbr::cull {
+
+// std430 element of the object buffer, a visible object becomes one
+// indexed draw with firstInstance set to its index so the vertex stage
+// can fetch it back, e.g. as a per instance vertex stream
+struct Object {
+    // world space bounding sphere, xyz center and w radius
+    glm::vec4 sphere;
+    uint32_t index_count;
+    uint32_t first_index;
+    int32_t vertex_offset;
+    uint32_t pad = 0;
+};
+
+// uniform of the cull shader
+struct View {
+    glm::mat4 view_proj;
+    // world space, normals point inside
+    glm::vec4 planes[6];
+    // texels of pyramid level 0
+    glm::vec2 pyramid_size;
+    uint32_t object_count;
+    // 0 while no pyramid has been built
+    uint32_t occlusion;
+};
+
+// push constant of the pyramid shader
+struct Reduce {
+    glm::ivec2 src_size;
+    glm::ivec2 dst_size;
+};
+
+struct Stats {
+    uint32_t objects = 0;
+    // draws emitted by the last frame done on the gpu, at most the
+    // capacity of the indirect buffer
+    uint32_t visible = 0;
+    // objects that passed the tests but did not fit in the buffer
+    uint32_t dropped = 0;
+};
+
+// gpu driven visibility, every object is tested against the frustum and
+// a max depth pyramid of the previous frame, survivors are compacted into
+// a gpu filled indirect buffer for vkCmdDrawIndexedIndirectCount, work is
+// recorded with its own pipelines outside rendering, objects revealed by a
+// moving camera show up one frame late
+class Culler {
+  private:
+    vbr::device::Device &m_device;
+    std::unique_ptr<vbr::indirect::Buffer> m_draws;
+    // draw count of every frame slot, read once the slot comes around
+    std::unique_ptr<vbr::buffer::Buffer> m_readback;
+    uint32_t m_slots = 1;
+    VkDescriptorBufferInfo m_objects{};
+    uint32_t m_object_count = 0;
+
+    // each level holds the farthest depth under its texels in the level
+    // below, level 0 the depth buffer itself, kept in general layout
+    VkImage m_pyramid = VK_NULL_HANDLE;
+    vbr::allocator::Allocation m_pyramid_memory;
+    // every level for the cull shader, then one view per level
+    VkImageView m_pyramid_view = VK_NULL_HANDLE;
+    std::vector<VkImageView> m_level_views;
+    std::vector<VkExtent2D> m_level_extents;
+    VkSampler m_sampler = VK_NULL_HANDLE;
+    VkImageView m_depth_view = VK_NULL_HANDLE;
+    bool m_pyramid_built = false;
+
+    // one set per level, binding 0 the source and 1 the level written
+    std::unique_ptr<vbr::descriptor::Descriptor> m_reduce_sets;
+    std::unique_ptr<vbr::layout::Layout> m_reduce_layout;
+    std::unique_ptr<vbr::cpipeline::Pipeline> m_reduce;
+    std::unique_ptr<vbr::descriptor::Descriptor> m_cull_set;
+    std::unique_ptr<vbr::layout::Layout> m_cull_layout;
+    std::unique_ptr<vbr::cpipeline::Pipeline> m_cull;
+    Stats m_stats;
+
+  private:
+    void destroyPyramid();
+    // write the sets of the current objects, draws and pyramid
+    void updateSets();
+
+  public:
+    static constexpr uint32_t group_size = 64;
+    static constexpr uint32_t reduce_group_size = 8;
+
+    Culler(vbr::device::Device &device);
+    ~Culler();
+
+    // shaders are spir-v paths, up to capacity objects are drawn per frame
+    bool init(uint32_t capacity, std::string_view cull_shader,
+              std::string_view pyramid_shader);
+    // pyramid for a depth buffer of extent, the device must be idle, its
+    // levels are moved to general layout with a one time submit
+    bool resize(VkExtent2D extent);
+    // storage buffer of Object, read by every cull(), the device must be
+    // idle when it changes
+    void objects(const vbr::buffer::Buffer &buffer, uint32_t count);
+    // reduce a depth buffer of the resize() extent into the pyramid, depth
+    // must be readable by compute shaders in layout, a changed view waits
+    // for the device
+    void buildPyramid(VkCommandBuffer cmd, VkImageView depth,
+                      VkImageLayout layout);
+    // test every object against view_proj, the draws are ready for
+    // indirect reads once it returns, occlusion needs a built pyramid
+    void cull(VkCommandBuffer cmd, uint32_t frame, const glm::mat4 &view_proj,
+              bool occlusion = true);
+    // the next pyramid is built from scratch, e.g. after a camera cut
+    void invalidate() { m_pyramid_built = false; }
+
+    vbr::indirect::Buffer &draws() { return *m_draws; }
+    const Stats &stats() const { return m_stats; }
+
+    Culler(Culler &) = delete;
+    Culler(Culler &&) = delete;
+    Culler &operator=(Culler &) = delete;
+    Culler &operator=(Culler &&) = delete;
+};
+
+} // namespace vbr::cull
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "device.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -8,11 +12,32 @@
 namespace vbr::gpipeline {
 
 class Pipeline {
+  public:
+    enum class State { empty, building, ready, failed };
+
   private:
+    // shader modules are loaded when the pipeline is built
+    struct ShaderStage {
+        VkShaderStageFlagBits stage;
+        std::string path;
+        std::string name;
+        const VkSpecializationInfo *special_info;
+    };
+
     vbr::device::Device &m_device;
     VkPipeline m_pipeline = VK_NULL_HANDLE;
-
-    std::vector<VkPipelineShaderStageCreateInfo> m_shader_stages;
+    // written by the building thread, m_pipeline is valid once ready
+    std::atomic<State> m_state = State::empty;
+    // the worker finishes under the lock, so wait() returning means the
+    // worker no longer touches this object
+    std::mutex m_build_mutex;
+    std::condition_variable m_build_cv;
+    // bound in place of this one until it is ready
+    Pipeline *m_fallback = nullptr;
+
+    std::vector<ShaderStage> m_shaders;
+    // shared modules held while the pipeline lives
+    std::vector<VkShaderModule> m_modules;
     std::vector<VkVertexInputBindingDescription> m_vertex_bindings;
     std::vector<VkVertexInputAttributeDescription> m_vertex_attributes;
     std::vector<VkViewport> m_viewports;
@@ -21,16 +46,34 @@ class Pipeline {
     VkPrimitiveTopology m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     VkPolygonMode m_polygon_mode = VK_POLYGON_MODE_FILL;
     VkFrontFace m_rasterization_front_face = VK_FRONT_FACE_CLOCKWISE;
+    // undefined without a depth attachment, the depth test is off then
+    VkFormat m_depth_format = VK_FORMAT_UNDEFINED;
+    bool m_depth_write = false;
+    VkCompareOp m_depth_compare = VK_COMPARE_OP_NEVER;
+    // draws measured while pipeline statistics are enabled
+    vbr::pstats::Counters m_statistics;
 
   private:
-    VkShaderModule createShaderModule(std::string_view path);
-    void destroyAllShaderModule();
+    void releaseShaderModules();
+    // load shaders and create the pipeline, safe to run on a worker
+    bool build(VkPipelineLayout layout);
+    void finish(bool ret);
 
   public:
     Pipeline(vbr::device::Device &device);
     ~Pipeline();
 
     bool init(VkPipelineLayout &layout);
+    // build on the device worker pool, the pipeline must not be changed
+    // until ready() or failed()
+    void initAsync(VkPipelineLayout layout);
+    // block until a pending build is done
+    bool wait();
+    State state() const { return m_state.load(std::memory_order_acquire); }
+    bool ready() const { return state() == State::ready; }
+    bool failed() const { return state() == State::failed; }
+    Pipeline *fallback() const { return m_fallback; }
+    void fallback(Pipeline *pipeline) { m_fallback = pipeline; }
 
     void addShader(const VkShaderStageFlagBits &stage,
                    std::string_view shader_path,
@@ -61,8 +104,28 @@ class Pipeline {
                       uint32_t offset);
 
     void frontFace(VkFrontFace v) { m_rasterization_front_face = v; }
-
-    VkPipeline operator*() { return m_pipeline; }
+    void topology(VkPrimitiveTopology v) { m_topology = v; }
+    void polygonMode(VkPolygonMode v) { m_polygon_mode = v; }
+    // drawn in passes with a depth attachment of format, tested with compare
+    void depth(VkFormat format, bool write = true,
+               VkCompareOp compare = VK_COMPARE_OP_LESS_OR_EQUAL) {
+        m_depth_format = format;
+        m_depth_write = write;
+        m_depth_compare = compare;
+    }
+
+    // totals of the draws recorded with it while the device collects
+    // pipeline statistics, added once their frame slot comes around
+    vbr::pstats::Counters &statistics() { return m_statistics; }
+    const vbr::pstats::Counters &statistics() const { return m_statistics; }
+
+    // null until ready
+    VkPipeline operator*() { return ready() ? m_pipeline : VK_NULL_HANDLE; }
+
+    Pipeline(Pipeline &) = delete;
+    Pipeline(Pipeline &&) = delete;
+    Pipeline &operator=(Pipeline &) = delete;
+    Pipeline &operator=(Pipeline &&) = delete;
 };
 
 } // namespace vbr::gpipeline
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "allocator.hpp"
+#include "bindless.hpp"
 #include "glm/glm.hpp"
 #include "vulkan/vulkan_core.h"
 #include <string_view>
@@ -31,15 +33,19 @@ struct Image {
 struct Texture {
     VkImage image = VK_NULL_HANDLE;
     VkImageView view = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    vbr::allocator::Allocation allocation;
     VkSampler sampler = VK_NULL_HANDLE;
+    // view and sampler slots in the device bindless table
+    uint32_t index = vbr::bindless::invalid_index;
+    uint32_t sampler_index = vbr::bindless::invalid_index;
 
     Texture(vbr::device::Device &device);
     ~Texture();
 
     bool init(VkFormat format = VK_FORMAT_R8G8B8A8_SRGB);
 
-    void copyFrom(VkBuffer &buffer, glm::ivec2 size);
+    // record the copy, image must be in transfer dst layout
+    void copyFrom(VkCommandBuffer &cmd, VkBuffer &buffer, glm::ivec2 size);
 
   private:
     vbr::device::Device &main_device;
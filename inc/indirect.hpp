@@ -0,0 +1,89 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "util.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+
+namespace vbr::indirect {
+
+// who writes the commands
+enum class Fill {
+    // host visible, one region per frame in flight
+    cpu,
+    // device local storage buffer, written by compute in the frame
+    gpu,
+};
+
+// array of VkDrawIndexedIndirectCommand behind a uint32 draw count, the
+// count feeds vkCmdDrawIndexedIndirectCount, a cpu filled buffer keeps a
+// region per frame in flight so writing one never races the gpu reading
+// another
+class Buffer {
+  private:
+    std::unique_ptr<vbr::buffer::Buffer> m_buffer;
+    Fill m_fill;
+    uint32_t m_capacity;
+    // count header, padded so commands stay storage offset aligned
+    VkDeviceSize m_header;
+    VkDeviceSize m_region_size;
+    // frames in flight at creation, cpu only
+    uint32_t m_regions;
+    uint32_t m_region = 0;
+    // commands pushed into the current region, cpu only
+    uint32_t m_count = 0;
+    // the last begin() found a frame count the regions do not match
+    bool m_stale = false;
+
+  private:
+    uint8_t *region() const {
+        return static_cast<uint8_t *>(m_buffer->data) +
+               m_region * m_region_size;
+    }
+
+  public:
+    // cpu buffers must be mapped, alignment is
+    // minStorageBufferOffsetAlignment
+    Buffer(std::unique_ptr<vbr::buffer::Buffer> buffer, Fill fill,
+           uint32_t capacity, VkDeviceSize alignment, uint32_t regions);
+
+    // whole buffer size for the layout above
+    static VkDeviceSize bytes(uint32_t capacity, VkDeviceSize alignment,
+                              uint32_t regions);
+
+    // cpu: switch to the region of frame and empty it, the gpu is done
+    // with it once the frame slot comes around, false and nothing may be
+    // pushed when frames_in_flight changed since the buffer was created
+    bool begin(uint32_t frame, uint32_t frames_in_flight);
+    // cpu: false when the region is full or begin() failed
+    bool push(const VkDrawIndexedIndirectCommand &command);
+    // gpu: zero the count before compute appends to it
+    void clear(VkCommandBuffer cmd);
+    // gpu: make compute writes visible to the indirect draws
+    void barrier(vbr::util::BarrierBatch &batch) const;
+
+    VkBuffer buffer() const { return m_buffer->buffer; }
+    VkDeviceSize countOffset() const { return m_region * m_region_size; }
+    VkDeviceSize commandOffset() const { return countOffset() + m_header; }
+    // commands pushed this frame, the gpu count is only known on the gpu
+    uint32_t count() const { return m_count; }
+    uint32_t capacity() const { return m_capacity; }
+    uint32_t regions() const { return m_regions; }
+    Fill fill() const { return m_fill; }
+    // storage descriptors for the compute writer
+    VkDescriptorBufferInfo countInfo() const {
+        return {m_buffer->buffer, countOffset(), sizeof(uint32_t)};
+    }
+    VkDescriptorBufferInfo commandInfo() const {
+        return {m_buffer->buffer, commandOffset(),
+                m_capacity * sizeof(VkDrawIndexedIndirectCommand)};
+    }
+
+    Buffer(Buffer &) = delete;
+    Buffer(Buffer &&) = delete;
+    Buffer &operator=(Buffer &) = delete;
+    Buffer &operator=(Buffer &&) = delete;
+};
+
+} // namespace vbr::indirect
@@ -2,17 +2,61 @@
 
 #include "vulkan/vulkan_core.h"
 #include <cstdint>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 namespace vbr::layout {
 
+// set layouts and pipeline layouts keyed by their signature, equal
+// signatures share one handle owned by the cache
+class Cache {
+  private:
+    // create info flattened into words, compared in full on lookup
+    using Key = std::vector<uint64_t>;
+    struct KeyHash {
+        size_t operator()(const Key &key) const;
+    };
+
+    VkDevice &m_device;
+    // descriptors and pipelines may be created on worker threads
+    std::mutex m_mutex;
+    std::unordered_map<Key, VkDescriptorSetLayout, KeyHash> m_set_layouts;
+    std::unordered_map<Key, VkPipelineLayout, KeyHash> m_pipeline_layouts;
+    uint32_t m_hits = 0;
+    uint32_t m_misses = 0;
+
+  public:
+    Cache(VkDevice &device);
+    ~Cache();
+
+    // binding order does not matter, null on failure
+    VkDescriptorSetLayout
+    setLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+              VkDescriptorSetLayoutCreateFlags flags = 0);
+    VkPipelineLayout
+    pipelineLayout(const std::vector<VkDescriptorSetLayout> &set_layouts,
+                   const std::vector<VkPushConstantRange> &constants);
+    void destroy();
+
+    uint32_t hits() const { return m_hits; }
+    uint32_t misses() const { return m_misses; }
+
+    Cache(Cache &) = delete;
+    Cache(Cache &&) = delete;
+    Cache &operator=(Cache &) = delete;
+    Cache &operator=(Cache &&) = delete;
+};
+
 class Layout {
   private:
     VkDevice &m_device;
+    // shared layouts, the layout owns its handle when it is null
+    Cache *m_cache;
     VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
     std::vector<VkPushConstantRange> m_constant;
 
   public:
-    Layout(VkDevice &device);
+    Layout(VkDevice &device, Cache *cache = nullptr);
     ~Layout();
 
     void addConstnat(VkShaderStageFlags stage, uint32_t offset, uint32_t size);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vbr::pcache {
+
+// VkPipelineCache shared by all pipelines of a device, persisted to a file
+// so later runs skip the spir-v compile of known pipelines
+class PipelineCache {
+  private:
+    // prefix of the cache file, guards against data of another device or
+    // driver and against truncated writes
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint32_t driver_version;
+        uint8_t uuid[VK_UUID_SIZE];
+        uint32_t reserved;
+        uint64_t data_size;
+        uint64_t data_hash;
+    };
+    static constexpr uint32_t file_magic = 0x43504256; // "VBPC"
+    static constexpr uint32_t file_version = 1;
+
+    VkDevice &m_device;
+    const VkPhysicalDeviceProperties &m_properties;
+    VkPipelineCache m_cache = VK_NULL_HANDLE;
+    std::string m_path;
+    // loaded from a valid file
+    bool m_warm = false;
+    // pipeline creation time since init, pipelines build on many threads
+    mutable std::mutex m_stats_mutex;
+    uint32_t m_pipelines = 0;
+    double m_create_ms = 0.0;
+
+  private:
+    // check our prefix and the vulkan header behind it
+    bool validate(const FileHeader &header, const std::vector<char> &data);
+    std::vector<char> read();
+
+  public:
+    PipelineCache(VkDevice &device,
+                  const VkPhysicalDeviceProperties &properties);
+    ~PipelineCache();
+
+    // create the cache, seeded from path when it holds a matching cache
+    bool init(std::string_view path);
+    // write the cache to path.tmp, then rename over path
+    bool save();
+    void destroy();
+
+    // time spent in vkCreate*Pipelines with this cache
+    void record(double ms);
+    void report() const;
+
+    bool warm() const { return m_warm; }
+    uint32_t pipelineCount() const {
+        std::lock_guard lock(m_stats_mutex);
+        return m_pipelines;
+    }
+    double createTime() const {
+        std::lock_guard lock(m_stats_mutex);
+        return m_create_ms;
+    }
+    VkPipelineCache operator*() const { return m_cache; }
+
+    PipelineCache(PipelineCache &) = delete;
+    PipelineCache(PipelineCache &&) = delete;
+    PipelineCache &operator=(PipelineCache &) = delete;
+    PipelineCache &operator=(PipelineCache &&) = delete;
+};
+
+} // namespace vbr::pcache
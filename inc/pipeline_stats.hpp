@@ -0,0 +1,106 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vbr::device {
+class Device;
+}
+
+namespace vbr::pstats {
+
+inline constexpr uint32_t invalid_query = UINT32_MAX;
+
+// the counters queried, results come back in bit order so they match the
+// fields of Counters
+inline constexpr VkQueryPipelineStatisticFlags counter_flags =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+inline constexpr uint32_t counter_count = 7;
+
+// totals over every measured draw or dispatch of a pipeline
+struct Counters {
+    uint64_t input_vertices = 0;
+    uint64_t input_primitives = 0;
+    uint64_t vertex_invocations = 0;
+    // primitives reaching the clipper and the ones left after it
+    uint64_t clipping_invocations = 0;
+    uint64_t clipping_primitives = 0;
+    uint64_t fragment_invocations = 0;
+    uint64_t compute_invocations = 0;
+    // draws and dispatches counted
+    uint64_t samples = 0;
+
+    // counter_count values of one query in field order
+    void add(const uint64_t *values);
+    void reset() { *this = {}; }
+};
+
+// log the totals and the ratios that hint at overdraw and dense meshes
+void report(std::string_view name, const Counters &counters);
+
+// opt-in pipeline statistics queries around single draws and dispatches,
+// one query pool per slot like profile::Profiler, results are added to the
+// counters of the pipeline that was bound once the slot comes around
+class Collector {
+  private:
+    struct Slot {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        // counters of every query written, null once forgotten
+        std::vector<Counters *> targets;
+    };
+
+    vbr::device::Device &m_device;
+    std::vector<Slot> m_slots;
+    uint32_t m_slot = 0;
+    uint32_t m_max_queries = 0;
+    bool m_supported = false;
+    bool m_host_reset = false;
+    bool m_enabled = false;
+    // begin() was called with the collector enabled
+    bool m_recording = false;
+    // a query is open, only one may be active at a time
+    bool m_active = false;
+    std::vector<uint64_t> m_results;
+
+  private:
+    void destroy();
+    void collect(Slot &slot);
+
+  public:
+    Collector(vbr::device::Device &device);
+    ~Collector();
+
+    // pools of the graphics family for up to max_queries draws and
+    // dispatches per slot, may be called again with the device idle, a
+    // device without pipelineStatisticsQuery leaves it unsupported
+    bool init(uint32_t slots, uint32_t max_queries = 4096);
+    bool supported() const { return m_supported; }
+    // off by default, queries add some cost to every draw, takes effect
+    // at the next begin()
+    void enable(bool on) { m_enabled = on && m_supported; }
+    bool enabled() const { return m_enabled; }
+    // the work of the slot's last use must be done on the gpu, like
+    // Profiler::begin() cmd must be outside rendering without host reset
+    void begin(VkCommandBuffer cmd, uint32_t slot);
+    // count the next commands into counters, invalid_query when disabled,
+    // not begun, the slot is full or a query is already open
+    uint32_t push(VkCommandBuffer cmd, Counters &counters);
+    void pop(VkCommandBuffer cmd, uint32_t query);
+    // drop pending results for counters about to be destroyed
+    void forget(const Counters &counters);
+
+    Collector(Collector &) = delete;
+    Collector(Collector &&) = delete;
+    Collector &operator=(Collector &) = delete;
+    Collector &operator=(Collector &&) = delete;
+};
+
+} // namespace vbr::pstats
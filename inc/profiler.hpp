@@ -0,0 +1,116 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vbr::device {
+class Device;
+}
+
+namespace vbr::profile {
+
+inline constexpr uint32_t invalid_scope = UINT32_MAX;
+
+// rolling gpu time of one scope name, in milliseconds
+struct Stats {
+    std::string name;
+    double last = 0.0;
+    double min = 0.0;
+    double avg = 0.0;
+    double max = 0.0;
+    uint32_t samples = 0;
+};
+
+// gpu timestamps around named scopes, one query pool per slot so a slot
+// is only read and reset once the work that wrote it is done, e.g. one
+// slot per frame in flight, results feed rolling stats per scope name
+class Profiler {
+  private:
+    struct Slot {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        // series of every scope written, scope i owns queries 2i and 2i+1
+        std::vector<uint32_t> scopes;
+    };
+    struct Series {
+        std::string name;
+        // the last window samples, head is the oldest once full
+        std::vector<double> samples;
+        uint32_t head = 0;
+        double last = 0.0;
+    };
+
+    vbr::device::Device &m_device;
+    std::vector<Slot> m_slots;
+    uint32_t m_slot = 0;
+    uint32_t m_max_scopes = 0;
+    uint32_t m_window;
+    // nanoseconds per tick and the valid bits of the family
+    double m_period = 0.0;
+    uint64_t m_mask = 0;
+    bool m_enabled = false;
+    bool m_host_reset = false;
+    // begin() was called, scopes go to m_slot
+    bool m_recording = false;
+    std::vector<Series> m_series;
+    std::unordered_map<std::string, uint32_t> m_names;
+    std::vector<uint64_t> m_results;
+
+  private:
+    void destroy();
+    // read the finished scopes of a slot into their series
+    void collect(Slot &slot);
+    uint32_t series(std::string_view name);
+
+  public:
+    // window is the number of samples kept per scope name
+    Profiler(vbr::device::Device &device, uint32_t window = 120);
+    ~Profiler();
+
+    // pools of queue family for up to max_scopes scopes per slot, may be
+    // called again with the device idle, stats are kept, a family without
+    // timestamps leaves the profiler disabled
+    bool init(uint32_t family, uint32_t slots, uint32_t max_scopes = 64);
+    bool enabled() const { return m_enabled; }
+    // the work of the slot's last use must be done on the gpu, its scopes
+    // are collected and the pool reset, on the host when the device can,
+    // else in cmd which must be outside rendering
+    void begin(VkCommandBuffer cmd, uint32_t slot);
+    // timestamp after all previous commands, invalid_scope when disabled,
+    // not begun or the slot is full
+    uint32_t push(VkCommandBuffer cmd, std::string_view name);
+    void pop(VkCommandBuffer cmd, uint32_t scope);
+
+    // per scope name in the order they were first seen
+    std::vector<Stats> stats() const;
+    void report(std::string_view title) const;
+
+    Profiler(Profiler &) = delete;
+    Profiler(Profiler &&) = delete;
+    Profiler &operator=(Profiler &) = delete;
+    Profiler &operator=(Profiler &&) = delete;
+};
+
+// push on construction and pop on destruction
+class Scope {
+  private:
+    Profiler &m_profiler;
+    VkCommandBuffer m_cmd;
+    uint32_t m_scope;
+
+  public:
+    Scope(Profiler &profiler, VkCommandBuffer cmd, std::string_view name)
+        : m_profiler(profiler), m_cmd(cmd),
+          m_scope(profiler.push(cmd, name)) {}
+    ~Scope() { m_profiler.pop(m_cmd, m_scope); }
+
+    Scope(Scope &) = delete;
+    Scope(Scope &&) = delete;
+    Scope &operator=(Scope &) = delete;
+    Scope &operator=(Scope &&) = delete;
+};
+
+} // namespace vbr::profile
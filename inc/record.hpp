@@ -0,0 +1,72 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include "worker.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace vbr::record {
+
+// attachments of the rendering the secondary command buffers run in
+struct Inheritance {
+    std::vector<VkFormat> color_formats;
+    VkFormat depth_format = VK_FORMAT_UNDEFINED;
+    VkFormat stencil_format = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+// records items [first, last) of a draw list into cmd, runs on any thread
+using Job = std::function<void(VkCommandBuffer cmd, uint32_t first,
+                               uint32_t last)>;
+
+// splits a draw list across the worker pool, each chunk goes into its own
+// secondary command buffer, then all are executed in order in the primary
+class Recorder {
+  private:
+    // command buffers are owned by the pool of the chunk index, a pool is
+    // only touched by the thread recording that chunk
+    struct Slot {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> cmds;
+        // handed out since the frame began
+        uint32_t used = 0;
+    };
+
+    VkDevice &m_device;
+    vbr::worker::Pool &m_workers;
+    uint32_t m_family;
+    // slots per frame in flight
+    std::vector<std::vector<Slot>> m_frames;
+    uint32_t m_frame = 0;
+    // secondaries executed since the frame began
+    uint32_t m_recorded = 0;
+
+  private:
+    VkCommandBuffer acquire(Slot &slot);
+    void destroy();
+
+  public:
+    Recorder(VkDevice &device, vbr::worker::Pool &workers, uint32_t family);
+    ~Recorder();
+
+    // one slot per worker plus the calling thread, the device must be idle
+    bool init(uint32_t frames);
+    // reset the pools of frame, its previous commands are done on the gpu
+    void begin(uint32_t frame);
+    // count items in chunks of at least min_chunk, the calling thread
+    // records the first chunk, the primary must be inside a rendering
+    // begun with VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+    bool record(VkCommandBuffer primary, const Inheritance &inheritance,
+                uint32_t count, const Job &job, uint32_t min_chunk = 1024);
+
+    uint32_t slots() const { return m_workers.size() + 1; }
+    uint32_t recorded() const { return m_recorded; }
+
+    Recorder(Recorder &) = delete;
+    Recorder(Recorder &&) = delete;
+    Recorder &operator=(Recorder &) = delete;
+    Recorder &operator=(Recorder &&) = delete;
+};
+
+} // namespace vbr::record
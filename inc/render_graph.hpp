@@ -0,0 +1,236 @@
+#pragma once
+
+#include "allocator.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vbr::device {
+class Device;
+}
+
+namespace vbr::graph {
+
+// how a pass touches a resource, decides stages, access and layout
+enum class Access {
+    color_attachment,
+    depth_attachment,
+    depth_read,
+    sampled,
+    storage_read,
+    storage_write,
+    transfer_src,
+    transfer_dst,
+    vertex,
+    index,
+    indirect,
+    uniform,
+};
+
+struct ImageHandle {
+    uint32_t id = UINT32_MAX;
+};
+struct BufferHandle {
+    uint32_t id = UINT32_MAX;
+};
+
+// layout and scope of an access outside the graph, e.g. the acquire
+// semaphore wait before the first pass or present after the last one
+struct ImageState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 access = VK_ACCESS_2_NONE;
+};
+
+struct ImageDesc {
+    VkFormat format;
+    VkExtent2D extent;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+struct Stats {
+    uint32_t passes = 0;
+    uint32_t culled = 0;
+    uint32_t barriers = 0;
+    // vkCmdPipelineBarrier2 calls per execute
+    uint32_t batches = 0;
+    uint32_t transient_images = 0;
+    uint32_t memory_blocks = 0;
+    // transient memory with and without aliasing
+    VkDeviceSize memory = 0;
+    VkDeviceSize unaliased_memory = 0;
+};
+
+class Graph;
+
+class Pass {
+    friend class Graph;
+
+  private:
+    struct Use {
+        uint32_t id;
+        bool image;
+        Access access;
+        // the pass needs the previous contents
+        bool keep;
+    };
+    struct Attachment {
+        ImageHandle image;
+        VkAttachmentLoadOp load;
+        VkClearValue clear;
+    };
+
+    std::string m_name;
+    std::vector<Use> m_uses;
+    std::vector<Attachment> m_colors;
+    std::optional<Attachment> m_depth;
+    std::function<void(VkCommandBuffer)> m_record;
+    bool m_side_effect = false;
+
+  public:
+    Pass(std::string_view name) : m_name(name) {}
+
+    Pass &use(ImageHandle image, Access access);
+    Pass &use(BufferHandle buffer, Access access);
+    // render targets, the graph begins dynamic rendering around record
+    Pass &color(ImageHandle image,
+                VkAttachmentLoadOp load = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                VkClearValue clear = {});
+    Pass &depth(ImageHandle image,
+                VkAttachmentLoadOp load = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                VkClearValue clear = {});
+    // never culled, e.g. writes the graph can not see
+    Pass &sideEffect() {
+        m_side_effect = true;
+        return *this;
+    }
+    Pass &record(std::function<void(VkCommandBuffer)> fn) {
+        m_record = std::move(fn);
+        return *this;
+    }
+};
+
+// passes declared in execution order with the resources they touch,
+// compiled once into a schedule with batched barriers, culled passes and
+// aliased transient images, then executed every frame
+class Graph {
+  private:
+    struct Image {
+        std::string name;
+        ImageDesc desc;
+        VkImageAspectFlags aspect;
+        bool imported;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        ImageState initial;
+        std::optional<ImageState> final_state;
+        // transient only
+        VkImageUsageFlags usage = 0;
+        uint32_t first = UINT32_MAX;
+        uint32_t last = 0;
+        uint32_t block = UINT32_MAX;
+    };
+    struct Buffer {
+        std::string name;
+        VkBuffer buffer;
+        ImageState initial;
+    };
+    // memory shared by transient images with disjoint lifetimes
+    struct Block {
+        VkMemoryRequirements requirements;
+        vbr::allocator::Allocation allocation;
+        // last image placed in the block
+        uint32_t last_image;
+        // every access to the block, the first use of each image waits on
+        // them since the previous owner may be in this or the last frame
+        VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 access = VK_ACCESS_2_NONE;
+    };
+    // access state while compiling
+    struct State {
+        VkImageLayout layout;
+        // last write, or layout transition
+        VkPipelineStageFlags2 write_stages;
+        VkAccessFlags2 write_access;
+        // stages that already waited on the last write
+        VkPipelineStageFlags2 synced_stages;
+        // reads since the last write, later writes wait on them
+        VkPipelineStageFlags2 read_stages;
+    };
+    struct Batch {
+        std::vector<VkImageMemoryBarrier2> images;
+        std::vector<uint32_t> image_ids;
+        std::vector<VkBufferMemoryBarrier2> buffers;
+        std::vector<uint32_t> buffer_ids;
+
+        bool empty() const { return images.empty() && buffers.empty(); }
+    };
+
+    vbr::device::Device &m_device;
+    std::vector<Image> m_images;
+    std::vector<Buffer> m_buffers;
+    // deque keeps passes in place while callers hold them
+    std::deque<Pass> m_passes;
+    std::vector<Block> m_blocks;
+    // live passes in order, with the barriers recorded before each
+    std::vector<uint32_t> m_schedule;
+    std::vector<Batch> m_batches;
+    Batch m_final;
+    Stats m_stats;
+    bool m_compiled = false;
+
+  private:
+    void cull();
+    bool allocateTransients();
+    void destroyTransients();
+    bool buildBarriers();
+    void barrier(Batch &batch, State &state, uint32_t id, bool image,
+                 VkPipelineStageFlags2 stages, VkAccessFlags2 access,
+                 VkImageLayout layout, bool write);
+    void emit(VkCommandBuffer cmd, Batch &batch);
+    void beginRendering(VkCommandBuffer cmd, const Pass &pass);
+
+  public:
+    Graph(vbr::device::Device &device);
+    ~Graph();
+
+    // owned by the graph, created and aliased by compile()
+    ImageHandle createImage(std::string_view name, const ImageDesc &desc);
+    // owned by the caller, final_state is applied after the last pass,
+    // image and view may be rebound every frame with bindImage()
+    ImageHandle importImage(std::string_view name, const ImageDesc &desc,
+                            VkImage image, VkImageView view,
+                            const ImageState &initial,
+                            std::optional<ImageState> final_state = {});
+    BufferHandle importBuffer(std::string_view name, VkBuffer buffer,
+                              const ImageState &initial = {});
+    void bindImage(ImageHandle handle, VkImage image, VkImageView view);
+    void bindBuffer(BufferHandle handle, VkBuffer buffer);
+    Pass &addPass(std::string_view name);
+
+    bool compile();
+    // record every live pass into cmd
+    void execute(VkCommandBuffer cmd);
+    // drop passes, resources and transient memory
+    void reset();
+
+    VkImage image(ImageHandle handle) const {
+        return m_images[handle.id].image;
+    }
+    VkImageView view(ImageHandle handle) const {
+        return m_images[handle.id].view;
+    }
+    const Stats &stats() const { return m_stats; }
+
+    Graph(Graph &) = delete;
+    Graph(Graph &&) = delete;
+    Graph &operator=(Graph &) = delete;
+    Graph &operator=(Graph &&) = delete;
+};
+
+} // namespace vbr::graph
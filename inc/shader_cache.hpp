@@ -0,0 +1,60 @@
+#pragma once
+
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace vbr::shader {
+
+// shader modules shared between pipelines, one module per distinct spir-v
+// content no matter how many paths or pipelines refer to it
+class ShaderCache {
+  private:
+    struct Module {
+        VkShaderModule module = VK_NULL_HANDLE;
+        uint32_t refs = 0;
+        // compared on a hash hit, distinct content may share a hash
+        std::vector<uint32_t> code;
+    };
+
+    VkDevice &m_device;
+    // pipelines build on worker threads
+    std::mutex m_mutex;
+    // content hash of every path with a live module, files are read once
+    // while it lives
+    std::unordered_map<std::string, uint64_t> m_paths;
+    std::unordered_multimap<uint64_t, Module> m_modules;
+    std::unordered_map<VkShaderModule, uint64_t> m_hashes;
+    uint32_t m_loads = 0;
+    uint32_t m_hits = 0;
+
+  private:
+    // read and validate a spir-v file
+    static bool read(std::string_view path, std::vector<uint32_t> &code);
+    // take one more reference of the module with that content, if any,
+    // without code only a hash held by a single module is trusted
+    VkShaderModule reuse(uint64_t hash, const std::vector<uint32_t> *code);
+
+  public:
+    ShaderCache(VkDevice &device);
+    ~ShaderCache();
+
+    // module for the file with one more reference, null on failure
+    VkShaderModule acquire(std::string_view path);
+    // drop a reference, the module is destroyed with the last one
+    void release(VkShaderModule module);
+
+    uint32_t loads() const { return m_loads; }
+    uint32_t hits() const { return m_hits; }
+
+    ShaderCache(ShaderCache &) = delete;
+    ShaderCache(ShaderCache &&) = delete;
+    ShaderCache &operator=(ShaderCache &) = delete;
+    ShaderCache &operator=(ShaderCache &&) = delete;
+};
+
+} // namespace vbr::shader
@@ -20,9 +20,16 @@ class Swapchain {
     VkSwapchainKHR m_vk_swapchain = VK_NULL_HANDLE;
     std::vector<std::unique_ptr<vbr::image::Image>> m_vk_swapchain_images;
     uint32_t m_current_index;
+    // transfer dst only when the surface supports it
+    VkImageUsageFlags m_usage = 0;
+    // render done semaphores, one per swapchain image
+    std::vector<VkSemaphore> m_vk_render_done;
     // multiple sample
     std::unique_ptr<vbr::image::Image> m_color_image;
-    VkDeviceMemory m_color_memory = VK_NULL_HANDLE;
+    vbr::allocator::Allocation m_color_allocation;
+
+  private:
+    void destroyRenderDone();
 
   public:
     Swapchain(vbr::device::Device &device);
@@ -39,6 +46,8 @@ class Swapchain {
         return m_vk_swapchain_images[m_current_index]->view;
     }
     uint32_t currentIndex() const { return m_current_index; }
+    VkImageUsageFlags usage() const { return m_usage; }
+    VkSemaphore &renderDone() { return m_vk_render_done[m_current_index]; }
 
     VkImage &colorImage() const { return m_color_image->image; }
     VkImageView &colorView() const { return m_color_image->view; }
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace vbr::uniform {
+
+// piece of the ring for one draw, offset is the dynamic offset to bind
+struct Slice {
+    void *data = nullptr;
+    uint32_t offset = 0;
+
+    bool valid() const { return data != nullptr; }
+};
+
+// linear allocator over one persistently mapped uniform buffer, slices of
+// a frame are reused once the gpu finished that frame, bind them through
+// VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC offsets
+class Ring {
+  private:
+    std::unique_ptr<vbr::buffer::Buffer> m_buffer;
+    uint8_t *m_data = nullptr;
+    VkDeviceSize m_size;
+    VkDeviceSize m_alignment;
+    // positions count bytes ever allocated, offsets are them modulo size
+    uint64_t m_head = 0;
+    // everything before tail is done on the gpu
+    uint64_t m_tail = 0;
+    // head when each frame slot was last left
+    std::vector<uint64_t> m_frame_heads;
+    uint32_t m_frame = 0;
+    // bytes of the frame being recorded and the largest frame so far
+    VkDeviceSize m_frame_bytes = 0;
+    VkDeviceSize m_peak_bytes = 0;
+
+  public:
+    // buffer must be host visible, mapped and hold uniform usage
+    Ring(std::unique_ptr<vbr::buffer::Buffer> buffer, VkDeviceSize size,
+         VkDeviceSize alignment, uint32_t frames);
+
+    // start recording frame, its previous slices are done on the gpu
+    void begin(uint32_t frame);
+    // forget every slice, the device must be idle
+    void reset(uint32_t frames);
+    // invalid slice when the ring is full
+    Slice allocate(VkDeviceSize size);
+    template <typename T> Slice push(const T &value) {
+        Slice slice = allocate(sizeof(T));
+        if (slice.valid()) {
+            memcpy(slice.data, &value, sizeof(T));
+        }
+        return slice;
+    }
+
+    // for the dynamic descriptor, range is the size of one slice
+    VkDescriptorBufferInfo info(VkDeviceSize range) const {
+        return {m_buffer->buffer, 0, range};
+    }
+    VkDeviceSize size() const { return m_size; }
+    VkDeviceSize alignment() const { return m_alignment; }
+    VkDeviceSize peakBytes() const { return m_peak_bytes; }
+
+    Ring(Ring &) = delete;
+    Ring(Ring &&) = delete;
+    Ring &operator=(Ring &) = delete;
+    Ring &operator=(Ring &&) = delete;
+};
+
+} // namespace vbr::uniform
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "glm/glm.hpp"
+#include "profiler.hpp"
+#include "util.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vbr::device {
+class Device;
+}
+
+namespace vbr::image {
+struct Texture;
+}
+
+namespace vbr::upload {
+
+// timeline value the batch of an upload signals once it is done on the gpu
+using Ticket = uint64_t;
+
+// batches copies and layout transitions into one command buffer and submits
+// them without waiting, callers wait or poll on the returned ticket
+class Uploader {
+  public:
+    // stages and accesses of the graphics queue that use uploaded data,
+    // compute may also write it in place
+    static constexpr VkPipelineStageFlags consume_stages =
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    static constexpr VkAccessFlags consume_access =
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+        VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT |
+        VK_ACCESS_SHADER_WRITE_BIT;
+
+  private:
+    struct Batch {
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        Ticket ticket = 0;
+        // staging buffers released once the batch is done
+        std::vector<std::unique_ptr<vbr::buffer::Buffer>> stages;
+        // layout changes and ownership releases after the copies, recorded
+        // together when the batch is submitted
+        vbr::util::BarrierBatch releases;
+        // acquire halves of the ownership transfers released in the batch
+        vbr::util::BarrierBatch acquires;
+        // timestamps around the batch, invalid_scope when not profiled
+        uint32_t scope = vbr::profile::invalid_scope;
+    };
+    // profiler slots, a batch reuses the slot of the batch this many
+    // tickets before it
+    static constexpr uint32_t profile_slots = 4;
+
+    vbr::device::Device &m_device;
+    VkQueue m_queue = VK_NULL_HANDLE;
+    uint32_t m_family = 0;
+    // family of the queue consuming the uploads
+    uint32_t m_owner_family = 0;
+    VkCommandPool m_cmd_pool = VK_NULL_HANDLE;
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    Batch m_recording;
+    std::vector<Batch> m_pending;
+    std::vector<VkCommandBuffer> m_free_cmds;
+    // acquires of submitted batches not yet recorded on the owner queue
+    vbr::util::BarrierBatch m_acquires;
+    Ticket m_next = 1;
+    Ticket m_submitted = 0;
+    std::unique_ptr<vbr::profile::Profiler> m_profiler;
+
+  private:
+    // begin the recording batch if needed
+    VkCommandBuffer record();
+    void release(Batch &batch);
+
+  public:
+    Uploader(vbr::device::Device &device);
+    ~Uploader();
+
+    bool init(uint32_t family, VkQueue queue, uint32_t owner_family);
+
+    Ticket copyBuffer(std::unique_ptr<vbr::buffer::Buffer> stage,
+                      vbr::buffer::Buffer &dst, VkDeviceSize size);
+    // transition to transfer dst and copy, the transition to shader read
+    // is batched with the other releases of the batch
+    Ticket copyTexture(std::unique_ptr<vbr::buffer::Buffer> stage,
+                       vbr::image::Texture &dst, glm::ivec2 size);
+
+    // submit the recording batch, return the last submitted ticket
+    Ticket flush();
+    // record pending acquire barriers into a command buffer of the owner
+    // family, its submit must wait on the tickets of the released batches
+    void acquire(VkCommandBuffer &cmd);
+    // uploads run on another family and need ownership transfers
+    bool transferOwnership() const { return m_family != m_owner_family; }
+    bool done(Ticket ticket);
+    void wait(Ticket ticket);
+    // release staging buffers of finished batches
+    void collect();
+
+    VkSemaphore &timeline() { return m_timeline; }
+    Ticket submitted() const { return m_submitted; }
+    // gpu time of the submitted batches, disabled when the upload family
+    // has no timestamps
+    const vbr::profile::Profiler &profiler() const { return *m_profiler; }
+
+    Uploader(Uploader &) = delete;
+    Uploader(Uploader &&) = delete;
+    Uploader &operator=(Uploader &) = delete;
+    Uploader &operator=(Uploader &&) = delete;
+};
+
+} // namespace vbr::upload
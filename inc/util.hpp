@@ -1,6 +1,8 @@
 #pragma once
 
 #include "vulkan/vulkan_core.h"
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string_view>
 #include <vector>
@@ -69,6 +71,44 @@ struct GPUInfo {
     VkSurfaceFormatKHR surface_format;
 };
 
+// collects synchronization2 barriers and records them with a single
+// vkCmdPipelineBarrier2, so independent transitions share one sync point
+class BarrierBatch {
+  private:
+    std::vector<VkImageMemoryBarrier2> m_images;
+    std::vector<VkBufferMemoryBarrier2> m_buffers;
+
+  public:
+    BarrierBatch &image(const VkImageMemoryBarrier2 &barrier);
+    BarrierBatch &image(VkImage image, VkImageLayout old_layout,
+                        VkImageLayout new_layout,
+                        VkPipelineStageFlags2 src_stages,
+                        VkAccessFlags2 src_access,
+                        VkPipelineStageFlags2 dst_stages,
+                        VkAccessFlags2 dst_access,
+                        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+    // stages and accesses picked from the layouts, false for a pair it
+    // does not know
+    bool transition(VkImage target, VkImageLayout old_layout,
+                    VkImageLayout new_layout);
+    BarrierBatch &buffer(const VkBufferMemoryBarrier2 &barrier);
+    BarrierBatch &append(const BarrierBatch &other);
+    BarrierBatch &buffer(VkBuffer buffer, VkPipelineStageFlags2 src_stages,
+                         VkAccessFlags2 src_access,
+                         VkPipelineStageFlags2 dst_stages,
+                         VkAccessFlags2 dst_access, VkDeviceSize offset = 0,
+                         VkDeviceSize size = VK_WHOLE_SIZE);
+    // record and clear, nothing is recorded when empty
+    void flush(VkCommandBuffer cmd);
+    void clear() {
+        m_images.clear();
+        m_buffers.clear();
+    }
+    bool empty() const { return m_images.empty() && m_buffers.empty(); }
+    size_t size() const { return m_images.size() + m_buffers.size(); }
+};
+
+// one layout transition recorded on its own, use BarrierBatch for several
 void transitionImageLayout(VkCommandBuffer &cmd, VkImage &image,
                            VkImageLayout old_layout, VkImageLayout new_layout);
 
@@ -78,4 +118,8 @@ struct QueueFamilyIndices {
     std::optional<uint32_t> present;
     std::optional<uint32_t> compute;
 };
+
+// fnv-1a, chain calls by passing the previous result as seed
+constexpr uint64_t hash_seed = 0xcbf29ce484222325ull;
+uint64_t hash(const void *data, size_t size, uint64_t seed = hash_seed);
 } // namespace vbr::util
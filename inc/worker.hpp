@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vbr::worker {
+
+// fixed set of threads running queued jobs in fifo order
+class Pool {
+  private:
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    // signals new jobs or stop to workers
+    std::condition_variable m_job_cv;
+    // signals idle to wait()
+    std::condition_variable m_idle_cv;
+    uint32_t m_running = 0;
+    bool m_stop = false;
+
+  private:
+    void run();
+
+  public:
+    // 0 picks one thread per core, minus the main thread
+    explicit Pool(uint32_t count = 0);
+    // finish queued jobs, then join
+    ~Pool();
+
+    void submit(std::function<void()> job);
+    // block until the queue is empty and no job runs
+    void wait();
+
+    uint32_t size() const { return static_cast<uint32_t>(m_threads.size()); }
+
+    Pool(Pool &) = delete;
+    Pool(Pool &&) = delete;
+    Pool &operator=(Pool &) = delete;
+    Pool &operator=(Pool &&) = delete;
+};
+
+} // namespace vbr::worker
@@ -0,0 +1,375 @@
+#include "../../inc/allocator.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <bit>
+
+namespace vbr::allocator {
+
+Tlsf::Tlsf(VkDeviceSize size) : m_size(size) {
+    m_heads.fill(invalid);
+    uint32_t node = newNode();
+    m_nodes[node].offset = 0;
+    m_nodes[node].size = size;
+    insertFree(node);
+}
+
+void Tlsf::mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl) {
+    if (size < small_size) {
+        fl = 0;
+        sl = static_cast<uint32_t>(size / (small_size / sl_count));
+        return;
+    }
+    uint32_t log2 = 63 - static_cast<uint32_t>(std::countl_zero(size));
+    fl = log2 - small_bits + 1;
+    sl = static_cast<uint32_t>(size >> (log2 - sl_bits)) ^ sl_count;
+}
+
+uint32_t Tlsf::newNode() {
+    if (!m_unused_nodes.empty()) {
+        uint32_t node = m_unused_nodes.back();
+        m_unused_nodes.pop_back();
+        m_nodes[node] = Node{};
+        return node;
+    }
+    m_nodes.emplace_back();
+    return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+void Tlsf::insertFree(uint32_t node) {
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(m_nodes[node].size, fl, sl);
+    uint32_t &head = m_heads[fl * sl_count + sl];
+
+    m_nodes[node].free = true;
+    m_nodes[node].prev_free = invalid;
+    m_nodes[node].next_free = head;
+    if (head != invalid) {
+        m_nodes[head].prev_free = node;
+    }
+    head = node;
+    m_fl_bitmap |= 1ull << fl;
+    m_sl_bitmap[fl] |= 1u << sl;
+}
+
+void Tlsf::removeFree(uint32_t node) {
+    Node &n = m_nodes[node];
+    if (n.prev_free != invalid) {
+        m_nodes[n.prev_free].next_free = n.next_free;
+    }
+    if (n.next_free != invalid) {
+        m_nodes[n.next_free].prev_free = n.prev_free;
+    }
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(n.size, fl, sl);
+    uint32_t &head = m_heads[fl * sl_count + sl];
+    if (head == node) {
+        head = n.next_free;
+        if (head == invalid) {
+            m_sl_bitmap[fl] &= ~(1u << sl);
+            if (m_sl_bitmap[fl] == 0) {
+                m_fl_bitmap &= ~(1ull << fl);
+            }
+        }
+    }
+    n.free = false;
+    n.prev_free = invalid;
+    n.next_free = invalid;
+}
+
+uint32_t Tlsf::findFree(VkDeviceSize size) {
+    // round up to the next class so every node in it is large enough
+    if (size < small_size) {
+        size += small_size / sl_count - 1;
+    } else {
+        uint32_t log2 = 63 - static_cast<uint32_t>(std::countl_zero(size));
+        size += (1ull << (log2 - sl_bits)) - 1;
+    }
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    mapping(size, fl, sl);
+    if (fl >= fl_count) {
+        return invalid;
+    }
+
+    uint32_t sl_map = sl < sl_count ? m_sl_bitmap[fl] & (~0u << sl) : 0;
+    if (sl_map == 0) {
+        uint64_t fl_map = fl + 1 < 64 ? m_fl_bitmap & (~0ull << (fl + 1)) : 0;
+        if (fl_map == 0) {
+            return invalid;
+        }
+        fl = static_cast<uint32_t>(std::countr_zero(fl_map));
+        sl_map = m_sl_bitmap[fl];
+    }
+    sl = static_cast<uint32_t>(std::countr_zero(sl_map));
+    return m_heads[fl * sl_count + sl];
+}
+
+void Tlsf::splitFront(uint32_t node, VkDeviceSize size) {
+    uint32_t front = newNode();
+    Node &n = m_nodes[node];
+    Node &f = m_nodes[front];
+    f.offset = n.offset;
+    f.size = size;
+    f.prev_phys = n.prev_phys;
+    f.next_phys = node;
+    if (n.prev_phys != invalid) {
+        m_nodes[n.prev_phys].next_phys = front;
+    }
+    n.prev_phys = front;
+    n.offset += size;
+    n.size -= size;
+    insertFree(front);
+}
+
+void Tlsf::splitBack(uint32_t node, VkDeviceSize size) {
+    uint32_t back = newNode();
+    Node &n = m_nodes[node];
+    Node &b = m_nodes[back];
+    b.offset = n.offset + size;
+    b.size = n.size - size;
+    b.prev_phys = node;
+    b.next_phys = n.next_phys;
+    if (n.next_phys != invalid) {
+        m_nodes[n.next_phys].prev_phys = back;
+    }
+    n.next_phys = back;
+    n.size = size;
+    insertFree(back);
+}
+
+void Tlsf::merge(uint32_t front, uint32_t back) {
+    Node &f = m_nodes[front];
+    Node &b = m_nodes[back];
+    f.size += b.size;
+    f.next_phys = b.next_phys;
+    if (b.next_phys != invalid) {
+        m_nodes[b.next_phys].prev_phys = front;
+    }
+    b = Node{};
+    m_unused_nodes.push_back(back);
+}
+
+uint32_t Tlsf::allocate(VkDeviceSize size, VkDeviceSize alignment,
+                        VkDeviceSize &offset) {
+    size = std::max<VkDeviceSize>(size, 1);
+    alignment = std::max<VkDeviceSize>(alignment, 1);
+    // worst case padding, any node found fits after alignment
+    uint32_t node = findFree(size + alignment - 1);
+    if (node == invalid) {
+        return invalid;
+    }
+    removeFree(node);
+
+    VkDeviceSize begin = m_nodes[node].offset;
+    VkDeviceSize aligned = (begin + alignment - 1) / alignment * alignment;
+    if (aligned != begin) {
+        splitFront(node, aligned - begin);
+    }
+    if (m_nodes[node].size > size) {
+        splitBack(node, size);
+    }
+
+    m_used += m_nodes[node].size;
+    m_count++;
+    offset = m_nodes[node].offset;
+    return node;
+}
+
+void Tlsf::free(uint32_t node) {
+    if (node >= m_nodes.size() || m_nodes[node].free) {
+        spdlog::warn("free invalid tlsf node {}", node);
+        return;
+    }
+    m_used -= m_nodes[node].size;
+    m_count--;
+
+    uint32_t next = m_nodes[node].next_phys;
+    if (next != invalid && m_nodes[next].free) {
+        removeFree(next);
+        merge(node, next);
+    }
+    uint32_t prev = m_nodes[node].prev_phys;
+    if (prev != invalid && m_nodes[prev].free) {
+        removeFree(prev);
+        merge(prev, node);
+        node = prev;
+    }
+    insertFree(node);
+}
+
+Allocator::Allocator(VkDevice &device,
+                     const VkPhysicalDeviceMemoryProperties &memory_properties,
+                     VkDeviceSize granularity, VkDeviceSize block_size)
+    : m_device(device), m_memory_properties(memory_properties),
+      m_block_size(block_size), m_granularity(granularity) {}
+
+Allocator::~Allocator() {
+    if (m_count != 0) {
+        spdlog::warn("{} device memory allocations leaked", m_count);
+    }
+    for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+        destroyBlock(i);
+    }
+    m_blocks.clear();
+    m_unused_blocks.clear();
+}
+
+VkDeviceSize Allocator::blockSize(uint32_t type) const {
+    uint32_t heap = m_memory_properties.memoryTypes[type].heapIndex;
+    // small heaps (e.g. bar memory) get smaller blocks
+    VkDeviceSize heap_part = m_memory_properties.memoryHeaps[heap].size / 8;
+    return std::min(m_block_size,
+                    std::max<VkDeviceSize>(heap_part, 1024 * 1024));
+}
+
+uint32_t Allocator::createBlock(uint32_t type, VkDeviceSize size, bool linear,
+                                bool dedicated) {
+    VkMemoryAllocateInfo info{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .allocationSize = size,
+        .memoryTypeIndex = type,
+    };
+    Block block;
+    if (VK_SUCCESS !=
+        vkAllocateMemory(m_device, &info, nullptr, &block.memory)) {
+        spdlog::error("failed to alloc device memory block");
+        return Tlsf::invalid;
+    }
+    if (m_memory_properties.memoryTypes[type].propertyFlags &
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (VK_SUCCESS != vkMapMemory(m_device, block.memory, 0, VK_WHOLE_SIZE,
+                                      0, &block.mapped)) {
+            spdlog::error("failed to map device memory block");
+            vkFreeMemory(m_device, block.memory, nullptr);
+            return Tlsf::invalid;
+        }
+    }
+    block.size = size;
+    block.type = type;
+    block.linear = linear;
+    if (!dedicated) {
+        block.tlsf = std::make_unique<Tlsf>(size);
+    }
+
+    if (!m_unused_blocks.empty()) {
+        uint32_t index = m_unused_blocks.back();
+        m_unused_blocks.pop_back();
+        m_blocks[index] = std::move(block);
+        return index;
+    }
+    m_blocks.push_back(std::move(block));
+    return static_cast<uint32_t>(m_blocks.size() - 1);
+}
+
+void Allocator::destroyBlock(uint32_t index) {
+    Block &block = m_blocks[index];
+    if (block.memory == VK_NULL_HANDLE) {
+        return;
+    }
+    if (block.mapped != nullptr) {
+        vkUnmapMemory(m_device, block.memory);
+    }
+    vkFreeMemory(m_device, block.memory, nullptr);
+    block = Block{};
+    m_unused_blocks.push_back(index);
+}
+
+bool Allocator::allocate(const VkMemoryRequirements &requirements,
+                         uint32_t type, bool linear, Allocation &allocation) {
+    // without granularity limit buffers and images can share blocks
+    if (m_granularity <= 1) {
+        linear = true;
+    }
+
+    VkDeviceSize block_size = blockSize(type);
+    if (requirements.size > block_size / 2) {
+        uint32_t index = createBlock(type, requirements.size, linear, true);
+        if (index == Tlsf::invalid) {
+            return false;
+        }
+        allocation.memory = m_blocks[index].memory;
+        allocation.offset = 0;
+        allocation.size = requirements.size;
+        allocation.mapped = m_blocks[index].mapped;
+        allocation.block = index;
+        allocation.node = Tlsf::invalid;
+        m_count++;
+        return true;
+    }
+
+    auto sub_allocate = [&](uint32_t index) {
+        Block &block = m_blocks[index];
+        VkDeviceSize offset = 0;
+        uint32_t node = block.tlsf->allocate(requirements.size,
+                                             requirements.alignment, offset);
+        if (node == Tlsf::invalid) {
+            return false;
+        }
+        allocation.memory = block.memory;
+        allocation.offset = offset;
+        allocation.size = requirements.size;
+        allocation.mapped =
+            block.mapped ? static_cast<char *>(block.mapped) + offset : nullptr;
+        allocation.block = index;
+        allocation.node = node;
+        m_count++;
+        return true;
+    };
+
+    for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+        const Block &block = m_blocks[i];
+        if (!block.tlsf || block.type != type || block.linear != linear) {
+            continue;
+        }
+        if (sub_allocate(i)) {
+            return true;
+        }
+    }
+
+    uint32_t index = createBlock(type, block_size, linear, false);
+    if (index == Tlsf::invalid) {
+        return false;
+    }
+    spdlog::info("new device memory block {} type {} size {}", index, type,
+                 block_size);
+    return sub_allocate(index);
+}
+
+void Allocator::free(Allocation &allocation) {
+    if (!allocation.valid() || allocation.block >= m_blocks.size()) {
+        return;
+    }
+    Block &block = m_blocks[allocation.block];
+    if (!block.tlsf) {
+        destroyBlock(allocation.block);
+    } else {
+        block.tlsf->free(allocation.node);
+        // keep one empty block around per pool so alloc/free pairs do not
+        // hit vkAllocateMemory every time
+        if (block.tlsf->empty()) {
+            bool has_spare = false;
+            for (uint32_t i = 0; i < m_blocks.size(); ++i) {
+                const Block &other = m_blocks[i];
+                if (i != allocation.block && other.tlsf &&
+                    other.type == block.type &&
+                    other.linear == block.linear && other.tlsf->empty()) {
+                    has_spare = true;
+                    break;
+                }
+            }
+            if (has_spare) {
+                destroyBlock(allocation.block);
+            }
+        }
+    }
+    m_count--;
+    allocation = Allocation{};
+}
+
+} // namespace vbr::allocator
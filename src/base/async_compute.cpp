@@ -0,0 +1,217 @@
+#include "../../inc/async_compute.hpp"
+#include "../../inc/device.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+namespace vbr::acompute {
+
+Scheduler::Scheduler(vbr::device::Device &device) : m_device(device) {}
+
+Scheduler::~Scheduler() {
+    if (*m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    wait(m_submitted);
+    destroySlots();
+    if (m_timeline != VK_NULL_HANDLE) {
+        vkDestroySemaphore(*m_device, m_timeline, nullptr);
+        m_timeline = VK_NULL_HANDLE;
+    }
+    if (m_graphics_timeline != VK_NULL_HANDLE) {
+        vkDestroySemaphore(*m_device, m_graphics_timeline, nullptr);
+        m_graphics_timeline = VK_NULL_HANDLE;
+    }
+}
+
+VkSemaphore Scheduler::createTimeline() {
+    VkSemaphoreTypeCreateInfo tinfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    VkSemaphoreCreateInfo sinfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &tinfo,
+        .flags = 0,
+    };
+    VkSemaphore ret = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreateSemaphore(*m_device, &sinfo, nullptr, &ret)) {
+        spdlog::error("failed to create compute timeline semaphore");
+        return VK_NULL_HANDLE;
+    }
+    return ret;
+}
+
+bool Scheduler::init(uint32_t family, VkQueue queue, uint32_t graphics_family,
+                     uint32_t frames) {
+    m_queue = queue;
+    m_family = family;
+    m_graphics_family = graphics_family;
+    if (async()) {
+        spdlog::info("async compute on family {}", family);
+    }
+    m_timeline = createTimeline();
+    m_graphics_timeline = createTimeline();
+    if (m_timeline == VK_NULL_HANDLE ||
+        m_graphics_timeline == VK_NULL_HANDLE) {
+        return false;
+    }
+    return initSlots(frames);
+}
+
+bool Scheduler::frames(uint32_t count) {
+    destroySlots();
+    return initSlots(count);
+}
+
+bool Scheduler::initSlots(uint32_t count) {
+    m_slots.resize(std::max(count, 1u));
+    for (auto &slot : m_slots) {
+        VkCommandPoolCreateInfo pinfo{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+            .queueFamilyIndex = m_family,
+        };
+        if (VK_SUCCESS !=
+            vkCreateCommandPool(*m_device, &pinfo, nullptr, &slot.pool)) {
+            spdlog::error("failed to create compute command pool");
+            return false;
+        }
+        VkCommandBufferAllocateInfo info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .commandPool = slot.pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        if (VK_SUCCESS != vkAllocateCommandBuffers(*m_device, &info,
+                                                   &slot.cmd)) {
+            spdlog::error("failed to create compute command buffer");
+            return false;
+        }
+    }
+    return true;
+}
+
+void Scheduler::destroySlots() {
+    // a pool frees its command buffers
+    for (auto &slot : m_slots) {
+        if (slot.pool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(*m_device, slot.pool, nullptr);
+        }
+    }
+    m_slots.clear();
+    m_recording = UINT32_MAX;
+}
+
+VkCommandBuffer Scheduler::begin(uint32_t frame) {
+    if (m_slots.empty()) {
+        return VK_NULL_HANDLE;
+    }
+    uint32_t index = frame % m_slots.size();
+    auto &slot = m_slots[index];
+    if (m_recording == index) {
+        return slot.cmd;
+    }
+    // normally long done, the graphics frame that waited on it is too
+    wait(slot.ticket);
+    vkResetCommandPool(*m_device, slot.pool, 0);
+    VkCommandBufferBeginInfo info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr,
+    };
+    if (VK_SUCCESS != vkBeginCommandBuffer(slot.cmd, &info)) {
+        spdlog::error("failed to begin compute command buffer");
+        return VK_NULL_HANDLE;
+    }
+    m_recording = index;
+    return slot.cmd;
+}
+
+Ticket Scheduler::submit(uint64_t after) {
+    if (m_recording >= m_slots.size()) {
+        return m_submitted;
+    }
+    auto &slot = m_slots[m_recording];
+    m_recording = UINT32_MAX;
+    if (VK_SUCCESS != vkEndCommandBuffer(slot.cmd)) {
+        spdlog::error("failed to end compute command buffer");
+        return m_submitted;
+    }
+
+    Ticket ticket = m_next;
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkTimelineSemaphoreSubmitInfo tinfo{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = after > 0 ? 1u : 0u,
+        .pWaitSemaphoreValues = &after,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &ticket,
+    };
+    VkSubmitInfo info{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &tinfo,
+        .waitSemaphoreCount = after > 0 ? 1u : 0u,
+        .pWaitSemaphores = &m_graphics_timeline,
+        .pWaitDstStageMask = &wait_stage,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &slot.cmd,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &m_timeline,
+    };
+    if (VK_SUCCESS != vkQueueSubmit(m_queue, 1, &info, VK_NULL_HANDLE)) {
+        spdlog::error("failed to submit compute batch");
+        return m_submitted;
+    }
+    m_next++;
+    slot.ticket = ticket;
+    m_submitted = ticket;
+    return ticket;
+}
+
+void Scheduler::consume(Ticket ticket, VkPipelineStageFlags stages) {
+    // tickets complete in order, the latest covers the earlier ones
+    m_consume = std::max(m_consume, ticket);
+    m_consume_stages |= stages;
+}
+
+Ticket Scheduler::takeConsume(VkPipelineStageFlags &stages) {
+    Ticket ret = m_consume;
+    stages = m_consume_stages;
+    m_consume = 0;
+    m_consume_stages = 0;
+    return ret;
+}
+
+bool Scheduler::done(Ticket ticket) {
+    if (ticket > m_submitted) {
+        return false;
+    }
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(*m_device, m_timeline, &value);
+    return value >= ticket;
+}
+
+void Scheduler::wait(Ticket ticket) {
+    if (ticket == 0 || ticket > m_submitted) {
+        return;
+    }
+    VkSemaphoreWaitInfo info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .semaphoreCount = 1,
+        .pSemaphores = &m_timeline,
+        .pValues = &ticket,
+    };
+    if (VK_SUCCESS != vkWaitSemaphores(*m_device, &info, UINT64_MAX)) {
+        spdlog::warn("failed to wait compute batch {}", ticket);
+    }
+}
+
+} // namespace vbr::acompute
@@ -1,4 +1,6 @@
 #include "../../inc/base.hpp"
+#include "../../inc/compute_pipeline.hpp"
+#include "../../inc/draw_queue.hpp"
 #include "../../inc/graphics_pipeline.hpp"
 #include "spdlog/spdlog.h"
 #include "vulkan/vulkan_core.h"
@@ -9,6 +11,7 @@
 #include <SDL3/SDL_video.h>
 #include <SDL3/SDL_vulkan.h>
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <memory>
@@ -20,7 +23,8 @@ const std::vector<char const *> validation_layers = {
     "VK_LAYER_KHRONOS_validation",
 };
 
-App::App(const glm::ivec2 &window_size) : m_window_size(window_size) {}
+App::App(const glm::ivec2 &window_size, bool headless)
+    : m_headless(headless), m_window_size(window_size) {}
 App::~App() { quit(); }
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL
@@ -85,13 +89,18 @@ bool App::initInstance() {
         }
     }
 
-    // check extension
+    // check extension, headless mode needs no surface extension
     uint32_t sdl_extension_count = 0;
-    auto sdl_extensions =
-        SDL_Vulkan_GetInstanceExtensions(&sdl_extension_count);
+    char const *const *sdl_extensions = nullptr;
+    if (!m_headless) {
+        sdl_extensions = SDL_Vulkan_GetInstanceExtensions(&sdl_extension_count);
+    }
     // required extensions
-    std::vector<char const *> required_extensions(
-        sdl_extensions, sdl_extensions + sdl_extension_count);
+    std::vector<char const *> required_extensions;
+    if (sdl_extensions) {
+        required_extensions.assign(sdl_extensions,
+                                   sdl_extensions + sdl_extension_count);
+    }
     if (m_debug) {
         required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
@@ -201,41 +210,53 @@ bool App::init(SDL_InitFlags flags, VkSampleCountFlagBits sample_count) {
         return false;
     }
 
-    SDL_Window *raw_window = SDL_CreateWindow(
-        "vbr", m_window_size.x, m_window_size.y, SDL_WINDOW_VULKAN);
+    if (!m_headless) {
+        SDL_Window *raw_window = SDL_CreateWindow(
+            "vbr", m_window_size.x, m_window_size.y, SDL_WINDOW_VULKAN);
 
-    if (raw_window == nullptr) {
-        spdlog::error("sdl create window failed {}", SDL_GetError());
-        return false;
-    }
+        if (raw_window == nullptr) {
+            spdlog::error("sdl create window failed {}", SDL_GetError());
+            return false;
+        }
 
-    m_window = std::unique_ptr<SDL_Window, WindowDeleter>(raw_window);
+        m_window = std::unique_ptr<SDL_Window, WindowDeleter>(raw_window);
+    }
 
     if (!initInstance()) {
         return false;
     }
-    if (!initSurface()) {
+    if (!m_headless && !initSurface()) {
         spdlog::error("sdl init vulkan surface failed {}", SDL_GetError());
         return false;
     }
 
-    m_vk_device = std::make_unique<vbr::device::Device>(m_vk_surface,
-                                                        sample_count, m_debug);
+    m_vk_device = std::make_unique<vbr::device::Device>(
+        m_vk_surface, sample_count, m_debug, m_frames_in_flight,
+        m_pipeline_cache_path);
     if (!m_vk_device->init(m_vk_instance)) {
         spdlog::error("unable to create logic device");
         return false;
     }
 
-    m_vk_swapchain = std::make_unique<vbr::swapchain::Swapchain>(*m_vk_device);
-    if (!m_vk_swapchain->init(m_window_size)) {
-        spdlog::error("unable to create swapchain");
-        return false;
+    if (m_headless) {
+        if (!m_vk_device->initOffscreen(m_window_size)) {
+            spdlog::error("unable to create offscreen targets");
+            return false;
+        }
+    } else {
+        m_vk_swapchain =
+            std::make_unique<vbr::swapchain::Swapchain>(*m_vk_device);
+        if (!m_vk_swapchain->init(m_window_size)) {
+            spdlog::error("unable to create swapchain");
+            return false;
+        }
     }
+    m_fps_start = std::chrono::steady_clock::now();
     spdlog::info("app init done");
     return true;
 }
 
-bool App::begin(float r, float g, float b, float a) {
+bool App::beginFrame() {
     if (VK_SUCCESS != vkWaitForFences(**m_vk_device, 1,
                                       &m_vk_device->inFlightFence(), VK_TRUE,
                                       UINT64_MAX)) {
@@ -243,40 +264,74 @@ bool App::begin(float r, float g, float b, float a) {
         return false;
     }
 
-    VkResult acquire_ret = m_vk_swapchain->acquireNext();
-    if (acquire_ret == VK_ERROR_OUT_OF_DATE_KHR) {
-        spdlog::info("recreate swapchain");
-        updateWindowSize();
-        if (!m_vk_swapchain->init(m_window_size)) {
-            spdlog::error("failed to recreate swapchain");
+    if (!m_headless) {
+        VkResult acquire_ret = m_vk_swapchain->acquireNext();
+        if (acquire_ret == VK_ERROR_OUT_OF_DATE_KHR) {
+            spdlog::info("recreate swapchain");
+            updateWindowSize();
+            if (!m_vk_swapchain->init(m_window_size)) {
+                spdlog::error("failed to recreate swapchain");
+                return false;
+            }
+            return false;
+        } else if (VK_SUCCESS != acquire_ret &&
+                   VK_SUBOPTIMAL_KHR != acquire_ret) {
+            spdlog::warn("failed to get current image index");
             return false;
         }
-        return false;
-    } else if (VK_SUCCESS != acquire_ret && VK_SUBOPTIMAL_KHR != acquire_ret) {
-        spdlog::warn("failed to get current image index");
-        return false;
     }
     vkResetFences(**m_vk_device, 1, &m_vk_device->inFlightFence());
-    vkResetCommandBuffer(m_vk_device->cmd(), 0);
+    vkResetCommandPool(**m_vk_device, m_vk_device->cmdPool(), 0);
+    m_vk_device->frameDescriptors().reset();
+    m_vk_device->recorder().begin(m_vk_device->frameIndex());
+    m_state_calls = m_frame_state_calls;
+    m_elided_state_calls = m_frame_elided_state_calls;
+    m_frame_state_calls = 0;
+    m_frame_elided_state_calls = 0;
+    m_bound = {};
+    m_vk_device->uniformRing().begin(m_vk_device->frameIndex());
+    // push out uploads queued since last frame, the submit waits on them
+    m_upload_ticket = m_vk_device->uploader().flush();
 
     VkCommandBufferBeginInfo info{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .pNext = nullptr,
-        .flags = 0,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
         .pInheritanceInfo = nullptr,
     };
     if (VK_SUCCESS != vkBeginCommandBuffer(m_vk_device->cmd(), &info)) {
         return false;
     }
+    // the fence above finished the slot's timestamps of last time
+    auto &profiler = m_vk_device->profiler();
+    profiler.begin(m_vk_device->cmd(), m_vk_device->frameIndex());
+    m_frame_scope = profiler.push(m_vk_device->cmd(), "frame");
+    m_vk_device->pipelineStats().begin(m_vk_device->cmd(),
+                                       m_vk_device->frameIndex());
+    // take over buffers and images released by the transfer queue
+    m_vk_device->uploader().acquire(m_vk_device->cmd());
+    return true;
+}
+
+bool App::begin(float r, float g, float b, float a, VkRenderingFlags flags) {
+    if (!beginFrame()) {
+        return false;
+    }
+    beginRendering(r, g, b, a, flags);
+    return true;
+}
 
-    vbr::util::transitionImageLayout(
-        m_vk_device->cmd(), m_vk_swapchain->currentImage(),
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+void App::beginRendering(float r, float g, float b, float a,
+                         VkRenderingFlags flags) {
+    m_pass_scope = m_vk_device->profiler().push(m_vk_device->cmd(), "pass");
+    vbr::util::transitionImageLayout(m_vk_device->cmd(), targetImage(),
+                                     VK_IMAGE_LAYOUT_UNDEFINED,
+                                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 
     VkRenderingAttachmentInfo attachment_info{
         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
         .pNext = nullptr,
-        .imageView = m_vk_swapchain->currentView(),
+        .imageView = targetView(),
         .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .resolveMode = VK_RESOLVE_MODE_NONE,
         .resolveImageView = nullptr,
@@ -293,19 +348,39 @@ bool App::begin(float r, float g, float b, float a) {
     };
 
     if (m_vk_device->sampleCount() != VK_SAMPLE_COUNT_1_BIT &&
-        m_vk_swapchain->colorView() != VK_NULL_HANDLE) {
-        attachment_info.imageView = m_vk_swapchain->colorView();
+        targetColorView() != VK_NULL_HANDLE) {
+        attachment_info.imageView = targetColorView();
         attachment_info.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
-        attachment_info.resolveImageView = m_vk_swapchain->currentView();
+        attachment_info.resolveImageView = targetView();
         attachment_info.resolveImageLayout =
             VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
         attachment_info.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     }
 
+    VkRenderingAttachmentInfo depth_info{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .pNext = nullptr,
+        .imageView = m_depth_view,
+        .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        .resolveMode = VK_RESOLVE_MODE_NONE,
+        .resolveImageView = nullptr,
+        .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .clearValue =
+            {
+                .depthStencil =
+                    {
+                        .depth = m_depth_clear,
+                        .stencil = 0,
+                    },
+            },
+    };
+
     VkRenderingInfo rinfo{
         .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
         .pNext = nullptr,
-        .flags = 0,
+        .flags = flags,
         .renderArea =
             {
                 .offset =
@@ -324,38 +399,89 @@ bool App::begin(float r, float g, float b, float a) {
         .viewMask = 0,
         .colorAttachmentCount = 1,
         .pColorAttachments = &attachment_info,
-        .pDepthAttachment = nullptr,
+        .pDepthAttachment =
+            m_depth_view != VK_NULL_HANDLE ? &depth_info : nullptr,
         .pStencilAttachment = nullptr,
     };
     vkCmdBeginRendering(m_vk_device->cmd(), &rinfo);
-
-    return true;
+    m_bound = {};
 }
 
 bool App::end() {
+    endRendering();
+    return endFrame();
+}
+
+void App::endRendering() {
     vkCmdEndRendering(m_vk_device->cmd());
 
-    vbr::util::transitionImageLayout(m_vk_device->cmd(),
-                                     m_vk_swapchain->currentImage(),
-                                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                                     VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    // offscreen targets are kept for read back instead of present
+    vbr::util::transitionImageLayout(
+        m_vk_device->cmd(), targetImage(),
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                   : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    m_vk_device->profiler().pop(m_vk_device->cmd(), m_pass_scope);
+}
 
+bool App::endFrame() {
+    m_vk_device->profiler().pop(m_vk_device->cmd(), m_frame_scope);
     if (VK_SUCCESS != vkEndCommandBuffer(m_vk_device->cmd())) {
         return false;
     }
 
-    VkPipelineStageFlags wait_stage =
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    // binary semaphores ignore their value in the timeline info
+    std::array<VkSemaphore, 3> wait_semaphores{};
+    std::array<VkPipelineStageFlags, 3> wait_stages{};
+    std::array<uint64_t, 3> wait_values{};
+    uint32_t wait_count = 0;
+    if (!m_headless) {
+        wait_semaphores[wait_count] = m_vk_device->imageAvailable();
+        wait_stages[wait_count] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        wait_count++;
+    }
+    if (m_upload_ticket > 0) {
+        wait_semaphores[wait_count] = m_vk_device->uploader().timeline();
+        wait_stages[wait_count] = vbr::upload::Uploader::consume_stages;
+        wait_values[wait_count] = m_upload_ticket;
+        wait_count++;
+    }
+    // async compute results this frame reads
+    auto &compute = m_vk_device->asyncCompute();
+    VkPipelineStageFlags compute_stages = 0;
+    vbr::acompute::Ticket compute_ticket = compute.takeConsume(compute_stages);
+    if (compute_ticket > 0) {
+        wait_semaphores[wait_count] = compute.timeline();
+        wait_stages[wait_count] = compute_stages;
+        wait_values[wait_count] = compute_ticket;
+        wait_count++;
+    }
+    // the graphics timeline tells async compute when the frame is done
+    std::array<VkSemaphore, 2> signal_semaphores{compute.graphicsTimeline()};
+    std::array<uint64_t, 2> signal_values{compute.graphicsValue()};
+    uint32_t signal_count = 1;
+    if (!m_headless) {
+        signal_semaphores[signal_count] = m_vk_swapchain->renderDone();
+        signal_count++;
+    }
+    VkTimelineSemaphoreSubmitInfo timeline_info{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = wait_count,
+        .pWaitSemaphoreValues = wait_values.data(),
+        .signalSemaphoreValueCount = signal_count,
+        .pSignalSemaphoreValues = signal_values.data(),
+    };
     VkSubmitInfo submit_info{
         .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-        .pNext = nullptr,
-        .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &m_vk_device->imageAvailable(),
-        .pWaitDstStageMask = &wait_stage,
+        .pNext = &timeline_info,
+        .waitSemaphoreCount = wait_count,
+        .pWaitSemaphores = wait_semaphores.data(),
+        .pWaitDstStageMask = wait_stages.data(),
         .commandBufferCount = 1,
         .pCommandBuffers = &m_vk_device->cmd(),
-        .signalSemaphoreCount = 1,
-        .pSignalSemaphores = &m_vk_device->renderDone(),
+        .signalSemaphoreCount = signal_count,
+        .pSignalSemaphores = signal_semaphores.data(),
     };
     if (VK_SUCCESS != vkQueueSubmit(m_vk_device->graphicsQueue(), 1,
                                     &submit_info,
@@ -363,13 +489,20 @@ bool App::end() {
         spdlog::error("failed to submit queue");
         return false;
     }
+    compute.graphicsSubmitted();
+    // the next frame records while this one is still on the gpu
+    m_vk_device->nextFrame();
+    countFrame();
+    if (m_headless) {
+        return true;
+    }
 
     uint32_t current_index = m_vk_swapchain->currentIndex();
     VkPresentInfoKHR present_info{
         .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
         .pNext = nullptr,
         .waitSemaphoreCount = 1,
-        .pWaitSemaphores = &m_vk_device->renderDone(),
+        .pWaitSemaphores = &m_vk_swapchain->renderDone(),
         .swapchainCount = 1,
         .pSwapchains = &**m_vk_swapchain,
         .pImageIndices = &current_index,
@@ -392,6 +525,73 @@ bool App::end() {
     return true;
 };
 
+void App::countFrame() {
+    m_fps_frames++;
+    auto now = std::chrono::steady_clock::now();
+    float elapsed =
+        std::chrono::duration<float, std::chrono::seconds::period>(
+            now - m_fps_start)
+            .count();
+    if (elapsed < 1.0f) {
+        return;
+    }
+    m_fps = static_cast<float>(m_fps_frames) / elapsed;
+    m_fps_frames = 0;
+    m_fps_start = now;
+    if (m_headless) {
+        // no window title to show it on
+        spdlog::info("{:.1f} fps, {} of {} state calls elided", m_fps,
+                     m_elided_state_calls, m_state_calls);
+    }
+}
+
+VkImage &App::targetImage() {
+    if (m_headless) {
+        return m_vk_device->offscreenImage();
+    }
+    return m_vk_swapchain->currentImage();
+}
+
+VkImageView &App::targetView() {
+    if (m_headless) {
+        return m_vk_device->offscreenView();
+    }
+    return m_vk_swapchain->currentView();
+}
+
+VkImageUsageFlags App::targetUsage() const {
+    if (m_headless) {
+        return vbr::device::offscreen_usage;
+    }
+    return m_vk_swapchain->usage();
+}
+
+VkImageView App::targetColorView() {
+    if (m_headless) {
+        return m_vk_device->offscreenColorView();
+    }
+    return m_vk_swapchain->colorView();
+}
+
+uint32_t App::beginQuery(vbr::pstats::Counters *counters) {
+    if (counters == nullptr) {
+        return vbr::pstats::invalid_query;
+    }
+    return m_vk_device->pipelineStats().push(m_vk_device->cmd(), *counters);
+}
+
+void App::endQuery(uint32_t query) {
+    m_vk_device->pipelineStats().pop(m_vk_device->cmd(), query);
+}
+
+bool App::elide(bool current) {
+    m_frame_state_calls++;
+    if (current) {
+        m_frame_elided_state_calls++;
+    }
+    return current;
+}
+
 void App::setViewport(float w, float h, float x, float y, float min,
                       float max) {
     VkViewport v{
@@ -408,6 +608,14 @@ void App::setViewport(float w, float h, float x, float y, float min,
     if (h == 0.0f) {
         v.height = static_cast<float>(m_window_size.y);
     }
+    const auto &bound = m_bound.viewport;
+    if (elide(bound && bound->x == v.x && bound->y == v.y &&
+              bound->width == v.width && bound->height == v.height &&
+              bound->minDepth == v.minDepth &&
+              bound->maxDepth == v.maxDepth)) {
+        return;
+    }
+    m_bound.viewport = v;
     vkCmdSetViewport(m_vk_device->cmd(), 0, 1, &v);
 }
 
@@ -432,46 +640,272 @@ void App::setScissor(uint32_t w, uint32_t h, int32_t x, int32_t y) {
     if (h == 0) {
         v.extent.height = m_window_size.y;
     }
+    const auto &bound = m_bound.scissor;
+    if (elide(bound && bound->offset.x == v.offset.x &&
+              bound->offset.y == v.offset.y &&
+              bound->extent.width == v.extent.width &&
+              bound->extent.height == v.extent.height)) {
+        return;
+    }
+    m_bound.scissor = v;
     vkCmdSetScissor(m_vk_device->cmd(), 0, 1, &v);
 }
 
-void App::bindPipeline(vbr::gpipeline::Pipeline &pipeline) {
-    if (*pipeline != VK_NULL_HANDLE) {
-        vkCmdBindPipeline(m_vk_device->cmd(), VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          *pipeline);
+bool App::bindPipeline(vbr::gpipeline::Pipeline &pipeline) {
+    VkPipeline handle = *pipeline;
+    vbr::pstats::Counters *counters = &pipeline.statistics();
+    // still compiling, draw with the fallback if it has one
+    if (handle == VK_NULL_HANDLE && pipeline.fallback() != nullptr) {
+        handle = **pipeline.fallback();
+        counters = &pipeline.fallback()->statistics();
+    }
+    if (handle == VK_NULL_HANDLE) {
+        return false;
+    }
+    m_bound.pipeline_counters = counters;
+    if (elide(handle == m_bound.pipeline)) {
+        return true;
+    }
+    m_bound.pipeline = handle;
+    vkCmdBindPipeline(m_vk_device->cmd(), VK_PIPELINE_BIND_POINT_GRAPHICS,
+                      handle);
+    return true;
+}
+
+bool App::bindPipeline(vbr::cpipeline::Pipeline &pipeline) {
+    VkPipeline handle = *pipeline;
+    if (handle == VK_NULL_HANDLE) {
+        return false;
+    }
+    m_bound.compute_counters = &pipeline.statistics();
+    if (elide(handle == m_bound.compute)) {
+        return true;
     }
+    m_bound.compute = handle;
+    vkCmdBindPipeline(m_vk_device->cmd(), VK_PIPELINE_BIND_POINT_COMPUTE,
+                      handle);
+    return true;
+}
+
+void App::dispatch(uint32_t x, uint32_t y, uint32_t z) {
+    uint32_t query = beginQuery(m_bound.compute_counters);
+    vkCmdDispatch(m_vk_device->cmd(), x, y, z);
+    endQuery(query);
+}
+
+void App::dispatchIndirect(vbr::buffer::Buffer &buffer, VkDeviceSize offset) {
+    uint32_t query = beginQuery(m_bound.compute_counters);
+    vkCmdDispatchIndirect(m_vk_device->cmd(), buffer.buffer, offset);
+    endQuery(query);
+}
+
+void App::bindVertex(vbr::buffer::Buffer &buffer, uint32_t binding,
+                     VkDeviceSize offset) {
+    if (binding >= max_vertex_bindings) {
+        spdlog::error("vertex binding {} exceeds {}", binding,
+                      max_vertex_bindings);
+        return;
+    }
+    if (elide(buffer.buffer == m_bound.vertex[binding] &&
+              offset == m_bound.vertex_offsets[binding])) {
+        return;
+    }
+    m_bound.vertex[binding] = buffer.buffer;
+    m_bound.vertex_offsets[binding] = offset;
+    vkCmdBindVertexBuffers(m_vk_device->cmd(), binding, 1, &buffer.buffer,
+                           &offset);
+}
+
+void App::bindVertex(uint32_t first, std::span<const VkBuffer> buffers,
+                     std::span<const VkDeviceSize> offsets) {
+    if (buffers.empty()) {
+        return;
+    }
+    if (first + buffers.size() > max_vertex_bindings) {
+        spdlog::error("vertex bindings {} to {} exceed {}", first,
+                      first + buffers.size() - 1, max_vertex_bindings);
+        return;
+    }
+    std::array<VkDeviceSize, max_vertex_bindings> full{};
+    std::copy_n(offsets.begin(), std::min(offsets.size(), buffers.size()),
+                full.begin());
+    bool current = true;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        current = current && buffers[i] == m_bound.vertex[first + i] &&
+                  full[i] == m_bound.vertex_offsets[first + i];
+    }
+    if (elide(current)) {
+        return;
+    }
+    std::copy(buffers.begin(), buffers.end(), m_bound.vertex.begin() + first);
+    std::copy_n(full.begin(), buffers.size(),
+                m_bound.vertex_offsets.begin() + first);
+    vkCmdBindVertexBuffers(m_vk_device->cmd(), first,
+                           static_cast<uint32_t>(buffers.size()),
+                           buffers.data(), full.data());
 }
 
-void App::bindVertex(vbr::buffer::Buffer &buffer) {
-    VkBuffer buffers = buffer.buffer;
-    VkDeviceSize offsets = 0;
-    vkCmdBindVertexBuffers(m_vk_device->cmd(), 0, 1, &buffers, &offsets);
+void App::draw(uint32_t count, uint32_t instances, uint32_t first,
+               uint32_t first_instance) {
+    uint32_t query = beginQuery(m_bound.pipeline_counters);
+    vkCmdDraw(m_vk_device->cmd(), count, instances, first, first_instance);
+    endQuery(query);
 }
 
-void App::draw(uint32_t count) {
-    vkCmdDraw(m_vk_device->cmd(), count, 1, 0, 0); // TODO test for now
+bool App::recordParallel(uint32_t count, const vbr::record::Job &job,
+                         uint32_t min_chunk) {
+    // the secondaries must match the attachments of the pass
+    vbr::record::Inheritance inheritance{
+        .color_formats = {m_vk_device->format()},
+        .depth_format = m_depth_view != VK_NULL_HANDLE ? m_depth_format
+                                                       : VK_FORMAT_UNDEFINED,
+        .samples = m_vk_device->sampleCount(),
+    };
+    // state of the primary is undefined after executing secondaries
+    m_bound = {};
+    return m_vk_device->recorder().record(m_vk_device->cmd(), inheritance,
+                                          count, job, min_chunk);
 }
 
 void App::bindIndex(vbr::buffer::Buffer &buffer) {
+    if (elide(buffer.buffer == m_bound.index)) {
+        return;
+    }
+    m_bound.index = buffer.buffer;
     // use 32
     vkCmdBindIndexBuffer(m_vk_device->cmd(), buffer.buffer, 0,
                          VK_INDEX_TYPE_UINT32);
 }
 
-void App::drawIndex(uint32_t count) {
-    vkCmdDrawIndexed(m_vk_device->cmd(), count, 1, 0, 0, 0);
+void App::drawIndex(uint32_t count, uint32_t instances, uint32_t first,
+                    int32_t vertex_offset, uint32_t first_instance) {
+    uint32_t query = beginQuery(m_bound.pipeline_counters);
+    vkCmdDrawIndexed(m_vk_device->cmd(), count, instances, first,
+                     vertex_offset, first_instance);
+    endQuery(query);
+}
+
+void App::drawIndexedIndirect(vbr::indirect::Buffer &buffer, uint32_t draws,
+                              uint32_t first) {
+    if (first >= buffer.capacity()) {
+        return;
+    }
+    draws = std::min(draws, buffer.capacity() - first);
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize offset = buffer.commandOffset() + first * stride;
+    uint32_t batch = 1;
+    if (m_vk_device->multiDrawIndirect()) {
+        batch = m_vk_device->propreties().limits.maxDrawIndirectCount;
+    }
+    // one query for every call of the range
+    uint32_t query = beginQuery(m_bound.pipeline_counters);
+    while (draws > 0) {
+        uint32_t n = std::min(draws, batch);
+        vkCmdDrawIndexedIndirect(m_vk_device->cmd(), buffer.buffer(), offset,
+                                 n, stride);
+        offset += n * stride;
+        draws -= n;
+    }
+    endQuery(query);
+}
+
+bool App::drawIndexedIndirectCount(vbr::indirect::Buffer &buffer,
+                                   uint32_t max_draws) {
+    if (!m_vk_device->drawIndirectCount()) {
+        spdlog::error("device lacks draw indirect count");
+        return false;
+    }
+    max_draws = std::min(max_draws, buffer.capacity());
+    uint32_t query = beginQuery(m_bound.pipeline_counters);
+    vkCmdDrawIndexedIndirectCount(
+        m_vk_device->cmd(), buffer.buffer(), buffer.commandOffset(),
+        buffer.buffer(), buffer.countOffset(), max_draws,
+        sizeof(VkDrawIndexedIndirectCommand));
+    endQuery(query);
+    return true;
 }
 
 void App::bindDescriptorSet(const VkDescriptorSet &set,
-                            const VkPipelineLayout &layout) {
-    vkCmdBindDescriptorSets(m_vk_device->cmd(), VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            layout, 0, 1, &set, 0, nullptr);
+                            const VkPipelineLayout &layout,
+                            const std::vector<uint32_t> &dynamic_offsets,
+                            VkPipelineBindPoint point) {
+    // a pipeline with another layout disturbs the set, layout tells it,
+    // compute sets are bound a few times a frame and not tracked
+    if (point == VK_PIPELINE_BIND_POINT_GRAPHICS) {
+        uint32_t count = static_cast<uint32_t>(dynamic_offsets.size());
+        bool tracked = count <= max_dynamic_offsets;
+        if (elide(tracked && set == m_bound.set &&
+                  layout == m_bound.layout &&
+                  count == m_bound.dynamic_offset_count &&
+                  std::equal(dynamic_offsets.begin(), dynamic_offsets.end(),
+                             m_bound.dynamic_offsets.begin()))) {
+            return;
+        }
+        // copied into the fixed array, no allocation per bind
+        m_bound.set = tracked ? set : VK_NULL_HANDLE;
+        m_bound.layout = tracked ? layout : VK_NULL_HANDLE;
+        m_bound.dynamic_offset_count = tracked ? count : 0;
+        if (tracked) {
+            std::copy(dynamic_offsets.begin(), dynamic_offsets.end(),
+                      m_bound.dynamic_offsets.begin());
+        }
+    }
+    vkCmdBindDescriptorSets(m_vk_device->cmd(), point, layout, 0, 1, &set,
+                            static_cast<uint32_t>(dynamic_offsets.size()),
+                            dynamic_offsets.data());
 }
 
 void App::pushConstant(VkPipelineLayout &layout, VkShaderStageFlags stage,
                        uint32_t offset, uint32_t size, void *data) {
     vkCmdPushConstants(m_vk_device->cmd(), layout, stage, offset, size, data);
 }
+
+void App::submit(vbr::draw::Queue &queue) {
+    queue.sort();
+    std::vector<uint32_t> offsets;
+    for (const auto &item : queue.items()) {
+        const auto &packet = queue.packet(item.packet);
+        if (packet.pipeline == nullptr || !bindPipeline(*packet.pipeline)) {
+            continue;
+        }
+        if (packet.set != VK_NULL_HANDLE) {
+            offsets.assign(packet.dynamic_offsets.begin(),
+                           packet.dynamic_offsets.begin() +
+                               packet.dynamic_offset_count);
+            bindDescriptorSet(packet.set, packet.layout, offsets);
+        }
+        if (packet.push_size > 0) {
+            vkCmdPushConstants(m_vk_device->cmd(), packet.layout,
+                               packet.push_stages, 0, packet.push_size,
+                               queue.pushData(item.packet));
+        }
+        if (packet.vertex != nullptr) {
+            bindVertex(*packet.vertex);
+        }
+        if (packet.index != nullptr) {
+            bindIndex(*packet.index);
+            drawIndex(packet.count, packet.instances);
+        } else {
+            draw(packet.count, packet.instances);
+        }
+    }
+}
+
+uint32_t App::frameIndex() const { return m_vk_device->frameIndex(); }
+
+void App::reportProfile() const {
+    m_vk_device->profiler().report("graphics");
+    m_vk_device->uploader().profiler().report("upload");
+}
+
+bool App::framesInFlight(uint32_t count) {
+    m_frames_in_flight = std::max(count, 1u);
+    if (m_vk_device) {
+        return m_vk_device->framesInFlight(m_frames_in_flight);
+    }
+    return true;
+}
+
 void App::update() {}
 
 void App::event(SDL_Event *event) {
@@ -0,0 +1,214 @@
+#include "../../inc/bindless.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+
+namespace vbr::bindless {
+
+constexpr std::array<VkDescriptorType, 3> kind_types = {
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+};
+
+Table::Table(VkDevice &device) : m_device(device) {}
+
+Table::~Table() { destroy(); }
+
+bool Table::init(uint32_t images, uint32_t samplers, uint32_t buffers) {
+    m_slots[static_cast<uint32_t>(Kind::image)].capacity = images;
+    m_slots[static_cast<uint32_t>(Kind::sampler)].capacity = samplers;
+    m_slots[static_cast<uint32_t>(Kind::buffer)].capacity = buffers;
+    for (auto &slots : m_slots) {
+        slots.live.assign(slots.capacity, false);
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings;
+    std::array<VkDescriptorBindingFlags, 3> binding_flags;
+    std::array<VkDescriptorPoolSize, 3> sizes;
+    for (uint32_t i = 0; i < bindings.size(); ++i) {
+        bindings[i] = {
+            .binding = i,
+            .descriptorType = kind_types[i],
+            .descriptorCount = m_slots[i].capacity,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .pImmutableSamplers = nullptr,
+        };
+        // slots are written while frames using other slots are in flight
+        binding_flags[i] =
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        sizes[i] = {
+            .type = kind_types[i],
+            .descriptorCount = m_slots[i].capacity,
+        };
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info{
+        .sType =
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .pNext = nullptr,
+        .bindingCount = static_cast<uint32_t>(binding_flags.size()),
+        .pBindingFlags = binding_flags.data(),
+    };
+    VkDescriptorSetLayoutCreateInfo layout_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &flags_info,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = static_cast<uint32_t>(bindings.size()),
+        .pBindings = bindings.data(),
+    };
+    if (VK_SUCCESS != vkCreateDescriptorSetLayout(m_device, &layout_info,
+                                                  nullptr, &m_layout)) {
+        spdlog::error("failed to create bindless set layout");
+        return false;
+    }
+
+    VkDescriptorPoolCreateInfo pool_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data(),
+    };
+    if (VK_SUCCESS !=
+        vkCreateDescriptorPool(m_device, &pool_info, nullptr, &m_pool)) {
+        spdlog::error("failed to create bindless descriptor pool");
+        return false;
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = m_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &m_layout,
+    };
+    if (VK_SUCCESS != vkAllocateDescriptorSets(m_device, &alloc_info, &m_set)) {
+        spdlog::error("failed to allocate bindless descriptor set");
+        return false;
+    }
+    spdlog::info("bindless table with {} images, {} samplers, {} buffers",
+                 images, samplers, buffers);
+    return true;
+}
+
+void Table::destroy() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    // the set goes with its pool
+    if (m_pool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(m_device, m_pool, nullptr);
+        m_pool = VK_NULL_HANDLE;
+        m_set = VK_NULL_HANDLE;
+    }
+    if (m_layout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(m_device, m_layout, nullptr);
+        m_layout = VK_NULL_HANDLE;
+    }
+    for (auto &slots : m_slots) {
+        slots.next = 0;
+        slots.free.clear();
+        slots.live.clear();
+    }
+}
+
+uint32_t Table::take(Kind kind) {
+    auto &slots = m_slots[static_cast<uint32_t>(kind)];
+    uint32_t index = invalid_index;
+    if (!slots.free.empty()) {
+        index = slots.free.back();
+        slots.free.pop_back();
+    } else if (slots.next < slots.capacity) {
+        index = slots.next++;
+    }
+    if (index != invalid_index) {
+        slots.live[index] = true;
+        return index;
+    }
+    spdlog::error("bindless table has no free slot of kind {}",
+                  static_cast<uint32_t>(kind));
+    return invalid_index;
+}
+
+void Table::write(Kind kind, uint32_t index, const VkDescriptorImageInfo *image,
+                  const VkDescriptorBufferInfo *buffer) {
+    uint32_t binding = static_cast<uint32_t>(kind);
+    VkWriteDescriptorSet write_info{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = m_set,
+        .dstBinding = binding,
+        .dstArrayElement = index,
+        .descriptorCount = 1,
+        .descriptorType = kind_types[binding],
+        .pImageInfo = image,
+        .pBufferInfo = buffer,
+        .pTexelBufferView = nullptr,
+    };
+    vkUpdateDescriptorSets(m_device, 1, &write_info, 0, nullptr);
+}
+
+uint32_t Table::addImage(VkImageView view, VkImageLayout layout) {
+    VkDescriptorImageInfo info{
+        .sampler = VK_NULL_HANDLE,
+        .imageView = view,
+        .imageLayout = layout,
+    };
+    std::lock_guard lock(m_mutex);
+    uint32_t index = take(Kind::image);
+    if (index != invalid_index) {
+        write(Kind::image, index, &info, nullptr);
+    }
+    return index;
+}
+
+uint32_t Table::addSampler(VkSampler sampler) {
+    VkDescriptorImageInfo info{
+        .sampler = sampler,
+        .imageView = VK_NULL_HANDLE,
+        .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    std::lock_guard lock(m_mutex);
+    uint32_t index = take(Kind::sampler);
+    if (index != invalid_index) {
+        write(Kind::sampler, index, &info, nullptr);
+    }
+    return index;
+}
+
+uint32_t Table::addBuffer(VkBuffer buffer, VkDeviceSize offset,
+                          VkDeviceSize range) {
+    VkDescriptorBufferInfo info{
+        .buffer = buffer,
+        .offset = offset,
+        .range = range,
+    };
+    std::lock_guard lock(m_mutex);
+    uint32_t index = take(Kind::buffer);
+    if (index != invalid_index) {
+        write(Kind::buffer, index, nullptr, &info);
+    }
+    return index;
+}
+
+void Table::release(Kind kind, uint32_t index) {
+    auto &slots = m_slots[static_cast<uint32_t>(kind)];
+    if (index >= slots.capacity) {
+        spdlog::warn("release invalid bindless slot {}", index);
+        return;
+    }
+    // partially bound, the stale descriptor stays until the slot is reused
+    std::lock_guard lock(m_mutex);
+    // a second release would hand the slot out twice
+    if (!slots.live[index]) {
+        spdlog::warn("release free bindless slot {}", index);
+        return;
+    }
+    slots.live[index] = false;
+    slots.free.push_back(index);
+}
+
+} // namespace vbr::bindless
@@ -8,27 +8,37 @@ namespace vbr::buffer {
 
 Buffer::Buffer(vbr::device::Device &d) : device(d) {}
 Buffer::~Buffer() {
-    if (*device != VK_NULL_HANDLE) {
+    // nothing to wait for once destroy() ran
+    if (*device != VK_NULL_HANDLE && buffer != VK_NULL_HANDLE) {
         vkDeviceWaitIdle(*device);
     }
+    destroy();
+}
 
+void Buffer::destroy() {
+    if (index != vbr::bindless::invalid_index && device.bindless()) {
+        device.bindless()->release(vbr::bindless::Kind::buffer, index);
+        index = vbr::bindless::invalid_index;
+    }
     if (*device != VK_NULL_HANDLE && buffer != VK_NULL_HANDLE) {
         vkDestroyBuffer(*device, buffer, nullptr);
         buffer = VK_NULL_HANDLE;
     }
-    if (*device != VK_NULL_HANDLE && memory != VK_NULL_HANDLE) {
-        vkFreeMemory(*device, memory, nullptr);
-        memory = VK_NULL_HANDLE;
+    // give the range back to its block instead of vkFreeMemory
+    if (*device != VK_NULL_HANDLE && allocation.valid()) {
+        device.freeMemory(allocation);
     }
 }
 
-void Buffer::bind(VkDeviceSize offset) {
-    vkBindBufferMemory(*device, buffer, memory, offset);
+void Buffer::bind() {
+    vkBindBufferMemory(*device, buffer, allocation.memory, allocation.offset);
 }
 
+// host visible blocks stay mapped, map only hands out the sub range
 void *Buffer::map(VkDeviceSize size) {
-    if (*device != VK_NULL_HANDLE) {
-        vkMapMemory(*device, memory, 0, size, 0, &data);
+    if (*device != VK_NULL_HANDLE && allocation.mapped != nullptr &&
+        size <= allocation.size) {
+        data = allocation.mapped;
     } else {
         spdlog::error("invalid memory");
     }
@@ -37,7 +47,6 @@ void *Buffer::map(VkDeviceSize size) {
 
 void Buffer::unmap() {
     if (*device != VK_NULL_HANDLE && data != nullptr) {
-        vkUnmapMemory(*device, memory);
         data = nullptr;
     } else {
         spdlog::error("invalid memory");
@@ -45,7 +54,7 @@ void Buffer::unmap() {
 }
 
 void Buffer::copyFrom(const Buffer &src, VkDeviceSize size) {
-    if (src.buffer == VK_NULL_HANDLE || src.memory == VK_NULL_HANDLE) {
+    if (src.buffer == VK_NULL_HANDLE || !src.allocation.valid()) {
         spdlog::warn("copy invalid buffer");
         return;
     }
@@ -63,7 +72,7 @@ void Buffer::copyFrom(const Buffer &src, VkDeviceSize size) {
 }
 
 void Buffer::cutFrom(Buffer &src, VkDeviceSize size) {
-    if (src.buffer == VK_NULL_HANDLE || src.memory == VK_NULL_HANDLE) {
+    if (src.buffer == VK_NULL_HANDLE || !src.allocation.valid()) {
         spdlog::warn("copy invalid buffer");
         return;
     }
@@ -76,9 +85,8 @@ void Buffer::cutFrom(Buffer &src, VkDeviceSize size) {
         };
         vkCmdCopyBuffer(cmd, src.buffer, buffer, 1, &info);
         device.endTemporaryCommand(cmd);
-        vkFreeMemory(*device, src.memory, nullptr);
         vkDestroyBuffer(*device, src.buffer, nullptr);
-        src.memory = VK_NULL_HANDLE;
+        device.freeMemory(src.allocation);
         src.buffer = VK_NULL_HANDLE;
     }
 }
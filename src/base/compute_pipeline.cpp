@@ -0,0 +1,121 @@
+#include "../../inc/compute_pipeline.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+#include <chrono>
+
+namespace vbr::cpipeline {
+
+Pipeline::Pipeline(vbr::device::Device &device) : m_device(device) {}
+
+Pipeline::~Pipeline() {
+    wait();
+    if (*m_device != VK_NULL_HANDLE) {
+        vkDeviceWaitIdle(*m_device);
+    }
+
+    if (*m_device != VK_NULL_HANDLE && m_pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(*m_device, m_pipeline, nullptr);
+        m_pipeline = VK_NULL_HANDLE;
+    }
+    if (*m_device != VK_NULL_HANDLE) {
+        releaseShaderModule();
+        m_device.pipelineStats().forget(m_statistics);
+    }
+}
+
+void Pipeline::releaseShaderModule() {
+    if (m_module != VK_NULL_HANDLE) {
+        m_device.shaders().release(m_module);
+        m_module = VK_NULL_HANDLE;
+    }
+}
+
+void Pipeline::setShader(std::string_view shader_path,
+                         std::string_view name) {
+    m_path = shader_path;
+    m_name = name;
+}
+
+bool Pipeline::init(VkPipelineLayout &layout) {
+    wait();
+    m_state.store(State::building, std::memory_order_relaxed);
+    bool ret = build(layout);
+    finish(ret);
+    return ret;
+}
+
+void Pipeline::initAsync(VkPipelineLayout layout) {
+    wait();
+    m_state.store(State::building, std::memory_order_relaxed);
+    m_device.workers().submit([this, layout] { finish(build(layout)); });
+}
+
+void Pipeline::finish(bool ret) {
+    std::lock_guard lock(m_build_mutex);
+    m_state.store(ret ? State::ready : State::failed,
+                  std::memory_order_release);
+    m_build_cv.notify_all();
+}
+
+bool Pipeline::wait() {
+    std::unique_lock lock(m_build_mutex);
+    m_build_cv.wait(lock, [this] { return state() != State::building; });
+    return state() == State::ready;
+}
+
+bool Pipeline::build(VkPipelineLayout layout) {
+    if (*m_device == VK_NULL_HANDLE) {
+        spdlog::error("invalid compute pipeline {}", __LINE__);
+        return false;
+    }
+    if (m_pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(*m_device, m_pipeline, nullptr);
+        m_pipeline = VK_NULL_HANDLE;
+    }
+    releaseShaderModule();
+
+    m_module = m_device.shaders().acquire(m_path);
+    if (m_module == VK_NULL_HANDLE) {
+        return false;
+    }
+    VkSpecializationInfo special_info{
+        .mapEntryCount = static_cast<uint32_t>(m_constant_entries.size()),
+        .pMapEntries = m_constant_entries.data(),
+        .dataSize = m_constant_data.size(),
+        .pData = m_constant_data.data(),
+    };
+    VkComputePipelineCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .stage =
+            {
+                .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .pNext = nullptr,
+                .flags = 0,
+                .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = m_module,
+                .pName = m_name.c_str(),
+                .pSpecializationInfo =
+                    m_constant_entries.empty() ? nullptr : &special_info,
+            },
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = 0,
+    };
+    auto start = std::chrono::steady_clock::now();
+    VkResult ret = vkCreateComputePipelines(
+        *m_device, *m_device.pipelineCache(), 1, &info, nullptr, &m_pipeline);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (VK_SUCCESS != ret) {
+        spdlog::error("failed to create compute pipeline {}", m_path);
+        m_pipeline = VK_NULL_HANDLE;
+        releaseShaderModule();
+        return false;
+    }
+    m_device.pipelineCache().record(elapsed.count());
+    return true;
+}
+
+} // namespace vbr::cpipeline
@@ -1,21 +1,150 @@
 #include "../../inc/descriptor.hpp"
 #include "../../inc/buffer.hpp"
 #include "../../inc/image.hpp"
+#include "../../inc/layout.hpp"
 #include "vulkan/vulkan_core.h"
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
 namespace vbr::descriptor {
 
-Descriptor::Descriptor(VkDevice &device) : m_device(device) {}
+Allocator::Allocator(VkDevice &device, bool freeable, uint32_t sets_per_pool,
+                     std::vector<PoolRatio> ratios)
+    : m_device(device), m_freeable(freeable),
+      m_sets_per_pool(std::max(sets_per_pool, 1u)),
+      m_ratios(std::move(ratios)) {}
+
+Allocator::~Allocator() { destroy(); }
+
+VkDescriptorPool Allocator::grab() {
+    if (!m_ready.empty()) {
+        VkDescriptorPool pool = m_ready.back();
+        m_ready.pop_back();
+        return pool;
+    }
+
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (const auto &ratio : m_ratios) {
+        sizes.push_back({
+            .type = ratio.type,
+            .descriptorCount = std::max(
+                static_cast<uint32_t>(ratio.ratio * m_sets_per_pool), 1u),
+        });
+    }
+    VkDescriptorPoolCreateFlags flags = 0;
+    if (m_freeable) {
+        flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    }
+    VkDescriptorPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = flags,
+        .maxSets = m_sets_per_pool,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data(),
+    };
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreateDescriptorPool(m_device, &info, nullptr, &pool)) {
+        spdlog::error("failed to create descriptor pool");
+        return VK_NULL_HANDLE;
+    }
+    m_sets_per_pool = std::min(m_sets_per_pool * 2, max_sets_per_pool);
+    return pool;
+}
+
+VkDescriptorSet Allocator::allocate(VkDescriptorSetLayout layout,
+                                    VkDescriptorPool *pool) {
+    if (m_current == VK_NULL_HANDLE) {
+        m_current = grab();
+    }
+    // the second try runs on a fresh pool
+    for (int attempt = 0; attempt < 2 && m_current != VK_NULL_HANDLE;
+         ++attempt) {
+        VkDescriptorSetAllocateInfo info{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .descriptorPool = m_current,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &layout,
+        };
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        VkResult ret = vkAllocateDescriptorSets(m_device, &info, &set);
+        if (ret == VK_SUCCESS) {
+            if (pool) {
+                *pool = m_current;
+            }
+            return set;
+        }
+        if (ret != VK_ERROR_OUT_OF_POOL_MEMORY &&
+            ret != VK_ERROR_FRAGMENTED_POOL) {
+            break;
+        }
+        m_full.push_back(m_current);
+        m_current = grab();
+    }
+    spdlog::error("failed to alloc descriptor set");
+    return VK_NULL_HANDLE;
+}
+
+void Allocator::free(VkDescriptorPool pool, VkDescriptorSet set) {
+    if (!m_freeable || pool == VK_NULL_HANDLE || set == VK_NULL_HANDLE) {
+        return;
+    }
+    vkFreeDescriptorSets(m_device, pool, 1, &set);
+    // a full pool has room again, try it before creating new ones
+    auto it = std::find(m_full.begin(), m_full.end(), pool);
+    if (it != m_full.end()) {
+        m_full.erase(it);
+        m_ready.push_back(pool);
+    }
+}
+
+void Allocator::reset() {
+    if (m_current != VK_NULL_HANDLE) {
+        m_full.push_back(m_current);
+        m_current = VK_NULL_HANDLE;
+    }
+    for (auto &pool : m_full) {
+        vkResetDescriptorPool(m_device, pool, 0);
+        m_ready.push_back(pool);
+    }
+    m_full.clear();
+}
+
+void Allocator::destroy() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    if (m_current != VK_NULL_HANDLE) {
+        m_full.push_back(m_current);
+        m_current = VK_NULL_HANDLE;
+    }
+    for (auto &pool : m_full) {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    for (auto &pool : m_ready) {
+        vkDestroyDescriptorPool(m_device, pool, nullptr);
+    }
+    m_full.clear();
+    m_ready.clear();
+}
+
+Descriptor::Descriptor(VkDevice &device, Allocator *allocator,
+                       vbr::layout::Cache *cache)
+    : m_device(device), m_allocator(allocator), m_cache(cache) {}
 Descriptor::~Descriptor() {
-    if (m_device != VK_NULL_HANDLE && m_descriptor_layout != VK_NULL_HANDLE) {
+    if (m_device != VK_NULL_HANDLE && m_descriptor_layout != VK_NULL_HANDLE &&
+        m_cache == nullptr) {
         vkDestroyDescriptorSetLayout(m_device, m_descriptor_layout, nullptr);
         m_descriptor_layout = VK_NULL_HANDLE;
     }
-    // if (m_device != VK_NULL_HANDLE && m_descriptor_set != VK_NULL_HANDLE) {
-    //     vkFreeDescriptorSets(m_device, m_descriptor_pool, 1,
-    //     &m_descriptor_set); m_descriptor_set = VK_NULL_HANDLE;
-    // }
+    if (m_device != VK_NULL_HANDLE && m_allocator != nullptr) {
+        for (size_t i = 0; i < m_descriptor_sets.size(); ++i) {
+            m_allocator->free(m_set_pools[i], m_descriptor_sets[i]);
+        }
+    }
+    m_descriptor_sets.clear();
+    m_set_pools.clear();
     if (m_device != VK_NULL_HANDLE && m_descriptor_pool != VK_NULL_HANDLE) {
         vkDestroyDescriptorPool(m_device, m_descriptor_pool, nullptr);
         m_descriptor_pool = VK_NULL_HANDLE;
@@ -34,54 +163,88 @@ void Descriptor::addDescriptorBinding(uint32_t binding, VkDescriptorType type,
 
     };
     m_descriptor_bindings.push_back(v);
-    // add poolsize
+    // add poolsize, scaled by maxSet() in init
     VkDescriptorPoolSize dpsv{
         .type = type,
-        .descriptorCount = 1,
+        .descriptorCount = count,
     };
     m_pool_size.push_back(dpsv);
 }
 
+bool Descriptor::initPool() {
+    std::vector<VkDescriptorPoolSize> sizes = m_pool_size;
+    for (auto &size : sizes) {
+        size.descriptorCount *= m_max_set;
+    }
+    VkDescriptorPoolCreateInfo pcinfo{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .maxSets = m_max_set,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data(),
+    };
+    if (VK_SUCCESS != vkCreateDescriptorPool(m_device, &pcinfo, nullptr,
+                                             &m_descriptor_pool)) {
+        spdlog::error("failed to create descriptor pool");
+        return false;
+    }
+    std::vector<VkDescriptorSetLayout> layouts(m_max_set, m_descriptor_layout);
+    VkDescriptorSetAllocateInfo dsalloc_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .descriptorPool = m_descriptor_pool,
+        .descriptorSetCount = m_max_set,
+        .pSetLayouts = layouts.data(),
+    };
+    m_descriptor_sets.resize(m_max_set, VK_NULL_HANDLE);
+    m_set_pools.assign(m_max_set, m_descriptor_pool);
+    if (VK_SUCCESS != vkAllocateDescriptorSets(m_device, &dsalloc_info,
+                                               m_descriptor_sets.data())) {
+        spdlog::error("failed to alloc descriptor sets");
+        return false;
+    }
+    return true;
+}
+
+bool Descriptor::initLayout() {
+    VkDescriptorSetLayoutCreateInfo dlayout_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .bindingCount = static_cast<uint32_t>(m_descriptor_bindings.size()),
+        .pBindings = m_descriptor_bindings.data(),
+    };
+    if (VK_SUCCESS != vkCreateDescriptorSetLayout(m_device, &dlayout_info,
+                                                  nullptr,
+                                                  &m_descriptor_layout)) {
+        spdlog::error("failed to create descriptor set layout");
+        return false;
+    }
+    return true;
+}
+
 bool Descriptor::init() {
     if (!m_descriptor_bindings.empty()) {
-        VkDescriptorSetLayoutCreateInfo dlayout_info{
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .bindingCount = static_cast<uint32_t>(m_descriptor_bindings.size()),
-            .pBindings = m_descriptor_bindings.data(),
-        };
-
-        if (VK_SUCCESS != vkCreateDescriptorSetLayout(m_device, &dlayout_info,
-                                                      nullptr,
-                                                      &m_descriptor_layout)) {
-            spdlog::error("failed to create descriptor set layout");
+        if (m_cache != nullptr) {
+            m_descriptor_layout = m_cache->setLayout(m_descriptor_bindings);
+            if (m_descriptor_layout == VK_NULL_HANDLE) {
+                return false;
+            }
+        } else if (!initLayout()) {
             return false;
         }
-        VkDescriptorPoolCreateInfo pcinfo{
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-            .pNext = nullptr,
-            .flags = 0,
-            .maxSets = 1,
-            .poolSizeCount = static_cast<uint32_t>(m_pool_size.size()),
-            .pPoolSizes = m_pool_size.data(),
-        };
-        if (VK_SUCCESS != vkCreateDescriptorPool(m_device, &pcinfo, nullptr,
-                                                 &m_descriptor_pool)) {
-            spdlog::error("failed to create descriptor set layout");
-            return false;
+        if (m_allocator == nullptr) {
+            return initPool();
         }
-        VkDescriptorSetAllocateInfo dsalloc_info{
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-            .pNext = nullptr,
-            .descriptorPool = m_descriptor_pool,
-            .descriptorSetCount = 1,
-            .pSetLayouts = &m_descriptor_layout,
-        };
-        if (VK_SUCCESS != vkAllocateDescriptorSets(m_device, &dsalloc_info,
-                                                   &m_descriptor_set)) {
-            spdlog::error("failed to alloc descriptor sets");
-            return false;
+        m_descriptor_sets.resize(m_max_set, VK_NULL_HANDLE);
+        m_set_pools.resize(m_max_set, VK_NULL_HANDLE);
+        for (uint32_t i = 0; i < m_max_set; ++i) {
+            m_descriptor_sets[i] =
+                m_allocator->allocate(m_descriptor_layout, &m_set_pools[i]);
+            if (m_descriptor_sets[i] == VK_NULL_HANDLE) {
+                return false;
+            }
         }
     } else {
         spdlog::warn("invalid descriptor");
@@ -92,17 +255,23 @@ bool Descriptor::init() {
 
 void Descriptor::updateBuffer(const vbr::buffer::Buffer &buffer,
                               uint32_t dst_binding, uint32_t dst_array_element,
-                              VkDescriptorType type) {
+                              VkDescriptorType type, uint32_t index) {
     VkDescriptorBufferInfo buffer_info{
         .buffer = buffer.buffer,
         .offset = 0,
         .range = buffer.size,
 
     };
+    updateBuffer(buffer_info, dst_binding, dst_array_element, type, index);
+}
+
+void Descriptor::updateBuffer(const VkDescriptorBufferInfo &buffer_info,
+                              uint32_t dst_binding, uint32_t dst_array_element,
+                              VkDescriptorType type, uint32_t index) {
     VkWriteDescriptorSet write_info{
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .pNext = nullptr,
-        .dstSet = m_descriptor_set,
+        .dstSet = m_descriptor_sets[index],
         .dstBinding = dst_binding,
         .dstArrayElement = dst_array_element,
         .descriptorCount = 1,
@@ -114,9 +283,32 @@ void Descriptor::updateBuffer(const vbr::buffer::Buffer &buffer,
     vkUpdateDescriptorSets(m_device, 1, &write_info, 0, nullptr);
 }
 
+void Descriptor::updateStorageImage(VkImageView view, uint32_t dst_binding,
+                                    uint32_t dst_array_element,
+                                    uint32_t index) {
+    VkDescriptorImageInfo info{
+        .sampler = VK_NULL_HANDLE,
+        .imageView = view,
+        .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+    };
+    VkWriteDescriptorSet write_info{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = m_descriptor_sets[index],
+        .dstBinding = dst_binding,
+        .dstArrayElement = dst_array_element,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        .pImageInfo = &info,
+        .pBufferInfo = nullptr,
+        .pTexelBufferView = nullptr,
+    };
+    vkUpdateDescriptorSets(m_device, 1, &write_info, 0, nullptr);
+}
+
 void Descriptor::updateTexture(vbr::image::Texture &texture,
-                               uint32_t dst_binding,
-                               uint32_t dst_array_element) {
+                               uint32_t dst_binding, uint32_t dst_array_element,
+                               uint32_t index) {
     if (texture.sampler == VK_NULL_HANDLE || texture.view == VK_NULL_HANDLE) {
         spdlog::warn("invalid texture, please init first");
         return;
@@ -129,7 +321,7 @@ void Descriptor::updateTexture(vbr::image::Texture &texture,
     VkWriteDescriptorSet write_info{
         .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
         .pNext = nullptr,
-        .dstSet = m_descriptor_set,
+        .dstSet = m_descriptor_sets[index],
         .dstBinding = dst_binding,
         .dstArrayElement = dst_array_element,
         .descriptorCount = 1,
@@ -140,4 +332,158 @@ void Descriptor::updateTexture(vbr::image::Texture &texture,
     };
     vkUpdateDescriptorSets(m_device, 1, &write_info, 0, nullptr);
 }
+
+void Descriptor::updateBuffer(Writer &writer, const vbr::buffer::Buffer &buffer,
+                              uint32_t dst_binding, uint32_t dst_array_element,
+                              VkDescriptorType type, uint32_t index) {
+    writer.writeBuffer(m_descriptor_sets[index], dst_binding,
+                       {
+                           .buffer = buffer.buffer,
+                           .offset = 0,
+                           .range = buffer.size,
+                       },
+                       type, dst_array_element);
+}
+
+void Descriptor::updateTexture(Writer &writer, vbr::image::Texture &texture,
+                               uint32_t dst_binding, uint32_t dst_array_element,
+                               uint32_t index) {
+    if (texture.sampler == VK_NULL_HANDLE || texture.view == VK_NULL_HANDLE) {
+        spdlog::warn("invalid texture, please init first");
+        return;
+    }
+    writer.writeImage(m_descriptor_sets[index], dst_binding,
+                      {
+                          .sampler = texture.sampler,
+                          .imageView = texture.view,
+                          .imageLayout =
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                      },
+                      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                      dst_array_element);
+}
+
+Writer::Writer(VkDevice &device) : m_device(device) {}
+
+void Writer::writeBuffer(VkDescriptorSet set, uint32_t binding,
+                         const VkDescriptorBufferInfo &info,
+                         VkDescriptorType type, uint32_t element) {
+    m_buffer_infos.push_back(info);
+    m_writes.push_back({
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = set,
+        .dstBinding = binding,
+        .dstArrayElement = element,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pImageInfo = nullptr,
+        .pBufferInfo = &m_buffer_infos.back(),
+        .pTexelBufferView = nullptr,
+    });
+}
+
+void Writer::writeImage(VkDescriptorSet set, uint32_t binding,
+                        const VkDescriptorImageInfo &info,
+                        VkDescriptorType type, uint32_t element) {
+    m_image_infos.push_back(info);
+    m_writes.push_back({
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .pNext = nullptr,
+        .dstSet = set,
+        .dstBinding = binding,
+        .dstArrayElement = element,
+        .descriptorCount = 1,
+        .descriptorType = type,
+        .pImageInfo = &m_image_infos.back(),
+        .pBufferInfo = nullptr,
+        .pTexelBufferView = nullptr,
+    });
+}
+
+uint32_t Writer::flush() {
+    uint32_t count = static_cast<uint32_t>(m_writes.size());
+    if (count > 0) {
+        vkUpdateDescriptorSets(m_device, count, m_writes.data(), 0, nullptr);
+    }
+    clear();
+    return count;
+}
+
+void Writer::clear() {
+    m_writes.clear();
+    m_buffer_infos.clear();
+    m_image_infos.clear();
+}
+
+Template::Template(VkDevice &device) : m_device(device) {}
+
+Template::~Template() { destroy(); }
+
+void Template::addEntry(uint32_t binding, VkDescriptorType type,
+                        size_t offset, uint32_t count, size_t stride,
+                        uint32_t element) {
+    if (stride == 0) {
+        switch (type) {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            stride = sizeof(VkDescriptorBufferInfo);
+            break;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            stride = sizeof(VkBufferView);
+            break;
+        default:
+            stride = sizeof(VkDescriptorImageInfo);
+            break;
+        }
+    }
+    m_entries.push_back({
+        .dstBinding = binding,
+        .dstArrayElement = element,
+        .descriptorCount = count,
+        .descriptorType = type,
+        .offset = offset,
+        .stride = stride,
+    });
+}
+
+bool Template::init(VkDescriptorSetLayout layout) {
+    if (m_entries.empty()) {
+        spdlog::warn("descriptor template without entries");
+        return false;
+    }
+    VkDescriptorUpdateTemplateCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .descriptorUpdateEntryCount = static_cast<uint32_t>(m_entries.size()),
+        .pDescriptorUpdateEntries = m_entries.data(),
+        .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+        .descriptorSetLayout = layout,
+        // only for push descriptor templates
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .pipelineLayout = VK_NULL_HANDLE,
+        .set = 0,
+    };
+    if (VK_SUCCESS != vkCreateDescriptorUpdateTemplate(m_device, &info, nullptr,
+                                                       &m_template)) {
+        spdlog::error("failed to create descriptor update template");
+        return false;
+    }
+    return true;
+}
+
+void Template::destroy() {
+    if (m_device != VK_NULL_HANDLE && m_template != VK_NULL_HANDLE) {
+        vkDestroyDescriptorUpdateTemplate(m_device, m_template, nullptr);
+        m_template = VK_NULL_HANDLE;
+    }
+}
+
+void Template::update(VkDescriptorSet set, const void *data) {
+    vkUpdateDescriptorSetWithTemplate(m_device, set, m_template, data);
+}
 } // namespace vbr::descriptor
@@ -14,43 +14,79 @@ namespace vbr::device {
 const std::vector<char const *> validation_layers = {
     "VK_LAYER_KHRONOS_validation",
 };
-
-void SyncObjs::destroy(const VkDevice device) {
+// wanted bindless table size, clamped to the device limits
+constexpr uint32_t bindless_images = 16384;
+constexpr uint32_t bindless_samplers = 4000;
+constexpr uint32_t bindless_buffers = 8192;
+// shared by all frames in flight
+constexpr VkDeviceSize uniform_ring_size = 4 * 1024 * 1024;
+
+void FrameObjs::destroy(const VkDevice device) {
     if (device == VK_NULL_HANDLE) {
         return;
     }
+    descriptors.reset();
     if (image_available != VK_NULL_HANDLE) {
         vkDestroySemaphore(device, image_available, nullptr);
         image_available = VK_NULL_HANDLE;
     }
-    if (render_done != VK_NULL_HANDLE) {
-        vkDestroySemaphore(device, render_done, nullptr);
-        render_done = VK_NULL_HANDLE;
-    }
     if (in_flight_fence != VK_NULL_HANDLE) {
         vkDestroyFence(device, in_flight_fence, nullptr);
         in_flight_fence = VK_NULL_HANDLE;
     }
+    if (cmd != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(device, cmd_pool, 1, &cmd);
+        cmd = VK_NULL_HANDLE;
+    }
+    if (cmd_pool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device, cmd_pool, nullptr);
+        cmd_pool = VK_NULL_HANDLE;
+    }
+}
+
+void Target::destroy(Device &device) {
+    if (image) {
+        image.reset();
+    }
+    device.freeMemory(allocation);
 }
 
 Device::Device(VkSurfaceKHR &surface, VkSampleCountFlagBits sample_count,
-               bool debug)
-    : m_vk_surface(surface), m_debug(debug), m_sample_count(sample_count) {}
+               bool debug, uint32_t frames_in_flight,
+               std::string_view pipeline_cache_path)
+    : m_vk_surface(surface), m_debug(debug),
+      m_pipeline_cache_path(pipeline_cache_path),
+      m_frames_in_flight(std::max(frames_in_flight, 1u)),
+      m_sample_count(sample_count) {}
 Device::~Device() {
     if (m_vk_device == VK_NULL_HANDLE) {
         return;
     }
 
+    // no job may touch the device past this point
+    m_workers.reset();
     if (m_vk_device != VK_NULL_HANDLE) {
         vkDeviceWaitIdle(m_vk_device);
     }
 
-    m_vk_sync.destroy(m_vk_device);
-
-    if (m_vk_cmd != VK_NULL_HANDLE) {
-        vkFreeCommandBuffers(m_vk_device, m_vk_cmd_pool, 1, &m_vk_cmd);
-        m_vk_cmd = VK_NULL_HANDLE;
+    destroyFrames();
+    m_recorder.reset();
+    m_async_compute.reset();
+    m_profiler.reset();
+    m_pipeline_stats.reset();
+    destroyOffscreen();
+    m_descriptor_allocator.reset();
+    m_layout_cache.reset();
+    m_bindless.reset();
+    m_uploader.reset();
+    m_uniform_ring.reset();
+    m_shader_cache.reset();
+    if (m_pipeline_cache) {
+        m_pipeline_cache->report();
+        m_pipeline_cache->save();
+        m_pipeline_cache.reset();
     }
+    m_allocator.reset();
 
     if (m_vk_cmd_pool) {
         vkDestroyCommandPool(m_vk_device, m_vk_cmd_pool, nullptr);
@@ -63,6 +99,71 @@ Device::~Device() {
     }
 }
 
+bool Device::querySurface() {
+    uint32_t count = 0;
+    // select present mode
+    if (VK_SUCCESS == vkGetPhysicalDeviceSurfacePresentModesKHR(
+                          m_vk_phy_device, m_vk_surface, &count, nullptr)) {
+        std::vector<VkPresentModeKHR> support_present_modes{count};
+        if (VK_SUCCESS == vkGetPhysicalDeviceSurfacePresentModesKHR(
+                              m_vk_phy_device, m_vk_surface, &count,
+                              support_present_modes.data())) {
+            if (std::ranges::any_of(
+                    support_present_modes, [](const auto &present_mode) {
+                        return present_mode == VK_PRESENT_MODE_MAILBOX_KHR;
+                    })) {
+                spdlog::info(
+                    "select present mode VK_PRESENT_MODE_MAILBOX_KHR");
+                m_vk_phy_info.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+            } else {
+                spdlog::info("select present mode default");
+                m_vk_phy_info.present_mode = support_present_modes[0];
+            }
+        } else {
+            spdlog::error("failed to get physical device present mode");
+            return false;
+        }
+    } else {
+        spdlog::error("failed to get physical device present mode");
+        return false;
+    }
+    // get surface capabilities
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_vk_phy_device, m_vk_surface,
+                                              &m_vk_phy_info.capabilities);
+    // get formats info
+    count = 0;
+    if (VK_SUCCESS == vkGetPhysicalDeviceSurfaceFormatsKHR(
+                          m_vk_phy_device, m_vk_surface, &count, nullptr)) {
+        std::vector<VkSurfaceFormatKHR> surface_formats{count};
+        surface_formats.resize(count);
+        if (VK_SUCCESS == vkGetPhysicalDeviceSurfaceFormatsKHR(
+                              m_vk_phy_device, m_vk_surface, &count,
+                              surface_formats.data())) {
+            if (std::ranges::any_of(
+                    surface_formats, [](const auto &surface_format) {
+                        return surface_format.colorSpace ==
+                                   VK_COLOR_SPACE_SRGB_NONLINEAR_KHR &&
+                               surface_format.format ==
+                                   VK_FORMAT_B8G8R8A8_SRGB;
+                    })) {
+                m_vk_phy_info.surface_format.format =
+                    VK_FORMAT_B8G8R8A8_SRGB;
+                m_vk_phy_info.surface_format.colorSpace =
+                    VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+            } else {
+                m_vk_phy_info.surface_format = surface_formats[0];
+            }
+        } else {
+            spdlog::error("failed to get physical device surface formats");
+            return false;
+        }
+    } else {
+        spdlog::error("failed to get physical device surface formats");
+        return false;
+    }
+    return true;
+}
+
 bool Device::pickupPhyDevice(const VkInstance &instance) {
     uint32_t count = 0;
     if (VK_SUCCESS != vkEnumeratePhysicalDevices(instance, &count, nullptr)) {
@@ -113,106 +214,87 @@ bool Device::pickupPhyDevice(const VkInstance &instance) {
         vkGetPhysicalDeviceQueueFamilyProperties(
             m_vk_phy_device, &pcount,
             m_vk_phy_info.queue_family_properties.data());
-        // select present mode
-        count = 0;
-        if (VK_SUCCESS == vkGetPhysicalDeviceSurfacePresentModesKHR(
-                              m_vk_phy_device, m_vk_surface, &count, nullptr)) {
-            std::vector<VkPresentModeKHR> support_present_modes{count};
-            if (VK_SUCCESS == vkGetPhysicalDeviceSurfacePresentModesKHR(
-                                  m_vk_phy_device, m_vk_surface, &count,
-                                  support_present_modes.data())) {
-                if (std::ranges::any_of(
-                        support_present_modes, [](const auto &present_mode) {
-                            return present_mode == VK_PRESENT_MODE_MAILBOX_KHR;
-                        })) {
-                    spdlog::info(
-                        "select present mode VK_PRESENT_MODE_MAILBOX_KHR");
-                    m_vk_phy_info.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
-                } else {
-                    spdlog::info("select present mode default");
-                    m_vk_phy_info.present_mode = support_present_modes[0];
-                }
-            } else {
-                spdlog::error("failed to get physical device present mode");
-                return false;
-            }
-        } else {
-            spdlog::error("failed to get physical device present mode");
+        if (headless()) {
+            // no surface, render into offscreen targets
+            m_vk_phy_info.present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            m_vk_phy_info.surface_format.format = VK_FORMAT_R8G8B8A8_SRGB;
+            m_vk_phy_info.surface_format.colorSpace =
+                VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+        } else if (!querySurface()) {
             return false;
         }
-        // get surface capabilities
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_vk_phy_device, m_vk_surface,
-                                                  &m_vk_phy_info.capabilities);
-        // get formats info
-        count = 0;
-        if (VK_SUCCESS == vkGetPhysicalDeviceSurfaceFormatsKHR(
-                              m_vk_phy_device, m_vk_surface, &count, nullptr)) {
-            std::vector<VkSurfaceFormatKHR> surface_formats{count};
-            surface_formats.resize(count);
-            if (VK_SUCCESS == vkGetPhysicalDeviceSurfaceFormatsKHR(
-                                  m_vk_phy_device, m_vk_surface, &count,
-                                  surface_formats.data())) {
-                if (std::ranges::any_of(
-                        surface_formats, [](const auto &surface_format) {
-                            return surface_format.colorSpace ==
-                                       VK_COLOR_SPACE_SRGB_NONLINEAR_KHR &&
-                                   surface_format.format ==
-                                       VK_FORMAT_B8G8R8A8_SRGB;
-                        })) {
-                    m_vk_phy_info.surface_format.format =
-                        VK_FORMAT_B8G8R8A8_SRGB;
-                    m_vk_phy_info.surface_format.colorSpace =
-                        VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
-                } else {
-                    m_vk_phy_info.surface_format = surface_formats[0];
-                }
-            } else {
-                spdlog::error("failed to get physical device surface formats");
-                return false;
-            }
-        } else {
-            spdlog::error("failed to get physical device surface formats");
+
+        if (!pickupQueues()) {
             return false;
         }
+    }
+    sampleCount(m_sample_count);
+    return found;
+}
 
-        m_vk_queue_indices.graphics = 0;
-        m_vk_queue_indices.present = 0;
-        m_vk_queue_indices.transfer = 0;
-        m_vk_queue_indices.compute = 0;
-
-        uint32_t i = 0;
-        for (const auto &family : m_vk_phy_info.queue_family_properties) {
-            if ((family.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
-                (!m_vk_queue_indices.graphics.has_value())) {
-                spdlog::info("graphics queue index {}", i);
-                m_vk_queue_indices.graphics = i;
-            }
-            if ((family.queueFlags & VK_QUEUE_COMPUTE_BIT) &&
-                (!m_vk_queue_indices.compute.has_value())) {
-                spdlog::info("compute queue index {}", i);
-                m_vk_queue_indices.compute = i;
-            }
-            if ((family.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
-                (!m_vk_queue_indices.transfer.has_value())) {
-                spdlog::info("transfer queue index {}", i);
-                m_vk_queue_indices.transfer = i;
-            }
-            VkBool32 present_support = false;
+std::optional<uint32_t> Device::findQueueFamily(VkQueueFlags flags,
+                                                VkQueueFlags excluded) {
+    const auto &families = m_vk_phy_info.queue_family_properties;
+    for (uint32_t i = 0; i < families.size(); ++i) {
+        if (families[i].queueCount > 0 &&
+            (families[i].queueFlags & flags) == flags &&
+            (families[i].queueFlags & excluded) == 0) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+bool Device::pickupQueues() {
+    m_vk_queue_indices = {};
+    m_vk_queue_indices.graphics = findQueueFamily(VK_QUEUE_GRAPHICS_BIT, 0);
+    if (!m_vk_queue_indices.graphics.has_value()) {
+        spdlog::error("no graphics queue family");
+        return false;
+    }
+    uint32_t graphics = m_vk_queue_indices.graphics.value();
+
+    // dedicated families run beside the graphics queue, fall back to the
+    // graphics family when the device has none
+    m_vk_queue_indices.compute =
+        findQueueFamily(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT)
+            .value_or(graphics);
+    // prefer the pure dma family over a compute one
+    m_vk_queue_indices.transfer = findQueueFamily(
+        VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (!m_vk_queue_indices.transfer.has_value()) {
+        m_vk_queue_indices.transfer =
+            findQueueFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT)
+                .value_or(graphics);
+    }
+
+    if (headless()) {
+        m_vk_queue_indices.present = graphics;
+    } else {
+        // present from the graphics family when possible, swapchain images
+        // are then exclusive to one family
+        const auto &families = m_vk_phy_info.queue_family_properties;
+        for (uint32_t i = 0; i < families.size(); ++i) {
+            VkBool32 present_support = VK_FALSE;
             vkGetPhysicalDeviceSurfaceSupportKHR(
                 m_vk_phy_device, i, m_vk_surface, &present_support);
-            if (present_support == VK_TRUE) {
-                spdlog::info("present index {}", i);
+            if (present_support == VK_TRUE &&
+                (!m_vk_queue_indices.present.has_value() || i == graphics)) {
                 m_vk_queue_indices.present = i;
             }
-            i++;
         }
-        if (!m_vk_queue_indices.graphics.has_value() ||
-            !m_vk_queue_indices.present.has_value()) {
+        if (!m_vk_queue_indices.present.has_value()) {
+            spdlog::error("no present queue family");
             return false;
         }
     }
-    sampleCount(m_sample_count);
-    return found;
+
+    spdlog::info("graphics queue index {}", graphics);
+    spdlog::info("present queue index {}", m_vk_queue_indices.present.value());
+    spdlog::info("compute queue index {}", m_vk_queue_indices.compute.value());
+    spdlog::info("transfer queue index {}",
+                 m_vk_queue_indices.transfer.value());
+    return true;
 }
 
 bool Device::initLogicDevice() {
@@ -296,9 +378,11 @@ bool Device::initLogicDevice() {
     }
 
     std::vector<const char *> required_extensions = {
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
     };
+    if (!headless()) {
+        required_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
     for (const auto &required_layer : required_layers) {
         if (std::ranges::none_of(
@@ -323,17 +407,68 @@ bool Device::initLogicDevice() {
         }
     }
 
-    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_render_feature{
-        .sType =
-            VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR,
+    // timeline semaphores track upload batches
+    VkPhysicalDeviceVulkan12Features vulkan12_feature{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
         .pNext = nullptr,
+        .timelineSemaphore = VK_TRUE,
+    };
+    // descriptor indexing backs the bindless table, optional
+    VkPhysicalDeviceVulkan12Features supported12{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+        .pNext = nullptr,
+    };
+    VkPhysicalDeviceFeatures2 supported{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = &supported12,
+        .features = {},
+    };
+    vkGetPhysicalDeviceFeatures2(m_vk_phy_device, &supported);
+    m_descriptor_indexing =
+        supported12.descriptorIndexing &&
+        supported12.runtimeDescriptorArray &&
+        supported12.descriptorBindingPartiallyBound &&
+        supported12.descriptorBindingSampledImageUpdateAfterBind &&
+        supported12.descriptorBindingStorageBufferUpdateAfterBind &&
+        supported12.descriptorBindingUpdateUnusedWhilePending &&
+        supported12.shaderSampledImageArrayNonUniformIndexing &&
+        supported12.shaderStorageBufferArrayNonUniformIndexing;
+    if (m_descriptor_indexing) {
+        vulkan12_feature.descriptorIndexing = VK_TRUE;
+        vulkan12_feature.runtimeDescriptorArray = VK_TRUE;
+        vulkan12_feature.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12_feature.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan12_feature.descriptorBindingStorageBufferUpdateAfterBind =
+            VK_TRUE;
+        vulkan12_feature.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        vulkan12_feature.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        vulkan12_feature.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+    } else {
+        spdlog::warn("no descriptor indexing, bindless table disabled");
+    }
+    // indirect draws fall back to one call per draw without them
+    m_multi_draw_indirect = m_vk_phy_info.features.multiDrawIndirect;
+    // enabled with the other core features through pEnabledFeatures
+    m_draw_indirect_first_instance =
+        m_vk_phy_info.features.drawIndirectFirstInstance;
+    m_draw_indirect_count = supported12.drawIndirectCount;
+    vulkan12_feature.drawIndirectCount = supported12.drawIndirectCount;
+    // profilers reset their pools on the host, transfer queues can not
+    m_host_query_reset = supported12.hostQueryReset;
+    vulkan12_feature.hostQueryReset = supported12.hostQueryReset;
+    // every supported core feature is enabled below, statistics included
+    m_pipeline_statistics = m_vk_phy_info.features.pipelineStatisticsQuery;
+    // synchronization2 records the batched barriers of the render graph
+    VkPhysicalDeviceVulkan13Features vulkan13_feature{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+        .pNext = &vulkan12_feature,
+        .synchronization2 = VK_TRUE,
         .dynamicRendering = VK_TRUE,
     };
 
     VkDeviceCreateInfo info{
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-        .pNext = (VkPhysicalDeviceDynamicRenderingFeaturesKHR
-                      *)&dynamic_render_feature,
+        .pNext = &vulkan13_feature,
         .flags = 0,
         .queueCreateInfoCount = static_cast<uint32_t>(queue_infos.size()),
         .pQueueCreateInfos = queue_infos.data(),
@@ -385,24 +520,16 @@ bool Device::initCmds() {
         return false;
     }
 
-    VkCommandBufferAllocateInfo alloc_info{
-        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-        .pNext = nullptr,
-        .commandPool = m_vk_cmd_pool,
-        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-        .commandBufferCount = 1,
-    };
-
-    if (VK_SUCCESS !=
-        vkAllocateCommandBuffers(m_vk_device, &alloc_info, &m_vk_cmd)) {
-        spdlog::error("failed to alloc commands");
-        return false;
-    }
-
     return true;
 }
 
-bool Device::initSync() {
+bool Device::initFrames() {
+    VkCommandPoolCreateInfo pinfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = m_vk_queue_indices.graphics.value(),
+    };
     VkSemaphoreCreateInfo sinfo{
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
         .pNext = nullptr,
@@ -414,24 +541,142 @@ bool Device::initSync() {
         .flags = VK_FENCE_CREATE_SIGNALED_BIT,
     };
 
-    if (VK_SUCCESS != vkCreateSemaphore(m_vk_device, &sinfo, nullptr,
-                                        &m_vk_sync.image_available)) {
-        spdlog::error("failed to create semaphore for image available");
+    m_vk_frames.resize(m_frames_in_flight);
+    m_current_frame = 0;
+    for (auto &frame : m_vk_frames) {
+        if (VK_SUCCESS != vkCreateCommandPool(m_vk_device, &pinfo, nullptr,
+                                              &frame.cmd_pool)) {
+            spdlog::error("failed to create frame command pool");
+            return false;
+        }
+
+        VkCommandBufferAllocateInfo alloc_info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .commandPool = frame.cmd_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        if (VK_SUCCESS !=
+            vkAllocateCommandBuffers(m_vk_device, &alloc_info, &frame.cmd)) {
+            spdlog::error("failed to alloc frame commands");
+            return false;
+        }
+
+        if (VK_SUCCESS != vkCreateSemaphore(m_vk_device, &sinfo, nullptr,
+                                            &frame.image_available)) {
+            spdlog::error("failed to create semaphore for image available");
+            return false;
+        }
+        if (VK_SUCCESS != vkCreateFence(m_vk_device, &finfo, nullptr,
+                                        &frame.in_flight_fence)) {
+            spdlog::error("failed to create fence for in flight fence");
+            return false;
+        }
+        frame.descriptors =
+            std::make_unique<vbr::descriptor::Allocator>(m_vk_device);
+    }
+    spdlog::info("{} frames in flight", m_frames_in_flight);
+    return true;
+}
+
+void Device::destroyFrames() {
+    for (auto &frame : m_vk_frames) {
+        frame.destroy(m_vk_device);
+    }
+    m_vk_frames.clear();
+    m_current_frame = 0;
+}
+
+bool Device::framesInFlight(uint32_t count) {
+    count = std::max(count, 1u);
+    if (m_vk_device == VK_NULL_HANDLE) {
+        m_frames_in_flight = count;
+        return true;
+    }
+    if (count == m_frames_in_flight) {
+        return true;
+    }
+    vkDeviceWaitIdle(m_vk_device);
+    destroyFrames();
+    m_frames_in_flight = count;
+    if (!initFrames()) {
+        return false;
+    }
+    m_uniform_ring->reset(count);
+    if (!m_recorder->init(count)) {
         return false;
     }
-    if (VK_SUCCESS != vkCreateSemaphore(m_vk_device, &sinfo, nullptr,
-                                        &m_vk_sync.render_done)) {
-        spdlog::error("failed to create semaphore for render done");
+    if (!m_async_compute->frames(count)) {
         return false;
     }
-    if (VK_SUCCESS != vkCreateFence(m_vk_device, &finfo, nullptr,
-                                    &m_vk_sync.in_flight_fence)) {
-        spdlog::error("failed to create fence for in flight fence");
+    if (!m_profiler->init(m_vk_queue_indices.graphics.value(), count)) {
         return false;
     }
+    if (!m_pipeline_stats->init(count)) {
+        return false;
+    }
+    if (!m_offscreen_targets.empty()) {
+        return initOffscreen(m_offscreen_size);
+    }
     return true;
 }
 
+bool Device::initOffscreen(const glm::ivec2 &size) {
+    vkDeviceWaitIdle(m_vk_device);
+    destroyOffscreen();
+    m_offscreen_size = size;
+
+    VkFormat format = m_vk_phy_info.surface_format.format;
+    uint32_t w = static_cast<uint32_t>(size.x);
+    uint32_t h = static_cast<uint32_t>(size.y);
+    m_offscreen_targets.resize(m_frames_in_flight);
+    for (auto &target : m_offscreen_targets) {
+        target.image = std::make_unique<vbr::image::Image>(m_vk_device);
+        if (!internalCreateImage(w, h, format, VK_IMAGE_TILING_OPTIMAL,
+                                 offscreen_usage,
+                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                 target.image->image, target.allocation)) {
+            spdlog::error("failed to create offscreen target");
+            return false;
+        }
+        if (!target.image->init(format)) {
+            spdlog::error("failed to create offscreen target view");
+            return false;
+        }
+    }
+
+    if (m_sample_count != VK_SAMPLE_COUNT_1_BIT) {
+        m_offscreen_color.image =
+            std::make_unique<vbr::image::Image>(m_vk_device);
+        if (!internalCreateSampleImage(
+                w, h, format, VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT |
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                m_offscreen_color.image->image,
+                m_offscreen_color.allocation)) {
+            spdlog::error("failed to create offscreen color image");
+            return false;
+        }
+        if (!m_offscreen_color.image->init(format)) {
+            spdlog::error("failed to create offscreen color view");
+            return false;
+        }
+    }
+    spdlog::info("{} offscreen targets {}x{}", m_offscreen_targets.size(), w,
+                 h);
+    return true;
+}
+
+void Device::destroyOffscreen() {
+    for (auto &target : m_offscreen_targets) {
+        target.destroy(*this);
+    }
+    m_offscreen_targets.clear();
+    m_offscreen_color.destroy(*this);
+}
+
 void Device::updateWindowSize() {
     if (m_vk_phy_device && m_vk_surface) {
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_vk_phy_device, m_vk_surface,
@@ -447,15 +692,120 @@ bool Device::init(const VkInstance &instance) {
     if (!initLogicDevice()) {
         return false;
     }
+    m_allocator = std::make_unique<vbr::allocator::Allocator>(
+        m_vk_device, m_vk_phy_info.memory_properties,
+        m_vk_phy_info.properties.limits.bufferImageGranularity);
+    m_workers = std::make_unique<vbr::worker::Pool>();
+    m_shader_cache = std::make_unique<vbr::shader::ShaderCache>(m_vk_device);
+    m_descriptor_allocator =
+        std::make_unique<vbr::descriptor::Allocator>(m_vk_device, true);
+    m_layout_cache = std::make_unique<vbr::layout::Cache>(m_vk_device);
+    if (!initBindless()) {
+        return false;
+    }
+    m_pipeline_cache = std::make_unique<vbr::pcache::PipelineCache>(
+        m_vk_device, m_vk_phy_info.properties);
+    if (!m_pipeline_cache->init(m_pipeline_cache_path)) {
+        return false;
+    }
     if (!initCmds()) {
         return false;
     }
-    if (!initSync()) {
+    m_uploader = std::make_unique<vbr::upload::Uploader>(*this);
+    if (!m_uploader->init(m_vk_queue_indices.transfer.value(),
+                          m_vk_queues.transfer,
+                          m_vk_queue_indices.graphics.value())) {
+        return false;
+    }
+    if (!initUniformRing()) {
+        return false;
+    }
+    if (!initFrames()) {
+        return false;
+    }
+    m_recorder = std::make_unique<vbr::record::Recorder>(
+        m_vk_device, *m_workers, m_vk_queue_indices.graphics.value());
+    if (!m_recorder->init(m_frames_in_flight)) {
+        return false;
+    }
+    m_async_compute = std::make_unique<vbr::acompute::Scheduler>(*this);
+    if (!m_async_compute->init(m_vk_queue_indices.compute.value(),
+                               m_vk_queues.compute,
+                               m_vk_queue_indices.graphics.value(),
+                               m_frames_in_flight)) {
+        return false;
+    }
+    m_profiler = std::make_unique<vbr::profile::Profiler>(*this);
+    if (!m_profiler->init(m_vk_queue_indices.graphics.value(),
+                          m_frames_in_flight)) {
+        return false;
+    }
+    m_pipeline_stats = std::make_unique<vbr::pstats::Collector>(*this);
+    if (!m_pipeline_stats->init(m_frames_in_flight)) {
         return false;
     }
     return true;
 }
 
+bool Device::initBindless() {
+    if (!m_descriptor_indexing) {
+        return true;
+    }
+    VkPhysicalDeviceVulkan12Properties properties12{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES,
+        .pNext = nullptr,
+    };
+    VkPhysicalDeviceProperties2 properties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &properties12,
+        .properties = {},
+    };
+    vkGetPhysicalDeviceProperties2(m_vk_phy_device, &properties);
+
+    // every binding is visible to all stages, per stage limits apply
+    uint32_t images = std::min(
+        {bindless_images,
+         properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+         properties12.maxDescriptorSetUpdateAfterBindSampledImages});
+    uint32_t samplers =
+        std::min({bindless_samplers,
+                  properties12.maxPerStageDescriptorUpdateAfterBindSamplers,
+                  properties12.maxDescriptorSetUpdateAfterBindSamplers,
+                  m_vk_phy_info.properties.limits.maxSamplerAllocationCount});
+    uint32_t buffers = std::min(
+        {bindless_buffers,
+         properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+         properties12.maxDescriptorSetUpdateAfterBindStorageBuffers});
+    // all three arrays count against the per stage total, shrink them
+    // evenly when they would not fit together
+    uint64_t total = uint64_t{images} + samplers + buffers;
+    uint64_t limit = properties12.maxPerStageUpdateAfterBindResources;
+    if (total > limit) {
+        images = static_cast<uint32_t>(images * limit / total);
+        samplers = static_cast<uint32_t>(samplers * limit / total);
+        buffers = static_cast<uint32_t>(buffers * limit / total);
+    }
+    m_bindless = std::make_unique<vbr::bindless::Table>(m_vk_device);
+    return m_bindless->init(images, samplers, buffers);
+}
+
+bool Device::initUniformRing() {
+    auto buffer = createBuffer(uniform_ring_size,
+                               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (!buffer || buffer->map(uniform_ring_size) == nullptr) {
+        spdlog::error("failed to create uniform ring");
+        return false;
+    }
+    buffer->size = uniform_ring_size;
+    m_uniform_ring = std::make_unique<vbr::uniform::Ring>(
+        std::move(buffer), uniform_ring_size,
+        m_vk_phy_info.properties.limits.minUniformBufferOffsetAlignment,
+        m_frames_in_flight);
+    return true;
+}
+
 VkCommandBuffer Device::beginTemporaryCommand() {
     VkCommandBufferAllocateInfo info{
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
@@ -496,8 +846,9 @@ void Device::endTemporaryCommand(VkCommandBuffer &cmd) {
         .signalSemaphoreCount = 0,
         .pSignalSemaphores = nullptr,
     };
-    vkQueueSubmit(m_vk_queues.transfer, 1, &info, VK_NULL_HANDLE);
-    vkQueueWaitIdle(m_vk_queues.transfer);
+    // the pool belongs to the graphics family
+    vkQueueSubmit(m_vk_queues.graphics, 1, &info, VK_NULL_HANDLE);
+    vkQueueWaitIdle(m_vk_queues.graphics);
     vkFreeCommandBuffers(m_vk_device, m_vk_cmd_pool, 1, &cmd);
 }
 
@@ -515,9 +866,24 @@ uint32_t Device::findMemoryType(uint32_t type_filter,
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
+bool Device::allocateMemory(const VkMemoryRequirements &requirements,
+                            VkMemoryPropertyFlags properties, bool linear,
+                            vbr::allocator::Allocation &allocation) {
+    return m_allocator->allocate(
+        requirements, findMemoryType(requirements.memoryTypeBits, properties),
+        linear, allocation);
+}
+
+void Device::freeMemory(vbr::allocator::Allocation &allocation) {
+    if (m_allocator) {
+        m_allocator->free(allocation);
+    }
+}
+
 std::unique_ptr<vbr::buffer::Buffer>
 Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
-                     VkMemoryPropertyFlags properties) {
+                     VkMemoryPropertyFlags properties,
+                     const std::vector<uint32_t> &families) {
     auto ret = std::make_unique<vbr::buffer::Buffer>(*this);
     VkBufferCreateInfo binfo{
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -529,6 +895,11 @@ Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
         .queueFamilyIndexCount = 0,
         .pQueueFamilyIndices = nullptr,
     };
+    if (families.size() > 1) {
+        binfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        binfo.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+        binfo.pQueueFamilyIndices = families.data();
+    }
     if (VK_SUCCESS !=
         vkCreateBuffer(m_vk_device, &binfo, nullptr, &ret->buffer)) {
         spdlog::error("failed to create buffer");
@@ -538,15 +909,7 @@ Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
     VkMemoryRequirements requirements;
     vkGetBufferMemoryRequirements(m_vk_device, ret->buffer, &requirements);
 
-    VkMemoryAllocateInfo minfo{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = nullptr,
-        .allocationSize = requirements.size,
-        .memoryTypeIndex =
-            findMemoryType(requirements.memoryTypeBits, properties),
-    };
-    if (VK_SUCCESS !=
-        vkAllocateMemory(m_vk_device, &minfo, nullptr, &ret->memory)) {
+    if (!allocateMemory(requirements, properties, true, ret->allocation)) {
         spdlog::error("failed to alloc memory for buffer");
         vkDestroyBuffer(m_vk_device, ret->buffer, nullptr);
         ret->buffer = VK_NULL_HANDLE;
@@ -560,7 +923,8 @@ bool Device::internalCreateSampleImage(uint32_t w, uint32_t h, VkFormat format,
                                        VkImageTiling tilling,
                                        VkImageUsageFlags usage,
                                        VkMemoryPropertyFlags properties,
-                                       VkImage &image, VkDeviceMemory &memory) {
+                                       VkImage &image,
+                                       vbr::allocator::Allocation &allocation) {
     VkImageCreateInfo image_info{
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .pNext = nullptr,
@@ -593,25 +957,23 @@ bool Device::internalCreateSampleImage(uint32_t w, uint32_t h, VkFormat format,
     VkMemoryRequirements requirements;
     vkGetImageMemoryRequirements(m_vk_device, image, &requirements);
 
-    VkMemoryAllocateInfo minfo{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = nullptr,
-        .allocationSize = requirements.size,
-        .memoryTypeIndex =
-            findMemoryType(requirements.memoryTypeBits, properties),
-    };
-    if (VK_SUCCESS != vkAllocateMemory(m_vk_device, &minfo, nullptr, &memory)) {
+    if (!allocateMemory(requirements, properties,
+                        tilling == VK_IMAGE_TILING_LINEAR, allocation)) {
         spdlog::error("failed to alloc memory for image");
+        vkDestroyImage(m_vk_device, image, nullptr);
+        image = VK_NULL_HANDLE;
         return false;
     }
-    vkBindImageMemory(m_vk_device, image, memory, 0);
+    vkBindImageMemory(m_vk_device, image, allocation.memory,
+                      allocation.offset);
     return true;
 }
 
 bool Device::internalCreateImage(uint32_t w, uint32_t h, VkFormat format,
                                  VkImageTiling tilling, VkImageUsageFlags usage,
                                  VkMemoryPropertyFlags properties,
-                                 VkImage &image, VkDeviceMemory &memory) {
+                                 VkImage &image,
+                                 vbr::allocator::Allocation &allocation) {
     VkImageCreateInfo image_info{
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
         .pNext = nullptr,
@@ -644,30 +1006,126 @@ bool Device::internalCreateImage(uint32_t w, uint32_t h, VkFormat format,
     VkMemoryRequirements requirements;
     vkGetImageMemoryRequirements(m_vk_device, image, &requirements);
 
-    VkMemoryAllocateInfo minfo{
-        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .pNext = nullptr,
-        .allocationSize = requirements.size,
-        .memoryTypeIndex =
-            findMemoryType(requirements.memoryTypeBits, properties),
-    };
-    if (VK_SUCCESS != vkAllocateMemory(m_vk_device, &minfo, nullptr, &memory)) {
+    if (!allocateMemory(requirements, properties,
+                        tilling == VK_IMAGE_TILING_LINEAR, allocation)) {
+        spdlog::error("failed to alloc memory for image");
+        vkDestroyImage(m_vk_device, image, nullptr);
+        image = VK_NULL_HANDLE;
+        return false;
+    }
+    vkBindImageMemory(m_vk_device, image, allocation.memory,
+                      allocation.offset);
+    return true;
+}
+
+std::unique_ptr<vbr::buffer::Buffer>
+Device::createStorageBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                            bool shared) {
+    std::vector<uint32_t> families;
+    uint32_t graphics = m_vk_queue_indices.graphics.value();
+    uint32_t compute = m_vk_queue_indices.compute.value();
+    if (shared && graphics != compute) {
+        families = {graphics, compute};
+    }
+    auto ret = createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usage,
+                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, families);
+    if (!ret) {
+        spdlog::error("failed to create storage buffer of {} bytes", size);
+        return ret;
+    }
+    ret->size = size;
+    if (m_bindless) {
+        ret->index = m_bindless->addBuffer(ret->buffer);
+    }
+    return ret;
+}
+
+std::unique_ptr<vbr::indirect::Buffer>
+Device::createIndirectBuffer(uint32_t capacity, vbr::indirect::Fill fill) {
+    VkDeviceSize alignment =
+        m_vk_phy_info.properties.limits.minStorageBufferOffsetAlignment;
+    uint32_t regions =
+        fill == vbr::indirect::Fill::cpu ? m_frames_in_flight : 1;
+    VkDeviceSize size =
+        vbr::indirect::Buffer::bytes(capacity, alignment, regions);
+
+    std::unique_ptr<vbr::buffer::Buffer> buffer;
+    if (fill == vbr::indirect::Fill::cpu) {
+        buffer = createBuffer(size, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                  VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (buffer && buffer->map(size) == nullptr) {
+            buffer.reset();
+        }
+    } else {
+        buffer = createBuffer(size,
+                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    if (!buffer) {
+        spdlog::error("failed to create indirect buffer of {} draws",
+                      capacity);
+        return nullptr;
+    }
+    buffer->size = size;
+    if (m_bindless && fill == vbr::indirect::Fill::gpu) {
+        buffer->index = m_bindless->addBuffer(buffer->buffer);
+    }
+    return std::make_unique<vbr::indirect::Buffer>(std::move(buffer), fill,
+                                                   capacity, alignment,
+                                                   regions);
+}
+
+std::unique_ptr<vbr::buffer::Buffer>
+Device::createReadbackBuffer(VkDeviceSize size) {
+    auto ret = createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (ret && ret->map(size) == nullptr) {
+        ret.reset();
+    }
+    if (!ret) {
+        spdlog::error("failed to create readback buffer of {} bytes", size);
+        return ret;
+    }
+    ret->size = size;
+    return ret;
+}
+
+bool Device::createImage(const VkImageCreateInfo &info, VkImage &image,
+                         vbr::allocator::Allocation &allocation) {
+    if (VK_SUCCESS != vkCreateImage(m_vk_device, &info, nullptr, &image)) {
+        spdlog::error("failed to create image");
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_vk_device, image, &requirements);
+    if (!allocateMemory(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        false, allocation)) {
         spdlog::error("failed to alloc memory for image");
+        vkDestroyImage(m_vk_device, image, nullptr);
+        image = VK_NULL_HANDLE;
         return false;
     }
-    vkBindImageMemory(m_vk_device, image, memory, 0);
+    vkBindImageMemory(m_vk_device, image, allocation.memory,
+                      allocation.offset);
     return true;
 }
 
-void Device::transitionImageLayout(VkImage &image, VkImageLayout old_layout,
-                                   VkImageLayout new_layout) {
-    auto cmd = beginTemporaryCommand();
-    vbr::util::transitionImageLayout(cmd, image, old_layout, new_layout);
-    endTemporaryCommand(cmd);
+void Device::destroyImage(VkImage &image,
+                          vbr::allocator::Allocation &allocation) {
+    if (image != VK_NULL_HANDLE) {
+        vkDestroyImage(m_vk_device, image, nullptr);
+        image = VK_NULL_HANDLE;
+    }
+    freeMemory(allocation);
 }
 
 std::unique_ptr<vbr::image::Texture>
-Device::createTexture(std::string_view path) {
+Device::createTexture(std::string_view path, vbr::upload::Ticket *ticket) {
     int width, height, channels;
     stbi_uc *pixels =
         stbi_load(path.data(), &width, &height, &channels, STBI_rgb_alpha);
@@ -690,16 +1148,18 @@ Device::createTexture(std::string_view path) {
     internalCreateImage(
         width, height, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ret->image, ret->memory);
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ret->image, ret->allocation);
 
-    transitionImageLayout(ret->image, VK_IMAGE_LAYOUT_UNDEFINED,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    ret->copyFrom(buffer->buffer, {width, height});
-    transitionImageLayout(ret->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    buffer.reset();
+    auto t = m_uploader->copyTexture(std::move(buffer), *ret, {width, height});
+    if (ticket) {
+        *ticket = t;
+    }
 
     ret->init(VK_FORMAT_R8G8B8A8_SRGB);
+    if (m_bindless) {
+        ret->index = m_bindless->addImage(ret->view);
+        ret->sampler_index = m_bindless->addSampler(ret->sampler);
+    }
     return ret;
 }
 } // namespace vbr::device
@@ -0,0 +1,99 @@
+#include "../../inc/draw_queue.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vbr::draw {
+
+constexpr uint32_t id_bits = 16;
+constexpr uint32_t max_id = (1u << id_bits) - 1;
+
+// positive floats order like their bits, negative depths are clamped
+static uint32_t depthBits(float depth) {
+    depth = std::max(depth, 0.0f);
+    uint32_t bits = 0;
+    memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+uint64_t Queue::key(const Packet &packet) {
+    // ids past the key width share the last one and only lose grouping
+    uint64_t pipeline = std::min(
+        m_pipeline_ids
+            .try_emplace(packet.pipeline,
+                         static_cast<uint32_t>(m_pipeline_ids.size()))
+            .first->second,
+        max_id);
+    uint64_t set = std::min(
+        m_set_ids
+            .try_emplace(packet.set, static_cast<uint32_t>(m_set_ids.size()))
+            .first->second,
+        max_id);
+    uint64_t depth = depthBits(packet.depth) >> 1;
+    if (!packet.transparent) {
+        // 1 opaque bit, 16 pipeline, 16 set, 31 depth
+        return pipeline << 47 | set << 31 | depth;
+    }
+    // 1 transparent bit, 31 inverted depth, 16 pipeline, 16 set
+    return 1ull << 63 | (~depth & 0x7fffffffull) << 32 | pipeline << 16 | set;
+}
+
+bool Queue::push(const Packet &packet, const void *push_data) {
+    if (packet.dynamic_offset_count > max_dynamic_offsets) {
+        spdlog::error("draw with {} dynamic offsets, at most {}",
+                      packet.dynamic_offset_count, max_dynamic_offsets);
+        return false;
+    }
+    uint32_t index = static_cast<uint32_t>(m_packets.size());
+    m_packets.push_back(packet);
+    m_push_offsets.push_back(static_cast<uint32_t>(m_push_data.size()));
+    if (push_data != nullptr && packet.push_size > 0) {
+        const auto *bytes = static_cast<const uint8_t *>(push_data);
+        m_push_data.insert(m_push_data.end(), bytes, bytes + packet.push_size);
+    } else {
+        m_packets.back().push_size = 0;
+    }
+    m_items.push_back({key(packet), index});
+    m_sorted = false;
+    return true;
+}
+
+void Queue::sort() {
+    if (m_sorted || m_items.empty()) {
+        return;
+    }
+    m_scratch.resize(m_items.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        std::array<uint32_t, 256> counts{};
+        for (const auto &item : m_items) {
+            counts[(item.key >> shift) & 0xff]++;
+        }
+        // every key has the same byte here, the pass keeps the order
+        if (counts[(m_items.front().key >> shift) & 0xff] == m_items.size()) {
+            continue;
+        }
+        uint32_t sum = 0;
+        for (auto &count : counts) {
+            uint32_t n = count;
+            count = sum;
+            sum += n;
+        }
+        for (const auto &item : m_items) {
+            m_scratch[counts[(item.key >> shift) & 0xff]++] = item;
+        }
+        m_items.swap(m_scratch);
+    }
+    m_sorted = true;
+}
+
+void Queue::clear() {
+    m_packets.clear();
+    m_push_data.clear();
+    m_push_offsets.clear();
+    m_items.clear();
+    m_pipeline_ids.clear();
+    m_set_ids.clear();
+    m_sorted = true;
+}
+
+} // namespace vbr::draw
@@ -0,0 +1,460 @@
+#include "../../inc/gpu_cull.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vbr::cull {
+
+// whole pyramid levels, enough for 64k texel depth buffers
+static constexpr uint32_t max_levels = 16;
+
+// frustum planes of a vulkan projection, depth in [0, 1]
+static void extractPlanes(const glm::mat4 &m, glm::vec4 *planes) {
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = {m[0][i], m[1][i], m[2][i], m[3][i]};
+    }
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int i = 0; i < 6; ++i) {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+static VkImageMemoryBarrier2 levelBarrier(VkImage image, uint32_t level,
+                                          uint32_t count,
+                                          VkImageLayout old_layout,
+                                          VkPipelineStageFlags2 src_stages,
+                                          VkAccessFlags2 src_access,
+                                          VkAccessFlags2 dst_access) {
+    return {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = src_stages,
+        .srcAccessMask = src_access,
+        .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask = dst_access,
+        .oldLayout = old_layout,
+        .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = level,
+                .levelCount = count,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+}
+
+Culler::Culler(vbr::device::Device &device) : m_device(device) {}
+
+Culler::~Culler() {
+    destroyPyramid();
+    if (m_sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(*m_device, m_sampler, nullptr);
+    }
+}
+
+bool Culler::init(uint32_t capacity, std::string_view cull_shader,
+                  std::string_view pyramid_shader) {
+    // survivors are found again in the vertex stage through firstInstance
+    if (!m_device.drawIndirectFirstInstance()) {
+        spdlog::error("gpu culling needs draw indirect first instance");
+        return false;
+    }
+    m_draws = m_device.createIndirectBuffer(capacity, vbr::indirect::Fill::gpu);
+    m_slots = m_device.framesInFlight();
+    m_readback = m_device.createReadbackBuffer(sizeof(uint32_t) * m_slots);
+    if (!m_draws || !m_readback) {
+        return false;
+    }
+    memset(m_readback->data, 0, sizeof(uint32_t) * m_slots);
+
+    // texel fetches only, every level is read exactly
+    VkSamplerCreateInfo sampler_info{
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .mipLodBias = 0.0f,
+        .anisotropyEnable = VK_FALSE,
+        .maxAnisotropy = 1.0f,
+        .compareEnable = VK_FALSE,
+        .compareOp = VK_COMPARE_OP_ALWAYS,
+        .minLod = 0.0f,
+        .maxLod = VK_LOD_CLAMP_NONE,
+        .borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+    if (VK_SUCCESS !=
+        vkCreateSampler(*m_device, &sampler_info, nullptr, &m_sampler)) {
+        spdlog::error("failed to create depth pyramid sampler");
+        return false;
+    }
+
+    m_reduce_sets = std::make_unique<vbr::descriptor::Descriptor>(
+        *m_device, &m_device.descriptorAllocator(), &m_device.layouts());
+    m_reduce_sets->addDescriptorBinding(
+        0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_SHADER_STAGE_COMPUTE_BIT);
+    m_reduce_sets->addDescriptorBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                                        VK_SHADER_STAGE_COMPUTE_BIT);
+    m_reduce_sets->maxSet(max_levels);
+    if (!m_reduce_sets->init()) {
+        return false;
+    }
+    m_reduce_layout = std::make_unique<vbr::layout::Layout>(
+        *m_device, &m_device.layouts());
+    m_reduce_layout->addConstnat(VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                 sizeof(Reduce));
+    if (!m_reduce_layout->init({**m_reduce_sets})) {
+        return false;
+    }
+    m_reduce = std::make_unique<vbr::cpipeline::Pipeline>(m_device);
+    m_reduce->setShader(pyramid_shader);
+    m_reduce->addConstant(0, reduce_group_size);
+    m_reduce->addConstant(1, reduce_group_size);
+    if (!m_reduce->init(**m_reduce_layout)) {
+        return false;
+    }
+
+    m_cull_set = std::make_unique<vbr::descriptor::Descriptor>(
+        *m_device, &m_device.descriptorAllocator(), &m_device.layouts());
+    m_cull_set->addDescriptorBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT);
+    m_cull_set->addDescriptorBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT);
+    m_cull_set->addDescriptorBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                     VK_SHADER_STAGE_COMPUTE_BIT);
+    m_cull_set->addDescriptorBinding(
+        3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        VK_SHADER_STAGE_COMPUTE_BIT);
+    m_cull_set->addDescriptorBinding(
+        4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_SHADER_STAGE_COMPUTE_BIT);
+    if (!m_cull_set->init()) {
+        return false;
+    }
+    m_cull_layout = std::make_unique<vbr::layout::Layout>(*m_device,
+                                                          &m_device.layouts());
+    if (!m_cull_layout->init({**m_cull_set})) {
+        return false;
+    }
+    m_cull = std::make_unique<vbr::cpipeline::Pipeline>(m_device);
+    m_cull->setShader(cull_shader);
+    m_cull->addConstant(0, group_size);
+    if (!m_cull->init(**m_cull_layout)) {
+        return false;
+    }
+    updateSets();
+    return true;
+}
+
+void Culler::destroyPyramid() {
+    for (auto &view : m_level_views) {
+        vkDestroyImageView(*m_device, view, nullptr);
+    }
+    m_level_views.clear();
+    m_level_extents.clear();
+    if (m_pyramid_view != VK_NULL_HANDLE) {
+        vkDestroyImageView(*m_device, m_pyramid_view, nullptr);
+        m_pyramid_view = VK_NULL_HANDLE;
+    }
+    m_device.destroyImage(m_pyramid, m_pyramid_memory);
+    m_depth_view = VK_NULL_HANDLE;
+    m_pyramid_built = false;
+}
+
+bool Culler::resize(VkExtent2D extent) {
+    destroyPyramid();
+    uint32_t levels = 1;
+    while (levels < max_levels &&
+           std::max(extent.width, extent.height) >> levels > 0) {
+        levels++;
+    }
+    VkImageCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent =
+            {
+                .width = extent.width,
+                .height = extent.height,
+                .depth = 1,
+            },
+        .mipLevels = levels,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    if (!m_device.createImage(info, m_pyramid, m_pyramid_memory)) {
+        spdlog::error("failed to create depth pyramid {}x{}", extent.width,
+                      extent.height);
+        return false;
+    }
+
+    VkImageViewCreateInfo view_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .image = m_pyramid,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .components = {},
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = levels,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+    if (VK_SUCCESS !=
+        vkCreateImageView(*m_device, &view_info, nullptr, &m_pyramid_view)) {
+        spdlog::error("failed to create depth pyramid view");
+        return false;
+    }
+    for (uint32_t level = 0; level < levels; ++level) {
+        view_info.subresourceRange.baseMipLevel = level;
+        view_info.subresourceRange.levelCount = 1;
+        VkImageView view = VK_NULL_HANDLE;
+        if (VK_SUCCESS !=
+            vkCreateImageView(*m_device, &view_info, nullptr, &view)) {
+            spdlog::error("failed to create depth pyramid level {}", level);
+            return false;
+        }
+        m_level_views.push_back(view);
+        m_level_extents.push_back({std::max(extent.width >> level, 1u),
+                                   std::max(extent.height >> level, 1u)});
+    }
+    // the cull set samples every level from the first frame on, before
+    // any buildPyramid(), so the levels are in general layout from here
+    VkCommandBuffer cmd = m_device.beginTemporaryCommand();
+    if (cmd == VK_NULL_HANDLE) {
+        return false;
+    }
+    vbr::util::BarrierBatch()
+        .image(levelBarrier(m_pyramid, 0, levels, VK_IMAGE_LAYOUT_UNDEFINED,
+                            VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT))
+        .flush(cmd);
+    m_device.endTemporaryCommand(cmd);
+    updateSets();
+    return true;
+}
+
+void Culler::objects(const vbr::buffer::Buffer &buffer, uint32_t count) {
+    m_objects = {buffer.buffer, 0, sizeof(Object) * std::max(count, 1u)};
+    m_object_count = count;
+    m_stats.objects = count;
+    updateSets();
+}
+
+void Culler::updateSets() {
+    if (!m_cull_set) {
+        return;
+    }
+    vbr::descriptor::Writer writer(*m_device);
+    VkDescriptorSet set = m_cull_set->set();
+    if (m_objects.buffer != VK_NULL_HANDLE) {
+        writer.writeBuffer(set, 0, m_objects,
+                           VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    }
+    writer.writeBuffer(set, 1, m_draws->countInfo(),
+                       VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    writer.writeBuffer(set, 2, m_draws->commandInfo(),
+                       VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    writer.writeBuffer(set, 3, m_device.uniformRing().info(sizeof(View)),
+                       VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+    if (m_pyramid_view != VK_NULL_HANDLE) {
+        writer.writeImage(set, 4,
+                          {
+                              .sampler = m_sampler,
+                              .imageView = m_pyramid_view,
+                              .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                          },
+                          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    }
+    // level 0 reads the depth buffer, written by buildPyramid()
+    for (uint32_t level = 0; level < m_level_views.size(); ++level) {
+        VkDescriptorSet reduce = m_reduce_sets->set(level);
+        if (level > 0) {
+            writer.writeImage(reduce, 0,
+                              {
+                                  .sampler = m_sampler,
+                                  .imageView = m_level_views[level - 1],
+                                  .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                              },
+                              VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        }
+        writer.writeImage(reduce, 1,
+                          {
+                              .sampler = VK_NULL_HANDLE,
+                              .imageView = m_level_views[level],
+                              .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                          },
+                          VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+    }
+    writer.flush();
+}
+
+void Culler::buildPyramid(VkCommandBuffer cmd, VkImageView depth,
+                          VkImageLayout layout) {
+    if (m_pyramid == VK_NULL_HANDLE || *m_reduce == VK_NULL_HANDLE) {
+        spdlog::error("depth pyramid is not ready, call resize first");
+        return;
+    }
+    if (depth != m_depth_view) {
+        // sets of frames in flight may still read the old view
+        m_device.waitIdle();
+        vbr::descriptor::Writer writer(*m_device);
+        writer.writeImage(m_reduce_sets->set(0), 0,
+                          {
+                              .sampler = m_sampler,
+                              .imageView = depth,
+                              .imageLayout = layout,
+                          },
+                          VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        writer.flush();
+        m_depth_view = depth;
+    }
+
+    // every level is rewritten, the last frame's cull reads are all that
+    // must finish first, the levels stay in general layout for them
+    uint32_t levels = static_cast<uint32_t>(m_level_views.size());
+    vbr::util::BarrierBatch()
+        .image(levelBarrier(m_pyramid, 0, levels, VK_IMAGE_LAYOUT_GENERAL,
+                            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                            VK_ACCESS_2_NONE,
+                            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT))
+        .flush(cmd);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, *m_reduce);
+    VkExtent2D src = m_level_extents[0];
+    for (uint32_t level = 0; level < levels; ++level) {
+        VkExtent2D dst = m_level_extents[level];
+        Reduce push{
+            .src_size = glm::ivec2(src.width, src.height),
+            .dst_size = glm::ivec2(dst.width, dst.height),
+        };
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                **m_reduce_layout, 0, 1,
+                                &m_reduce_sets->set(level), 0, nullptr);
+        vkCmdPushConstants(cmd, **m_reduce_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+                           0, sizeof(push), &push);
+        vkCmdDispatch(cmd,
+                      (dst.width + reduce_group_size - 1) / reduce_group_size,
+                      (dst.height + reduce_group_size - 1) /
+                          reduce_group_size,
+                      1);
+        // the next level and the cull shader sample this one
+        vbr::util::BarrierBatch()
+            .image(levelBarrier(m_pyramid, level, 1, VK_IMAGE_LAYOUT_GENERAL,
+                                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                VK_ACCESS_2_SHADER_SAMPLED_READ_BIT))
+            .flush(cmd);
+        src = dst;
+    }
+    m_pyramid_built = true;
+}
+
+void Culler::cull(VkCommandBuffer cmd, uint32_t frame,
+                  const glm::mat4 &view_proj, bool occlusion) {
+    if (m_objects.buffer == VK_NULL_HANDLE ||
+        m_pyramid_view == VK_NULL_HANDLE || *m_cull == VK_NULL_HANDLE) {
+        spdlog::error("culler has no objects or pyramid");
+        return;
+    }
+    // the slot's frame is done, its count is final
+    uint32_t slot = frame % m_slots;
+    auto *counts = static_cast<uint32_t *>(m_readback->data);
+    // the shader counts every survivor but only writes up to capacity
+    uint32_t passed = counts[slot];
+    m_stats.visible = std::min(passed, m_draws->capacity());
+    m_stats.dropped = passed - m_stats.visible;
+
+    View view{
+        .view_proj = view_proj,
+        .planes = {},
+        .pyramid_size = {static_cast<float>(m_level_extents[0].width),
+                         static_cast<float>(m_level_extents[0].height)},
+        .object_count = m_object_count,
+        .occlusion = occlusion && m_pyramid_built ? 1u : 0u,
+    };
+    extractPlanes(view_proj, view.planes);
+    vbr::uniform::Slice slice = m_device.uniformRing().push(view);
+    if (!slice.valid()) {
+        return;
+    }
+
+    // the last frame may still draw from and copy the count
+    VkBuffer draws = m_draws->buffer();
+    vbr::util::BarrierBatch()
+        .buffer(draws,
+                VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+                    VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_NONE,
+                VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT |
+                    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_NONE)
+        .flush(cmd);
+    m_draws->clear(cmd);
+    vbr::util::BarrierBatch()
+        .buffer(draws, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                m_draws->countOffset(), sizeof(uint32_t))
+        .flush(cmd);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, *m_cull);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            **m_cull_layout, 0, 1, &m_cull_set->set(), 1,
+                            &slice.offset);
+    vkCmdDispatch(cmd, (m_object_count + group_size - 1) / group_size, 1, 1);
+
+    vbr::util::BarrierBatch batch;
+    m_draws->barrier(batch);
+    batch
+        .buffer(draws, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_READ_BIT, m_draws->countOffset(),
+                sizeof(uint32_t))
+        .flush(cmd);
+    VkBufferCopy region{
+        .srcOffset = m_draws->countOffset(),
+        .dstOffset = slot * sizeof(uint32_t),
+        .size = sizeof(uint32_t),
+    };
+    vkCmdCopyBuffer(cmd, draws, m_readback->buffer, 1, &region);
+    vbr::util::BarrierBatch()
+        .buffer(m_readback->buffer, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_HOST_BIT,
+                VK_ACCESS_2_HOST_READ_BIT, region.dstOffset, region.size)
+        .flush(cmd);
+}
+
+} // namespace vbr::cull
@@ -2,7 +2,7 @@
 #include "../../inc/util.hpp"
 #include "spdlog/spdlog.h"
 #include "vulkan/vulkan_core.h"
-#include <SDL3/SDL_iostream.h>
+#include <chrono>
 #include <cstdint>
 #include <vector>
 
@@ -11,6 +11,7 @@ namespace vbr::gpipeline {
 Pipeline::Pipeline(vbr::device::Device &device) : m_device(device) {}
 
 Pipeline::~Pipeline() {
+    wait();
     if (*m_device != VK_NULL_HANDLE) {
         vkDeviceWaitIdle(*m_device);
     }
@@ -19,66 +20,88 @@ Pipeline::~Pipeline() {
         vkDestroyPipeline(*m_device, m_pipeline, nullptr);
         m_pipeline = VK_NULL_HANDLE;
     }
-}
-
-VkShaderModule Pipeline::createShaderModule(std::string_view path) {
-    if (*m_device == VK_NULL_HANDLE) {
-        spdlog::error("invalid pipeline {}", __LINE__);
-        return VK_NULL_HANDLE;
-    }
-    size_t size = 0;
-    void *code = SDL_LoadFile(path.data(), &size);
-
-    VkShaderModuleCreateInfo info{
-        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
-        .codeSize = size,
-        .pCode = static_cast<uint32_t *>(code),
-    };
-    VkShaderModule module = VK_NULL_HANDLE;
-    if (VK_SUCCESS !=
-        vkCreateShaderModule(*m_device, &info, nullptr, &module)) {
-        spdlog::error("failed to create shader module");
-        return VK_NULL_HANDLE;
+    if (*m_device != VK_NULL_HANDLE) {
+        releaseShaderModules();
+        m_device.pipelineStats().forget(m_statistics);
     }
-    return module;
 }
 
-void Pipeline::destroyAllShaderModule() {
-    if (*m_device == VK_NULL_HANDLE) {
-        spdlog::error("invalid pipeline {}", __LINE__);
-        return;
-    }
-    for (auto &info : m_shader_stages) {
-        if (info.module != VK_NULL_HANDLE) {
-            vkDestroyShaderModule(*m_device, info.module, nullptr);
-        }
+void Pipeline::releaseShaderModules() {
+    for (auto &module : m_modules) {
+        m_device.shaders().release(module);
     }
+    m_modules.clear();
 }
 
 void Pipeline::addShader(const VkShaderStageFlagBits &stage,
                          std::string_view shader_path,
                          const VkSpecializationInfo *special_info,
                          std::string_view name) {
-    VkShaderModule module = createShaderModule(shader_path);
-    VkPipelineShaderStageCreateInfo info{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = 0,
+    m_shaders.push_back({
         .stage = stage,
-        .module = module,
-        .pName = name.data(),
-        .pSpecializationInfo = special_info,
-    };
-    m_shader_stages.push_back(info);
+        .path = std::string(shader_path),
+        .name = std::string(name),
+        .special_info = special_info,
+    });
 }
 
 bool Pipeline::init(VkPipelineLayout &layout) {
+    wait();
+    m_state.store(State::building, std::memory_order_relaxed);
+    bool ret = build(layout);
+    finish(ret);
+    return ret;
+}
+
+void Pipeline::initAsync(VkPipelineLayout layout) {
+    wait();
+    m_state.store(State::building, std::memory_order_relaxed);
+    m_device.workers().submit([this, layout] { finish(build(layout)); });
+}
+
+void Pipeline::finish(bool ret) {
+    std::lock_guard lock(m_build_mutex);
+    m_state.store(ret ? State::ready : State::failed,
+                  std::memory_order_release);
+    m_build_cv.notify_all();
+}
+
+bool Pipeline::wait() {
+    std::unique_lock lock(m_build_mutex);
+    m_build_cv.wait(lock, [this] { return state() != State::building; });
+    return state() == State::ready;
+}
+
+bool Pipeline::build(VkPipelineLayout layout) {
     if (*m_device == VK_NULL_HANDLE) {
         spdlog::error("invalid graphics pipeline {}", __LINE__);
         return false;
     }
+    if (m_pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(*m_device, m_pipeline, nullptr);
+        m_pipeline = VK_NULL_HANDLE;
+    }
+    releaseShaderModules();
+
+    std::vector<VkPipelineShaderStageCreateInfo> shader_stages;
+    for (const auto &shader : m_shaders) {
+        VkShaderModule module = m_device.shaders().acquire(shader.path);
+        if (module == VK_NULL_HANDLE) {
+            releaseShaderModules();
+            return false;
+        }
+        m_modules.push_back(module);
+        shader_stages.push_back({
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .stage = shader.stage,
+            .module = module,
+            .pName = shader.name.c_str(),
+            .pSpecializationInfo = shader.special_info,
+        });
+    }
+
     VkPipelineVertexInputStateCreateInfo vertex_input_info =
         vbr::util::fillPipelineVertexInput(m_vertex_bindings,
                                            m_vertex_attributes);
@@ -93,7 +116,9 @@ bool Pipeline::init(VkPipelineLayout &layout) {
     VkPipelineMultisampleStateCreateInfo multiple_sample_info =
         vbr::util::fillPipelineMultisample(m_device.sampleCount());
     VkPipelineDepthStencilStateCreateInfo depth_stencil_info =
-        vbr::util::fillPipelineDepthStencil();
+        vbr::util::fillPipelineDepthStencil(
+            m_depth_format != VK_FORMAT_UNDEFINED, m_depth_write,
+            m_depth_compare);
     VkPipelineColorBlendStateCreateInfo color_blend_info =
         vbr::util::fillPipelineColorBlend(m_color_blend_attachment);
 
@@ -113,7 +138,7 @@ bool Pipeline::init(VkPipelineLayout &layout) {
         .viewMask = 0,
         .colorAttachmentCount = 1,
         .pColorAttachmentFormats = &color_format,
-        .depthAttachmentFormat = VK_FORMAT_UNDEFINED,
+        .depthAttachmentFormat = m_depth_format,
         .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
     };
 
@@ -121,8 +146,8 @@ bool Pipeline::init(VkPipelineLayout &layout) {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
         .pNext = nullptr,
         .flags = 0,
-        .stageCount = static_cast<uint32_t>(m_shader_stages.size()),
-        .pStages = m_shader_stages.data(),
+        .stageCount = static_cast<uint32_t>(shader_stages.size()),
+        .pStages = shader_stages.data(),
         .pVertexInputState = &vertex_input_info,
         .pInputAssemblyState = &input_assembly_info,
         .pTessellationState = &tessellation_info,
@@ -138,15 +163,22 @@ bool Pipeline::init(VkPipelineLayout &layout) {
         .basePipelineHandle = VK_NULL_HANDLE,
         .basePipelineIndex = 0,
     };
-    if (m_device.sampleCount() != VK_SAMPLE_COUNT_1_BIT) {
+    if (m_device.sampleCount() != VK_SAMPLE_COUNT_1_BIT ||
+        m_depth_format != VK_FORMAT_UNDEFINED) {
         info.pNext = &rendering_info;
     }
-    if (VK_SUCCESS != vkCreateGraphicsPipelines(*m_device, VK_NULL_HANDLE, 1,
-                                                &info, nullptr, &m_pipeline)) {
+    auto start = std::chrono::steady_clock::now();
+    VkResult ret = vkCreateGraphicsPipelines(
+        *m_device, *m_device.pipelineCache(), 1, &info, nullptr, &m_pipeline);
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (VK_SUCCESS != ret) {
         spdlog::error("failed to create graphics pipeline");
+        m_pipeline = VK_NULL_HANDLE;
+        releaseShaderModules();
         return false;
     }
-    destroyAllShaderModule();
+    m_device.pipelineCache().record(elapsed.count());
     return true;
 }
 
@@ -60,18 +60,23 @@ Texture::Texture(vbr::device::Device &device) : main_device(device) {}
 Texture::~Texture() {
     if (*main_device != VK_NULL_HANDLE) {
         main_device.waitIdle();
-        if (memory != VK_NULL_HANDLE) {
-            vkFreeMemory(*main_device, memory, nullptr);
-            memory = VK_NULL_HANDLE;
-        }
-        if (image != VK_NULL_HANDLE) {
-            vkDestroyImage(*main_device, image, nullptr);
-            image = VK_NULL_HANDLE;
+        if (auto *table = main_device.bindless()) {
+            if (index != vbr::bindless::invalid_index) {
+                table->release(vbr::bindless::Kind::image, index);
+            }
+            if (sampler_index != vbr::bindless::invalid_index) {
+                table->release(vbr::bindless::Kind::sampler, sampler_index);
+            }
         }
         if (view != VK_NULL_HANDLE) {
             vkDestroyImageView(*main_device, view, nullptr);
             view = VK_NULL_HANDLE;
         }
+        if (image != VK_NULL_HANDLE) {
+            vkDestroyImage(*main_device, image, nullptr);
+            image = VK_NULL_HANDLE;
+        }
+        main_device.freeMemory(allocation);
         if (sampler != VK_NULL_HANDLE) {
             vkDestroySampler(*main_device, sampler, nullptr);
         }
@@ -139,8 +144,8 @@ bool Texture::init(VkFormat format) {
     return false;
 }
 
-void Texture::copyFrom(VkBuffer &buffer, glm::ivec2 size) {
-    auto cmd = main_device.beginTemporaryCommand();
+void Texture::copyFrom(VkCommandBuffer &cmd, VkBuffer &buffer,
+                       glm::ivec2 size) {
     VkBufferImageCopy copy_info{
         .bufferOffset = 0,
         .bufferRowLength = 0,
@@ -169,7 +174,6 @@ void Texture::copyFrom(VkBuffer &buffer, glm::ivec2 size) {
     };
     vkCmdCopyBufferToImage(cmd, buffer, image,
                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_info);
-    main_device.endTemporaryCommand(cmd);
 }
 
 } // namespace vbr::image
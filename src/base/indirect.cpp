@@ -0,0 +1,77 @@
+#include "../../inc/indirect.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+
+namespace vbr::indirect {
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static VkDeviceSize headerSize(VkDeviceSize alignment) {
+    // commands only need 4 byte alignment, storage views need more
+    return alignUp(sizeof(uint32_t), std::max<VkDeviceSize>(alignment, 16));
+}
+
+static VkDeviceSize regionSize(uint32_t capacity, VkDeviceSize alignment) {
+    return alignUp(headerSize(alignment) +
+                       capacity * sizeof(VkDrawIndexedIndirectCommand),
+                   std::max<VkDeviceSize>(alignment, 16));
+}
+
+VkDeviceSize Buffer::bytes(uint32_t capacity, VkDeviceSize alignment,
+                           uint32_t regions) {
+    return regionSize(capacity, alignment) * std::max(regions, 1u);
+}
+
+Buffer::Buffer(std::unique_ptr<vbr::buffer::Buffer> buffer, Fill fill,
+               uint32_t capacity, VkDeviceSize alignment, uint32_t regions)
+    : m_buffer(std::move(buffer)), m_fill(fill), m_capacity(capacity),
+      m_header(headerSize(alignment)),
+      m_region_size(regionSize(capacity, alignment)),
+      m_regions(std::max(regions, 1u)) {}
+
+bool Buffer::begin(uint32_t frame, uint32_t frames_in_flight) {
+    m_count = 0;
+    // a region would be shared by frames in flight, recreate the buffer
+    m_stale = m_fill == Fill::cpu && frames_in_flight != m_regions;
+    if (m_stale) {
+        spdlog::error("indirect buffer of {} regions used with {} frames in "
+                      "flight",
+                      m_regions, frames_in_flight);
+        return false;
+    }
+    m_region = frame % m_regions;
+    if (m_buffer->data != nullptr) {
+        memset(region(), 0, sizeof(uint32_t));
+    }
+    return true;
+}
+
+bool Buffer::push(const VkDrawIndexedIndirectCommand &command) {
+    if (m_stale || m_buffer->data == nullptr || m_count == m_capacity) {
+        return false;
+    }
+    uint8_t *base = region();
+    memcpy(base + m_header + m_count * sizeof(command), &command,
+           sizeof(command));
+    m_count++;
+    memcpy(base, &m_count, sizeof(m_count));
+    return true;
+}
+
+void Buffer::clear(VkCommandBuffer cmd) {
+    vkCmdFillBuffer(cmd, m_buffer->buffer, countOffset(), sizeof(uint32_t),
+                    0);
+}
+
+void Buffer::barrier(vbr::util::BarrierBatch &batch) const {
+    batch.buffer(m_buffer->buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                 VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                 VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                 VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, countOffset(),
+                 m_region_size);
+}
+
+} // namespace vbr::indirect
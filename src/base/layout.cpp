@@ -1,13 +1,130 @@
 #include "../../inc/layout.hpp"
+#include "../../inc/util.hpp"
 #include "spdlog/spdlog.h"
 #include "vulkan/vulkan_core.h"
+#include <algorithm>
 #include <cstdint>
 
 namespace vbr::layout {
 
-Layout::Layout(VkDevice &device) : m_device(device) {}
+Cache::Cache(VkDevice &device) : m_device(device) {}
+
+Cache::~Cache() { destroy(); }
+
+size_t Cache::KeyHash::operator()(const Key &key) const {
+    return static_cast<size_t>(
+        vbr::util::hash(key.data(), key.size() * sizeof(uint64_t)));
+}
+
+VkDescriptorSetLayout
+Cache::setLayout(const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+                 VkDescriptorSetLayoutCreateFlags flags) {
+    std::vector<VkDescriptorSetLayoutBinding> sorted = bindings;
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+        return a.binding < b.binding;
+    });
+    Key key{flags};
+    for (const auto &binding : sorted) {
+        key.push_back(binding.binding);
+        key.push_back(binding.descriptorType);
+        key.push_back(binding.descriptorCount);
+        key.push_back(binding.stageFlags);
+        key.push_back(binding.pImmutableSamplers != nullptr);
+        if (binding.pImmutableSamplers != nullptr) {
+            for (uint32_t i = 0; i < binding.descriptorCount; ++i) {
+                key.push_back(reinterpret_cast<uint64_t>(
+                    binding.pImmutableSamplers[i]));
+            }
+        }
+    }
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_set_layouts.find(key);
+    if (it != m_set_layouts.end()) {
+        m_hits++;
+        return it->second;
+    }
+    VkDescriptorSetLayoutCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = flags,
+        .bindingCount = static_cast<uint32_t>(sorted.size()),
+        .pBindings = sorted.data(),
+    };
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if (VK_SUCCESS !=
+        vkCreateDescriptorSetLayout(m_device, &info, nullptr, &layout)) {
+        spdlog::error("failed to create descriptor set layout");
+        return VK_NULL_HANDLE;
+    }
+    m_misses++;
+    m_set_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+VkPipelineLayout
+Cache::pipelineLayout(const std::vector<VkDescriptorSetLayout> &set_layouts,
+                      const std::vector<VkPushConstantRange> &constants) {
+    Key key{set_layouts.size()};
+    for (const auto &set_layout : set_layouts) {
+        key.push_back(reinterpret_cast<uint64_t>(set_layout));
+    }
+    for (const auto &constant : constants) {
+        key.push_back(constant.stageFlags);
+        key.push_back(constant.offset);
+        key.push_back(constant.size);
+    }
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_pipeline_layouts.find(key);
+    if (it != m_pipeline_layouts.end()) {
+        m_hits++;
+        return it->second;
+    }
+    VkPipelineLayoutCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
+        .pSetLayouts = set_layouts.data(),
+        .pushConstantRangeCount = static_cast<uint32_t>(constants.size()),
+        .pPushConstantRanges = constants.empty() ? nullptr : constants.data(),
+    };
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    if (VK_SUCCESS !=
+        vkCreatePipelineLayout(m_device, &info, nullptr, &layout)) {
+        spdlog::error("failed to create pipeline layout");
+        return VK_NULL_HANDLE;
+    }
+    m_misses++;
+    m_pipeline_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+void Cache::destroy() {
+    if (m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    if (m_hits + m_misses > 0) {
+        spdlog::info("layout cache: {} created, {} shared", m_misses, m_hits);
+    }
+    for (auto &[key, layout] : m_pipeline_layouts) {
+        vkDestroyPipelineLayout(m_device, layout, nullptr);
+    }
+    for (auto &[key, layout] : m_set_layouts) {
+        vkDestroyDescriptorSetLayout(m_device, layout, nullptr);
+    }
+    m_pipeline_layouts.clear();
+    m_set_layouts.clear();
+    m_hits = 0;
+    m_misses = 0;
+}
+
+Layout::Layout(VkDevice &device, Cache *cache)
+    : m_device(device), m_cache(cache) {}
 Layout::~Layout() {
-    if (m_device != VK_NULL_HANDLE && m_pipeline_layout != VK_NULL_HANDLE) {
+    if (m_device != VK_NULL_HANDLE && m_pipeline_layout != VK_NULL_HANDLE &&
+        m_cache == nullptr) {
         vkDestroyPipelineLayout(m_device, m_pipeline_layout, nullptr);
         m_pipeline_layout = VK_NULL_HANDLE;
     }
@@ -25,6 +142,10 @@ void Layout::addConstnat(VkShaderStageFlags stage, uint32_t offset,
 }
 
 bool Layout::init(const std::vector<VkDescriptorSetLayout> &dls) {
+    if (m_cache != nullptr) {
+        m_pipeline_layout = m_cache->pipelineLayout(dls, m_constant);
+        return m_pipeline_layout != VK_NULL_HANDLE;
+    }
     VkPipelineLayoutCreateInfo layout_info{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
         .pNext = nullptr,
@@ -0,0 +1,186 @@
+#include "../../inc/pipeline_cache.hpp"
+#include "../../inc/util.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace vbr::pcache {
+
+PipelineCache::PipelineCache(VkDevice &device,
+                             const VkPhysicalDeviceProperties &properties)
+    : m_device(device), m_properties(properties) {}
+
+PipelineCache::~PipelineCache() { destroy(); }
+
+bool PipelineCache::validate(const FileHeader &header,
+                             const std::vector<char> &data) {
+    if (header.magic != file_magic || header.version != file_version) {
+        spdlog::warn("pipeline cache {} has unknown format", m_path);
+        return false;
+    }
+    if (header.vendor_id != m_properties.vendorID ||
+        header.device_id != m_properties.deviceID ||
+        header.driver_version != m_properties.driverVersion ||
+        memcmp(header.uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE) !=
+            0) {
+        spdlog::info("pipeline cache {} is from another device or driver",
+                     m_path);
+        return false;
+    }
+    if (header.data_size != data.size() ||
+        header.data_hash != vbr::util::hash(data.data(), data.size())) {
+        spdlog::warn("pipeline cache {} is corrupted", m_path);
+        return false;
+    }
+
+    // the driver checks again, but a bad blob is better dropped here
+    VkPipelineCacheHeaderVersionOne vk_header;
+    if (data.size() < sizeof(vk_header)) {
+        spdlog::warn("pipeline cache {} is too small", m_path);
+        return false;
+    }
+    memcpy(&vk_header, data.data(), sizeof(vk_header));
+    if (vk_header.headerSize < sizeof(vk_header) ||
+        vk_header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vk_header.vendorID != m_properties.vendorID ||
+        vk_header.deviceID != m_properties.deviceID ||
+        memcmp(vk_header.pipelineCacheUUID, m_properties.pipelineCacheUUID,
+               VK_UUID_SIZE) != 0) {
+        spdlog::warn("pipeline cache {} has a bad vulkan header", m_path);
+        return false;
+    }
+    return true;
+}
+
+std::vector<char> PipelineCache::read() {
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) {
+        spdlog::info("no pipeline cache at {}, start cold", m_path);
+        return {};
+    }
+    FileHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+        spdlog::warn("pipeline cache {} has no header", m_path);
+        return {};
+    }
+    // refuse absurd sizes before allocating
+    if (header.data_size > 1024ull * 1024 * 1024) {
+        spdlog::warn("pipeline cache {} is too large", m_path);
+        return {};
+    }
+    std::vector<char> data(header.data_size);
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+        spdlog::warn("pipeline cache {} is truncated", m_path);
+        return {};
+    }
+    if (!validate(header, data)) {
+        return {};
+    }
+    return data;
+}
+
+bool PipelineCache::init(std::string_view path) {
+    m_path = path;
+    std::vector<char> data = m_path.empty() ? std::vector<char>{} : read();
+    m_warm = !data.empty();
+
+    VkPipelineCacheCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+    if (VK_SUCCESS !=
+        vkCreatePipelineCache(m_device, &info, nullptr, &m_cache)) {
+        spdlog::error("failed to create pipeline cache");
+        return false;
+    }
+    if (m_warm) {
+        spdlog::info("load pipeline cache {} ({} bytes)", m_path, data.size());
+    }
+    return true;
+}
+
+bool PipelineCache::save() {
+    if (m_cache == VK_NULL_HANDLE || m_path.empty()) {
+        return false;
+    }
+    size_t size = 0;
+    if (VK_SUCCESS !=
+        vkGetPipelineCacheData(m_device, m_cache, &size, nullptr)) {
+        spdlog::error("failed to get pipeline cache size");
+        return false;
+    }
+    std::vector<char> data(size);
+    if (VK_SUCCESS !=
+        vkGetPipelineCacheData(m_device, m_cache, &size, data.data())) {
+        spdlog::error("failed to get pipeline cache data");
+        return false;
+    }
+    data.resize(size);
+
+    FileHeader header{
+        .magic = file_magic,
+        .version = file_version,
+        .vendor_id = m_properties.vendorID,
+        .device_id = m_properties.deviceID,
+        .driver_version = m_properties.driverVersion,
+        .uuid = {},
+        .reserved = 0,
+        .data_size = data.size(),
+        .data_hash = vbr::util::hash(data.data(), data.size()),
+    };
+    memcpy(header.uuid, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    // a crash mid write leaves the old file intact
+    std::string tmp = m_path + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.flush();
+        if (!file) {
+            spdlog::error("failed to write pipeline cache {}", tmp);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, m_path, ec);
+    if (ec) {
+        spdlog::error("failed to replace pipeline cache {}: {}", m_path,
+                      ec.message());
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    spdlog::info("save pipeline cache {} ({} bytes)", m_path, data.size());
+    return true;
+}
+
+void PipelineCache::destroy() {
+    if (m_device != VK_NULL_HANDLE && m_cache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(m_device, m_cache, nullptr);
+        m_cache = VK_NULL_HANDLE;
+    }
+}
+
+void PipelineCache::record(double ms) {
+    std::lock_guard lock(m_stats_mutex);
+    m_pipelines++;
+    m_create_ms += ms;
+}
+
+void PipelineCache::report() const {
+    std::lock_guard lock(m_stats_mutex);
+    if (m_pipelines == 0) {
+        return;
+    }
+    spdlog::info("{} pipeline cache: {} pipelines in {:.2f} ms ({:.2f} ms "
+                 "each)",
+                 m_warm ? "warm" : "cold", m_pipelines, m_create_ms,
+                 m_create_ms / m_pipelines);
+}
+
+} // namespace vbr::pcache
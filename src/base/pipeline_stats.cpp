@@ -0,0 +1,177 @@
+#include "../../inc/pipeline_stats.hpp"
+#include "../../inc/device.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+namespace vbr::pstats {
+
+void Counters::add(const uint64_t *values) {
+    input_vertices += values[0];
+    input_primitives += values[1];
+    vertex_invocations += values[2];
+    clipping_invocations += values[3];
+    clipping_primitives += values[4];
+    fragment_invocations += values[5];
+    compute_invocations += values[6];
+    samples++;
+}
+
+void report(std::string_view name, const Counters &counters) {
+    if (counters.samples == 0) {
+        return;
+    }
+    spdlog::info("{} pipeline statistics over {} calls", name,
+                 counters.samples);
+    if (counters.compute_invocations > 0) {
+        spdlog::info("  compute invocations {}",
+                     counters.compute_invocations);
+    }
+    if (counters.input_vertices == 0) {
+        return;
+    }
+    spdlog::info("  input vertices {} primitives {}", counters.input_vertices,
+                 counters.input_primitives);
+    spdlog::info("  vertex invocations {} clipped primitives {} of {}",
+                 counters.vertex_invocations, counters.clipping_primitives,
+                 counters.clipping_invocations);
+    spdlog::info("  fragment invocations {}", counters.fragment_invocations);
+    // vertex shading per index, below 1 when the post transform cache hits
+    double shading = static_cast<double>(counters.vertex_invocations) /
+                     static_cast<double>(counters.input_vertices);
+    // fragments per primitive kept, large for big or overdrawn triangles,
+    // near zero for meshes denser than the pixels they cover
+    double fragments =
+        counters.clipping_primitives == 0
+            ? 0.0
+            : static_cast<double>(counters.fragment_invocations) /
+                  static_cast<double>(counters.clipping_primitives);
+    spdlog::info("  {:.3f} vertex invocations per vertex, {:.1f} fragments "
+                 "per primitive",
+                 shading, fragments);
+}
+
+Collector::Collector(vbr::device::Device &device) : m_device(device) {}
+
+Collector::~Collector() { destroy(); }
+
+void Collector::destroy() {
+    for (auto &slot : m_slots) {
+        if (slot.pool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(*m_device, slot.pool, nullptr);
+        }
+    }
+    m_slots.clear();
+    m_recording = false;
+    m_active = false;
+}
+
+bool Collector::init(uint32_t slots, uint32_t max_queries) {
+    destroy();
+    m_supported = m_device.pipelineStatisticsQuery();
+    if (!m_supported) {
+        m_enabled = false;
+        spdlog::warn("no pipeline statistics queries on the device");
+        return true;
+    }
+    m_host_reset = m_device.hostQueryReset();
+    m_max_queries = std::max(max_queries, 1u);
+    m_results.resize(m_max_queries * counter_count);
+
+    VkQueryPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        .queryCount = m_max_queries,
+        .pipelineStatistics = counter_flags,
+    };
+    m_slots.resize(std::max(slots, 1u));
+    for (auto &slot : m_slots) {
+        if (VK_SUCCESS !=
+            vkCreateQueryPool(*m_device, &info, nullptr, &slot.pool)) {
+            spdlog::error("failed to create pipeline statistics query pool");
+            destroy();
+            m_supported = false;
+            m_enabled = false;
+            return false;
+        }
+        if (m_host_reset) {
+            vkResetQueryPool(*m_device, slot.pool, 0, m_max_queries);
+        }
+    }
+    return true;
+}
+
+void Collector::collect(Slot &slot) {
+    if (slot.targets.empty()) {
+        return;
+    }
+    uint32_t count = static_cast<uint32_t>(slot.targets.size());
+    const VkDeviceSize stride = counter_count * sizeof(uint64_t);
+    VkResult ret = vkGetQueryPoolResults(
+        *m_device, slot.pool, 0, count, count * stride, m_results.data(),
+        stride, VK_QUERY_RESULT_64_BIT);
+    if (ret == VK_SUCCESS) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (slot.targets[i] == nullptr) {
+                continue;
+            }
+            slot.targets[i]->add(m_results.data() + i * counter_count);
+        }
+    }
+    slot.targets.clear();
+}
+
+void Collector::begin(VkCommandBuffer cmd, uint32_t slot) {
+    m_recording = false;
+    m_active = false;
+    if (m_slots.empty()) {
+        return;
+    }
+    m_slot = slot % m_slots.size();
+    Slot &current = m_slots[m_slot];
+    // results of the last use are kept even once disabled
+    collect(current);
+    if (!m_enabled) {
+        return;
+    }
+    if (m_host_reset) {
+        vkResetQueryPool(*m_device, current.pool, 0, m_max_queries);
+    } else {
+        vkCmdResetQueryPool(cmd, current.pool, 0, m_max_queries);
+    }
+    m_recording = true;
+}
+
+uint32_t Collector::push(VkCommandBuffer cmd, Counters &counters) {
+    if (!m_recording || m_active) {
+        return invalid_query;
+    }
+    Slot &slot = m_slots[m_slot];
+    if (slot.targets.size() == m_max_queries) {
+        return invalid_query;
+    }
+    uint32_t query = static_cast<uint32_t>(slot.targets.size());
+    slot.targets.push_back(&counters);
+    vkCmdBeginQuery(cmd, slot.pool, query, 0);
+    m_active = true;
+    return query;
+}
+
+void Collector::pop(VkCommandBuffer cmd, uint32_t query) {
+    if (!m_active || query == invalid_query) {
+        return;
+    }
+    vkCmdEndQuery(cmd, m_slots[m_slot].pool, query);
+    m_active = false;
+}
+
+void Collector::forget(const Counters &counters) {
+    for (auto &slot : m_slots) {
+        std::replace(slot.targets.begin(), slot.targets.end(),
+                     const_cast<Counters *>(&counters),
+                     static_cast<Counters *>(nullptr));
+    }
+}
+
+} // namespace vbr::pstats
@@ -0,0 +1,179 @@
+#include "../../inc/profiler.hpp"
+#include "../../inc/device.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+namespace vbr::profile {
+
+Profiler::Profiler(vbr::device::Device &device, uint32_t window)
+    : m_device(device), m_window(std::max(window, 1u)) {}
+
+Profiler::~Profiler() { destroy(); }
+
+void Profiler::destroy() {
+    for (auto &slot : m_slots) {
+        if (slot.pool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(*m_device, slot.pool, nullptr);
+        }
+    }
+    m_slots.clear();
+    m_recording = false;
+    m_enabled = false;
+}
+
+bool Profiler::init(uint32_t family, uint32_t slots, uint32_t max_scopes) {
+    destroy();
+    const VkQueueFamilyProperties &properties =
+        m_device.queueFamilyProperties(family);
+    m_host_reset = m_device.hostQueryReset();
+    bool cmd_reset = properties.queueFlags &
+                     (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (properties.timestampValidBits == 0 || (!m_host_reset && !cmd_reset)) {
+        spdlog::warn("no timestamps on queue family {}, profiler disabled",
+                     family);
+        return true;
+    }
+    m_mask = properties.timestampValidBits >= 64
+                 ? UINT64_MAX
+                 : (uint64_t{1} << properties.timestampValidBits) - 1;
+    m_period = m_device.propreties().limits.timestampPeriod;
+    m_max_scopes = std::max(max_scopes, 1u);
+    m_results.resize(m_max_scopes * 2);
+
+    VkQueryPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = m_max_scopes * 2,
+        .pipelineStatistics = 0,
+    };
+    m_slots.resize(std::max(slots, 1u));
+    for (auto &slot : m_slots) {
+        if (VK_SUCCESS !=
+            vkCreateQueryPool(*m_device, &info, nullptr, &slot.pool)) {
+            spdlog::error("failed to create timestamp query pool");
+            destroy();
+            return false;
+        }
+        // queries start unavailable, begin() resets them in cmd otherwise
+        if (m_host_reset) {
+            vkResetQueryPool(*m_device, slot.pool, 0, info.queryCount);
+        }
+    }
+    m_enabled = true;
+    return true;
+}
+
+uint32_t Profiler::series(std::string_view name) {
+    auto it = m_names.find(std::string(name));
+    if (it != m_names.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(m_series.size());
+    m_series.push_back({.name = std::string(name)});
+    m_series.back().samples.reserve(m_window);
+    m_names.emplace(name, id);
+    return id;
+}
+
+void Profiler::collect(Slot &slot) {
+    if (slot.scopes.empty()) {
+        return;
+    }
+    uint32_t count = static_cast<uint32_t>(slot.scopes.size()) * 2;
+    // the slot is done, only a scope left open makes it not ready
+    VkResult ret = vkGetQueryPoolResults(
+        *m_device, slot.pool, 0, count, count * sizeof(uint64_t),
+        m_results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (ret != VK_SUCCESS) {
+        slot.scopes.clear();
+        return;
+    }
+    for (uint32_t i = 0; i < slot.scopes.size(); ++i) {
+        uint64_t ticks = (m_results[2 * i + 1] - m_results[2 * i]) & m_mask;
+        double ms = static_cast<double>(ticks) * m_period / 1e6;
+        Series &series = m_series[slot.scopes[i]];
+        series.last = ms;
+        if (series.samples.size() < m_window) {
+            series.samples.push_back(ms);
+        } else {
+            series.samples[series.head] = ms;
+            series.head = (series.head + 1) % m_window;
+        }
+    }
+    slot.scopes.clear();
+}
+
+void Profiler::begin(VkCommandBuffer cmd, uint32_t slot) {
+    if (!m_enabled) {
+        return;
+    }
+    m_slot = slot % m_slots.size();
+    Slot &current = m_slots[m_slot];
+    collect(current);
+    if (m_host_reset) {
+        vkResetQueryPool(*m_device, current.pool, 0, m_max_scopes * 2);
+    } else {
+        vkCmdResetQueryPool(cmd, current.pool, 0, m_max_scopes * 2);
+    }
+    m_recording = true;
+}
+
+uint32_t Profiler::push(VkCommandBuffer cmd, std::string_view name) {
+    if (!m_recording) {
+        return invalid_scope;
+    }
+    Slot &slot = m_slots[m_slot];
+    if (slot.scopes.size() == m_max_scopes) {
+        return invalid_scope;
+    }
+    uint32_t scope = static_cast<uint32_t>(slot.scopes.size());
+    slot.scopes.push_back(series(name));
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, slot.pool,
+                         scope * 2);
+    return scope;
+}
+
+void Profiler::pop(VkCommandBuffer cmd, uint32_t scope) {
+    if (!m_recording || scope == invalid_scope) {
+        return;
+    }
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                         m_slots[m_slot].pool, scope * 2 + 1);
+}
+
+std::vector<Stats> Profiler::stats() const {
+    std::vector<Stats> ret;
+    ret.reserve(m_series.size());
+    for (const auto &series : m_series) {
+        Stats stats{.name = series.name, .last = series.last};
+        stats.samples = static_cast<uint32_t>(series.samples.size());
+        if (stats.samples > 0) {
+            auto [min, max] = std::minmax_element(series.samples.begin(),
+                                                  series.samples.end());
+            stats.min = *min;
+            stats.max = *max;
+            for (double sample : series.samples) {
+                stats.avg += sample;
+            }
+            stats.avg /= stats.samples;
+        }
+        ret.push_back(stats);
+    }
+    return ret;
+}
+
+void Profiler::report(std::string_view title) const {
+    if (!m_enabled || m_series.empty()) {
+        return;
+    }
+    spdlog::info("{} gpu time over the last {} samples", title, m_window);
+    for (const auto &stats : stats()) {
+        spdlog::info("  {:<16} min {:>7.3f} ms avg {:>7.3f} ms max {:>7.3f} "
+                     "ms",
+                     stats.name, stats.min, stats.avg, stats.max);
+    }
+}
+
+} // namespace vbr::profile
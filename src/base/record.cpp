@@ -0,0 +1,167 @@
+#include "../../inc/record.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <atomic>
+#include <latch>
+
+namespace vbr::record {
+
+Recorder::Recorder(VkDevice &device, vbr::worker::Pool &workers,
+                   uint32_t family)
+    : m_device(device), m_workers(workers), m_family(family) {}
+
+Recorder::~Recorder() { destroy(); }
+
+void Recorder::destroy() {
+    for (auto &frame : m_frames) {
+        for (auto &slot : frame) {
+            // frees its command buffers too
+            if (slot.pool != VK_NULL_HANDLE) {
+                vkDestroyCommandPool(m_device, slot.pool, nullptr);
+                slot.pool = VK_NULL_HANDLE;
+            }
+        }
+    }
+    m_frames.clear();
+}
+
+bool Recorder::init(uint32_t frames) {
+    destroy();
+    VkCommandPoolCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = m_family,
+    };
+    m_frames.resize(std::max(frames, 1u));
+    for (auto &frame : m_frames) {
+        frame.resize(slots());
+        for (auto &slot : frame) {
+            if (VK_SUCCESS !=
+                vkCreateCommandPool(m_device, &info, nullptr, &slot.pool)) {
+                spdlog::error("failed to create recorder command pool");
+                return false;
+            }
+        }
+    }
+    m_frame = 0;
+    m_recorded = 0;
+    return true;
+}
+
+void Recorder::begin(uint32_t frame) {
+    m_frame = frame % m_frames.size();
+    m_recorded = 0;
+    for (auto &slot : m_frames[m_frame]) {
+        if (slot.used > 0) {
+            vkResetCommandPool(m_device, slot.pool, 0);
+            slot.used = 0;
+        }
+    }
+}
+
+VkCommandBuffer Recorder::acquire(Slot &slot) {
+    if (slot.used < slot.cmds.size()) {
+        return slot.cmds[slot.used++];
+    }
+    VkCommandBufferAllocateInfo info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .commandPool = slot.pool,
+        .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+        .commandBufferCount = 1,
+    };
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkAllocateCommandBuffers(m_device, &info, &cmd)) {
+        spdlog::error("failed to allocate secondary command buffer");
+        return VK_NULL_HANDLE;
+    }
+    slot.cmds.push_back(cmd);
+    slot.used++;
+    return cmd;
+}
+
+bool Recorder::record(VkCommandBuffer primary, const Inheritance &inheritance,
+                      uint32_t count, const Job &job, uint32_t min_chunk) {
+    if (count == 0 || m_frames.empty()) {
+        return count == 0;
+    }
+    auto &frame = m_frames[m_frame];
+    min_chunk = std::max(min_chunk, 1u);
+    uint32_t chunks = std::min(static_cast<uint32_t>(frame.size()),
+                               (count + min_chunk - 1) / min_chunk);
+
+    // handed out here, workers only record into them
+    std::vector<VkCommandBuffer> cmds(chunks);
+    for (uint32_t i = 0; i < chunks; ++i) {
+        cmds[i] = acquire(frame[i]);
+        if (cmds[i] == VK_NULL_HANDLE) {
+            return false;
+        }
+    }
+
+    VkCommandBufferInheritanceRenderingInfo rendering{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .viewMask = 0,
+        .colorAttachmentCount =
+            static_cast<uint32_t>(inheritance.color_formats.size()),
+        .pColorAttachmentFormats = inheritance.color_formats.data(),
+        .depthAttachmentFormat = inheritance.depth_format,
+        .stencilAttachmentFormat = inheritance.stencil_format,
+        .rasterizationSamples = inheritance.samples,
+    };
+    VkCommandBufferInheritanceInfo inherit{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = &rendering,
+        .renderPass = VK_NULL_HANDLE,
+        .subpass = 0,
+        .framebuffer = VK_NULL_HANDLE,
+        .occlusionQueryEnable = VK_FALSE,
+        .queryFlags = 0,
+        .pipelineStatistics = 0,
+    };
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                 VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inherit,
+    };
+
+    std::atomic<bool> ok = true;
+    auto run = [&](uint32_t i) {
+        uint32_t first = static_cast<uint32_t>(uint64_t(count) * i / chunks);
+        uint32_t last =
+            static_cast<uint32_t>(uint64_t(count) * (i + 1) / chunks);
+        if (VK_SUCCESS != vkBeginCommandBuffer(cmds[i], &begin_info)) {
+            ok = false;
+            return;
+        }
+        job(cmds[i], first, last);
+        if (VK_SUCCESS != vkEndCommandBuffer(cmds[i])) {
+            ok = false;
+        }
+    };
+    // chunks queue behind other jobs such as pipeline builds
+    std::latch done(chunks - 1);
+    for (uint32_t i = 1; i < chunks; ++i) {
+        m_workers.submit([&run, &done, i] {
+            run(i);
+            done.count_down();
+        });
+    }
+    run(0);
+    done.wait();
+    if (!ok) {
+        spdlog::error("failed to record secondary command buffers");
+        return false;
+    }
+    vkCmdExecuteCommands(primary, chunks, cmds.data());
+    m_recorded += chunks;
+    return true;
+}
+
+} // namespace vbr::record
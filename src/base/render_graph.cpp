@@ -0,0 +1,768 @@
+#include "../../inc/render_graph.hpp"
+#include "../../inc/device.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace vbr::graph {
+
+// what an access means for the barriers and the transient image usage
+struct Usage {
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 access;
+    VkImageLayout layout;
+    VkImageUsageFlags image_usage;
+    bool write;
+};
+
+constexpr VkPipelineStageFlags2 shader_stages =
+    VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+constexpr VkPipelineStageFlags2 depth_stages =
+    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+    VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+static Usage usage(Access access) {
+    switch (access) {
+    case Access::color_attachment:
+        return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true};
+    case Access::depth_attachment:
+        return {depth_stages,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true};
+    case Access::depth_read:
+        return {depth_stages | shader_stages,
+                VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                    VK_IMAGE_USAGE_SAMPLED_BIT,
+                false};
+    case Access::sampled:
+        return {shader_stages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_IMAGE_USAGE_SAMPLED_BIT, false};
+    case Access::storage_read:
+        return {shader_stages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false};
+    case Access::storage_write:
+        return {shader_stages,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true};
+    case Access::transfer_src:
+        return {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false};
+    case Access::transfer_dst:
+        return {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT, true};
+    case Access::vertex:
+        return {VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0, false};
+    case Access::index:
+        return {VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT,
+                VK_ACCESS_2_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0,
+                false};
+    case Access::indirect:
+        return {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT,
+                VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0, false};
+    case Access::uniform:
+        return {shader_stages, VK_ACCESS_2_UNIFORM_READ_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, 0, false};
+    }
+    return {};
+}
+
+static VkImageAspectFlags aspectOf(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+Pass &Pass::use(ImageHandle image, Access access) {
+    m_uses.push_back({image.id, true, access, true});
+    return *this;
+}
+
+Pass &Pass::use(BufferHandle buffer, Access access) {
+    m_uses.push_back({buffer.id, false, access, true});
+    return *this;
+}
+
+Pass &Pass::color(ImageHandle image, VkAttachmentLoadOp load,
+                  VkClearValue clear) {
+    m_uses.push_back({image.id, true, Access::color_attachment,
+                      load == VK_ATTACHMENT_LOAD_OP_LOAD});
+    m_colors.push_back({image, load, clear});
+    return *this;
+}
+
+Pass &Pass::depth(ImageHandle image, VkAttachmentLoadOp load,
+                  VkClearValue clear) {
+    m_uses.push_back({image.id, true, Access::depth_attachment,
+                      load == VK_ATTACHMENT_LOAD_OP_LOAD});
+    m_depth = Attachment{image, load, clear};
+    return *this;
+}
+
+Graph::Graph(vbr::device::Device &device) : m_device(device) {}
+
+Graph::~Graph() { reset(); }
+
+ImageHandle Graph::createImage(std::string_view name, const ImageDesc &desc) {
+    m_images.push_back({
+        .name = std::string(name),
+        .desc = desc,
+        .aspect = aspectOf(desc.format),
+        .imported = false,
+        .initial = {},
+    });
+    m_compiled = false;
+    return {static_cast<uint32_t>(m_images.size() - 1)};
+}
+
+ImageHandle Graph::importImage(std::string_view name, const ImageDesc &desc,
+                               VkImage image, VkImageView view,
+                               const ImageState &initial,
+                               std::optional<ImageState> final_state) {
+    m_images.push_back({
+        .name = std::string(name),
+        .desc = desc,
+        .aspect = aspectOf(desc.format),
+        .imported = true,
+        .image = image,
+        .view = view,
+        .initial = initial,
+        .final_state = final_state,
+    });
+    m_compiled = false;
+    return {static_cast<uint32_t>(m_images.size() - 1)};
+}
+
+BufferHandle Graph::importBuffer(std::string_view name, VkBuffer buffer,
+                                 const ImageState &initial) {
+    m_buffers.push_back({std::string(name), buffer, initial});
+    m_compiled = false;
+    return {static_cast<uint32_t>(m_buffers.size() - 1)};
+}
+
+void Graph::bindImage(ImageHandle handle, VkImage image, VkImageView view) {
+    if (handle.id >= m_images.size() || !m_images[handle.id].imported) {
+        spdlog::error("render graph can only rebind imported images");
+        return;
+    }
+    m_images[handle.id].image = image;
+    m_images[handle.id].view = view;
+}
+
+void Graph::bindBuffer(BufferHandle handle, VkBuffer buffer) {
+    if (handle.id >= m_buffers.size()) {
+        spdlog::error("render graph has no buffer {}", handle.id);
+        return;
+    }
+    m_buffers[handle.id].buffer = buffer;
+}
+
+Pass &Graph::addPass(std::string_view name) {
+    m_compiled = false;
+    return m_passes.emplace_back(name);
+}
+
+// walk passes backwards, a pass lives when it has side effects or writes
+// something imported or read by a later live pass
+void Graph::cull() {
+    std::vector<bool> needed_images(m_images.size(), false);
+    std::vector<bool> needed_buffers(m_buffers.size(), false);
+    std::vector<bool> live(m_passes.size(), false);
+    for (size_t i = m_passes.size(); i-- > 0;) {
+        const Pass &pass = m_passes[i];
+        bool is_live = pass.m_side_effect;
+        for (const auto &use : pass.m_uses) {
+            if (!usage(use.access).write) {
+                continue;
+            }
+            // buffers are always imported
+            if (!use.image || m_images[use.id].imported ||
+                needed_images[use.id]) {
+                is_live = true;
+            }
+        }
+        if (!is_live) {
+            spdlog::info("render graph culled pass {}", pass.m_name);
+            m_stats.culled++;
+            continue;
+        }
+        live[i] = true;
+        // a full overwrite ends the need for older contents
+        for (const auto &use : pass.m_uses) {
+            if (use.image && usage(use.access).write && !use.keep) {
+                needed_images[use.id] = false;
+            }
+        }
+        for (const auto &use : pass.m_uses) {
+            if (!usage(use.access).write || use.keep) {
+                if (use.image) {
+                    needed_images[use.id] = true;
+                } else {
+                    needed_buffers[use.id] = true;
+                }
+            }
+        }
+    }
+    for (uint32_t i = 0; i < m_passes.size(); ++i) {
+        if (live[i]) {
+            m_schedule.push_back(i);
+        }
+    }
+}
+
+// transient images with disjoint lifetimes share one block of memory
+bool Graph::allocateTransients() {
+    VkDevice &device = *m_device;
+    for (auto &image : m_images) {
+        image.first = UINT32_MAX;
+        image.last = 0;
+        image.usage = 0;
+        image.block = UINT32_MAX;
+    }
+    for (uint32_t p = 0; p < m_schedule.size(); ++p) {
+        for (const auto &use : m_passes[m_schedule[p]].m_uses) {
+            if (!use.image || m_images[use.id].imported) {
+                continue;
+            }
+            Image &image = m_images[use.id];
+            image.first = std::min(image.first, p);
+            image.last = std::max(image.last, p);
+            image.usage |= usage(use.access).image_usage;
+        }
+    }
+
+    std::vector<uint32_t> order;
+    for (uint32_t id = 0; id < m_images.size(); ++id) {
+        Image &image = m_images[id];
+        if (image.imported || image.first == UINT32_MAX) {
+            continue;
+        }
+        VkImageCreateInfo info{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .imageType = VK_IMAGE_TYPE_2D,
+            .format = image.desc.format,
+            .extent =
+                {
+                    .width = image.desc.extent.width,
+                    .height = image.desc.extent.height,
+                    .depth = 1,
+                },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = image.desc.samples,
+            .tiling = VK_IMAGE_TILING_OPTIMAL,
+            .usage = image.usage,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+            .queueFamilyIndexCount = 0,
+            .pQueueFamilyIndices = nullptr,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+        if (VK_SUCCESS != vkCreateImage(device, &info, nullptr, &image.image)) {
+            spdlog::error("failed to create render graph image {}",
+                          image.name);
+            return false;
+        }
+        order.push_back(id);
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return m_images[a].first < m_images[b].first;
+    });
+
+    for (uint32_t id : order) {
+        Image &image = m_images[id];
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(device, image.image, &requirements);
+        m_stats.unaliased_memory += requirements.size;
+        // best fit among blocks whose last image is already dead
+        uint32_t best = UINT32_MAX;
+        VkDeviceSize best_growth = 0;
+        for (uint32_t b = 0; b < m_blocks.size(); ++b) {
+            const Block &block = m_blocks[b];
+            if (m_images[block.last_image].last >= image.first ||
+                !(block.requirements.memoryTypeBits &
+                  requirements.memoryTypeBits)) {
+                continue;
+            }
+            VkDeviceSize growth =
+                std::max(block.requirements.size, requirements.size) -
+                block.requirements.size;
+            if (best == UINT32_MAX || growth < best_growth) {
+                best = b;
+                best_growth = growth;
+            }
+        }
+        if (best == UINT32_MAX) {
+            m_blocks.push_back({.requirements = requirements,
+                                .allocation = {},
+                                .last_image = id});
+            image.block = static_cast<uint32_t>(m_blocks.size() - 1);
+            continue;
+        }
+        Block &block = m_blocks[best];
+        block.requirements.size =
+            std::max(block.requirements.size, requirements.size);
+        block.requirements.alignment =
+            std::max(block.requirements.alignment, requirements.alignment);
+        block.requirements.memoryTypeBits &= requirements.memoryTypeBits;
+        block.last_image = id;
+        image.block = best;
+    }
+
+    for (auto &block : m_blocks) {
+        if (!m_device.allocateMemory(block.requirements,
+                                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                     false, block.allocation)) {
+            spdlog::error("failed to allocate render graph memory");
+            return false;
+        }
+        m_stats.memory += block.requirements.size;
+    }
+
+    for (uint32_t id : order) {
+        Image &image = m_images[id];
+        Block &block = m_blocks[image.block];
+        if (VK_SUCCESS != vkBindImageMemory(device, image.image,
+                                            block.allocation.memory,
+                                            block.allocation.offset)) {
+            spdlog::error("failed to bind render graph image {}", image.name);
+            return false;
+        }
+        VkImageViewCreateInfo info{
+            .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .pNext = nullptr,
+            .flags = 0,
+            .image = image.image,
+            .viewType = VK_IMAGE_VIEW_TYPE_2D,
+            .format = image.desc.format,
+            .components =
+                {
+                    .r = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+                    .a = VK_COMPONENT_SWIZZLE_IDENTITY,
+                },
+            .subresourceRange =
+                {
+                    .aspectMask = image.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = 1,
+                    .baseArrayLayer = 0,
+                    .layerCount = 1,
+                },
+        };
+        if (VK_SUCCESS !=
+            vkCreateImageView(device, &info, nullptr, &image.view)) {
+            spdlog::error("failed to create render graph view {}",
+                          image.name);
+            return false;
+        }
+    }
+
+    for (uint32_t p = 0; p < m_schedule.size(); ++p) {
+        for (const auto &use : m_passes[m_schedule[p]].m_uses) {
+            if (!use.image || m_images[use.id].imported) {
+                continue;
+            }
+            Usage u = usage(use.access);
+            Block &block = m_blocks[m_images[use.id].block];
+            block.stages |= u.stages;
+            if (u.write) {
+                block.access |= u.access;
+            }
+        }
+    }
+    m_stats.transient_images = static_cast<uint32_t>(order.size());
+    m_stats.memory_blocks = static_cast<uint32_t>(m_blocks.size());
+    return true;
+}
+
+void Graph::destroyTransients() {
+    VkDevice &device = *m_device;
+    for (auto &image : m_images) {
+        if (image.imported) {
+            continue;
+        }
+        if (image.view != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, image.view, nullptr);
+            image.view = VK_NULL_HANDLE;
+        }
+        if (image.image != VK_NULL_HANDLE) {
+            vkDestroyImage(device, image.image, nullptr);
+            image.image = VK_NULL_HANDLE;
+        }
+    }
+    for (auto &block : m_blocks) {
+        m_device.freeMemory(block.allocation);
+    }
+    m_blocks.clear();
+}
+
+void Graph::barrier(Batch &batch, State &state, uint32_t id, bool image,
+                    VkPipelineStageFlags2 stages, VkAccessFlags2 access,
+                    VkImageLayout layout, bool write) {
+    bool transition = image && state.layout != layout;
+    VkPipelineStageFlags2 src_stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 src_access = VK_ACCESS_2_NONE;
+    bool needed = false;
+    if (transition || write) {
+        // wait on the last write and, before overwriting, on its readers
+        src_stages = state.write_stages | state.read_stages;
+        src_access = state.write_access;
+        needed = transition || src_stages != VK_PIPELINE_STAGE_2_NONE;
+    } else if ((stages & ~state.synced_stages) &&
+               state.write_stages != VK_PIPELINE_STAGE_2_NONE) {
+        // read in stages that have not waited on the last write yet
+        src_stages = state.write_stages;
+        src_access = state.write_access;
+        needed = true;
+    }
+
+    if (needed && image) {
+        batch.images.push_back({
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = src_stages,
+            .srcAccessMask = src_access,
+            .dstStageMask = stages,
+            .dstAccessMask = access,
+            .oldLayout = state.layout,
+            .newLayout = layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = VK_NULL_HANDLE,
+            .subresourceRange =
+                {
+                    .aspectMask = m_images[id].aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .baseArrayLayer = 0,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                },
+        });
+        batch.image_ids.push_back(id);
+    } else if (needed) {
+        batch.buffers.push_back({
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = src_stages,
+            .srcAccessMask = src_access,
+            .dstStageMask = stages,
+            .dstAccessMask = access,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = VK_NULL_HANDLE,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+        });
+        batch.buffer_ids.push_back(id);
+    }
+
+    if (write) {
+        state = {layout, stages, access, stages, VK_PIPELINE_STAGE_2_NONE};
+    } else if (transition) {
+        // the transition is a write, only the stages waiting on it see it
+        state = {layout, stages, VK_ACCESS_2_NONE, stages, stages};
+    } else {
+        if (needed) {
+            state.synced_stages |= stages;
+        }
+        state.read_stages |= stages;
+    }
+}
+
+bool Graph::buildBarriers() {
+    std::vector<State> images(m_images.size());
+    std::vector<State> buffers(m_buffers.size());
+    for (uint32_t id = 0; id < m_images.size(); ++id) {
+        const Image &image = m_images[id];
+        if (image.imported) {
+            images[id] = {image.initial.layout, image.initial.stages,
+                          image.initial.access, VK_PIPELINE_STAGE_2_NONE,
+                          VK_PIPELINE_STAGE_2_NONE};
+        } else if (image.block != UINT32_MAX) {
+            // contents are dropped, wait on whoever used the memory before
+            const Block &block = m_blocks[image.block];
+            images[id] = {VK_IMAGE_LAYOUT_UNDEFINED, block.stages,
+                          block.access, VK_PIPELINE_STAGE_2_NONE,
+                          VK_PIPELINE_STAGE_2_NONE};
+        }
+    }
+    for (uint32_t id = 0; id < m_buffers.size(); ++id) {
+        const Buffer &buffer = m_buffers[id];
+        buffers[id] = {VK_IMAGE_LAYOUT_UNDEFINED, buffer.initial.stages,
+                       buffer.initial.access, VK_PIPELINE_STAGE_2_NONE,
+                       VK_PIPELINE_STAGE_2_NONE};
+    }
+
+    // every use of one resource in a pass turns into one barrier
+    struct Merged {
+        uint32_t id;
+        bool image;
+        Usage usage;
+    };
+    std::vector<Merged> merged;
+    m_batches.resize(m_schedule.size());
+    for (uint32_t p = 0; p < m_schedule.size(); ++p) {
+        const Pass &pass = m_passes[m_schedule[p]];
+        merged.clear();
+        for (const auto &use : pass.m_uses) {
+            Usage u = usage(use.access);
+            auto it = std::ranges::find_if(merged, [&use](const Merged &m) {
+                return m.id == use.id && m.image == use.image;
+            });
+            if (it == merged.end()) {
+                merged.push_back({use.id, use.image, u});
+                continue;
+            }
+            if (use.image && it->usage.layout != u.layout) {
+                spdlog::error("pass {} uses image {} in two layouts",
+                              pass.m_name, m_images[use.id].name);
+                return false;
+            }
+            it->usage.stages |= u.stages;
+            it->usage.access |= u.access;
+            it->usage.write = it->usage.write || u.write;
+        }
+        for (const auto &m : merged) {
+            State &state = m.image ? images[m.id] : buffers[m.id];
+            barrier(m_batches[p], state, m.id, m.image, m.usage.stages,
+                    m.usage.access, m.usage.layout, m.usage.write);
+        }
+    }
+
+    // hand imported images back in the layout the caller asked for
+    for (uint32_t id = 0; id < m_images.size(); ++id) {
+        const Image &image = m_images[id];
+        const State &state = images[id];
+        if (!image.imported || !image.final_state.has_value()) {
+            continue;
+        }
+        const ImageState &final_state = image.final_state.value();
+        if (state.layout == final_state.layout &&
+            state.write_access == VK_ACCESS_2_NONE) {
+            continue;
+        }
+        m_final.images.push_back({
+            .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = state.write_stages | state.read_stages,
+            .srcAccessMask = state.write_access,
+            .dstStageMask = final_state.stages,
+            .dstAccessMask = final_state.access,
+            .oldLayout = state.layout,
+            .newLayout = final_state.layout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image = VK_NULL_HANDLE,
+            .subresourceRange =
+                {
+                    .aspectMask = image.aspect,
+                    .baseMipLevel = 0,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .baseArrayLayer = 0,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS,
+                },
+        });
+        m_final.image_ids.push_back(id);
+    }
+
+    for (const auto &batch : m_batches) {
+        if (!batch.empty()) {
+            m_stats.batches++;
+        }
+        m_stats.barriers += batch.images.size() + batch.buffers.size();
+    }
+    if (!m_final.empty()) {
+        m_stats.batches++;
+    }
+    m_stats.barriers += m_final.images.size();
+    return true;
+}
+
+bool Graph::compile() {
+    m_device.waitIdle();
+    destroyTransients();
+    m_schedule.clear();
+    m_batches.clear();
+    m_final = {};
+    m_stats = {};
+    m_compiled = false;
+    m_stats.passes = static_cast<uint32_t>(m_passes.size());
+
+    for (const auto &pass : m_passes) {
+        for (const auto &use : pass.m_uses) {
+            if (use.id >= (use.image ? m_images.size() : m_buffers.size())) {
+                spdlog::error("pass {} uses an unknown resource", pass.m_name);
+                return false;
+            }
+        }
+    }
+    cull();
+    if (!allocateTransients() || !buildBarriers()) {
+        destroyTransients();
+        return false;
+    }
+    spdlog::info("render graph {} passes, {} culled, {} barriers in {} "
+                 "batches, {} transient images in {} blocks, {} of {} bytes",
+                 m_stats.passes, m_stats.culled, m_stats.barriers,
+                 m_stats.batches, m_stats.transient_images,
+                 m_stats.memory_blocks, m_stats.memory,
+                 m_stats.unaliased_memory);
+    m_compiled = true;
+    return true;
+}
+
+// barriers are recorded with resource ids, handles are patched in here so
+// imported images can change every frame
+void Graph::emit(VkCommandBuffer cmd, Batch &batch) {
+    if (batch.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < batch.images.size(); ++i) {
+        batch.images[i].image = m_images[batch.image_ids[i]].image;
+    }
+    for (size_t i = 0; i < batch.buffers.size(); ++i) {
+        batch.buffers[i].buffer = m_buffers[batch.buffer_ids[i]].buffer;
+    }
+    VkDependencyInfo info{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+        .dependencyFlags = 0,
+        .memoryBarrierCount = 0,
+        .pMemoryBarriers = nullptr,
+        .bufferMemoryBarrierCount = static_cast<uint32_t>(batch.buffers.size()),
+        .pBufferMemoryBarriers = batch.buffers.data(),
+        .imageMemoryBarrierCount = static_cast<uint32_t>(batch.images.size()),
+        .pImageMemoryBarriers = batch.images.data(),
+    };
+    vkCmdPipelineBarrier2(cmd, &info);
+}
+
+void Graph::beginRendering(VkCommandBuffer cmd, const Pass &pass) {
+    std::vector<VkRenderingAttachmentInfo> colors;
+    VkExtent2D extent{0, 0};
+    for (const auto &attachment : pass.m_colors) {
+        const Image &image = m_images[attachment.image.id];
+        extent = image.desc.extent;
+        colors.push_back({
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .pNext = nullptr,
+            .imageView = image.view,
+            .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = attachment.load,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = attachment.clear,
+        });
+    }
+    VkRenderingAttachmentInfo depth{};
+    bool stencil = false;
+    if (pass.m_depth.has_value()) {
+        const Image &image = m_images[pass.m_depth->image.id];
+        extent = image.desc.extent;
+        stencil = image.aspect & VK_IMAGE_ASPECT_STENCIL_BIT;
+        depth = {
+            .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+            .pNext = nullptr,
+            .imageView = image.view,
+            .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .resolveMode = VK_RESOLVE_MODE_NONE,
+            .resolveImageView = VK_NULL_HANDLE,
+            .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .loadOp = pass.m_depth->load,
+            .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+            .clearValue = pass.m_depth->clear,
+        };
+    }
+    VkRenderingInfo info{
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .renderArea =
+            {
+                .offset = {0, 0},
+                .extent = extent,
+            },
+        .layerCount = 1,
+        .viewMask = 0,
+        .colorAttachmentCount = static_cast<uint32_t>(colors.size()),
+        .pColorAttachments = colors.data(),
+        .pDepthAttachment = pass.m_depth.has_value() ? &depth : nullptr,
+        .pStencilAttachment = stencil ? &depth : nullptr,
+    };
+    vkCmdBeginRendering(cmd, &info);
+}
+
+void Graph::execute(VkCommandBuffer cmd) {
+    if (!m_compiled) {
+        spdlog::warn("render graph executed before compile");
+        return;
+    }
+    for (uint32_t p = 0; p < m_schedule.size(); ++p) {
+        const Pass &pass = m_passes[m_schedule[p]];
+        emit(cmd, m_batches[p]);
+        // timed without the barriers before it
+        vbr::profile::Scope scope(m_device.profiler(), cmd, pass.m_name);
+        bool rendering = !pass.m_colors.empty() || pass.m_depth.has_value();
+        if (rendering) {
+            beginRendering(cmd, pass);
+        }
+        if (pass.m_record) {
+            pass.m_record(cmd);
+        }
+        if (rendering) {
+            vkCmdEndRendering(cmd);
+        }
+    }
+    emit(cmd, m_final);
+}
+
+void Graph::reset() {
+    m_device.waitIdle();
+    destroyTransients();
+    m_images.clear();
+    m_buffers.clear();
+    m_passes.clear();
+    m_schedule.clear();
+    m_batches.clear();
+    m_final = {};
+    m_stats = {};
+    m_compiled = false;
+}
+
+} // namespace vbr::graph
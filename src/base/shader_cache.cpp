@@ -0,0 +1,160 @@
+#include "../../inc/shader_cache.hpp"
+#include "../../inc/util.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace vbr::shader {
+
+// first word of every spir-v module in host byte order
+constexpr uint32_t spirv_magic = 0x07230203;
+// magic, version, generator, bound and schema
+constexpr size_t spirv_header_words = 5;
+
+ShaderCache::ShaderCache(VkDevice &device) : m_device(device) {}
+
+ShaderCache::~ShaderCache() {
+    if (!m_modules.empty()) {
+        spdlog::warn("{} shader modules still referenced", m_modules.size());
+    }
+    for (auto &[hash, entry] : m_modules) {
+        if (m_device != VK_NULL_HANDLE) {
+            vkDestroyShaderModule(m_device, entry.module, nullptr);
+        }
+    }
+    spdlog::info("shader cache: {} modules loaded, {} reused", m_loads, m_hits);
+}
+
+bool ShaderCache::read(std::string_view path, std::vector<uint32_t> &code) {
+    std::string file(path);
+    size_t size = 0;
+    void *data = SDL_LoadFile(file.c_str(), &size);
+    if (data == nullptr) {
+        spdlog::error("failed to load shader {}: {}", path, SDL_GetError());
+        return false;
+    }
+    if (size % sizeof(uint32_t) != 0 ||
+        size < spirv_header_words * sizeof(uint32_t)) {
+        spdlog::error("shader {} has invalid size {}", path, size);
+        SDL_free(data);
+        return false;
+    }
+    // SDL_LoadFile memory has no alignment promise for uint32_t words
+    code.resize(size / sizeof(uint32_t));
+    memcpy(code.data(), data, size);
+    SDL_free(data);
+    if (code[0] != spirv_magic) {
+        spdlog::error("shader {} is not spir-v", path);
+        return false;
+    }
+    return true;
+}
+
+VkShaderModule ShaderCache::reuse(uint64_t hash,
+                                  const std::vector<uint32_t> *code) {
+    auto [first, last] = m_modules.equal_range(hash);
+    if (code == nullptr && (first == last || std::next(first) != last)) {
+        return VK_NULL_HANDLE;
+    }
+    for (auto it = first; it != last; ++it) {
+        if (code == nullptr || it->second.code == *code) {
+            it->second.refs++;
+            m_hits++;
+            return it->second.module;
+        }
+    }
+    return VK_NULL_HANDLE;
+}
+
+VkShaderModule ShaderCache::acquire(std::string_view path) {
+    std::string key(path);
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_paths.find(key);
+        if (it != m_paths.end()) {
+            VkShaderModule module = reuse(it->second, nullptr);
+            if (module != VK_NULL_HANDLE) {
+                return module;
+            }
+        }
+    }
+
+    // file io and driver parsing stay outside the lock
+    std::vector<uint32_t> code;
+    if (!read(path, code)) {
+        return VK_NULL_HANDLE;
+    }
+    uint64_t hash =
+        vbr::util::hash(code.data(), code.size() * sizeof(uint32_t));
+    {
+        std::lock_guard lock(m_mutex);
+        // another path with the same content
+        VkShaderModule module = reuse(hash, &code);
+        if (module != VK_NULL_HANDLE) {
+            m_paths[key] = hash;
+            return module;
+        }
+    }
+
+    VkShaderModuleCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .codeSize = code.size() * sizeof(uint32_t),
+        .pCode = code.data(),
+    };
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (VK_SUCCESS !=
+        vkCreateShaderModule(m_device, &info, nullptr, &module)) {
+        spdlog::error("failed to create shader module {}", path);
+        return VK_NULL_HANDLE;
+    }
+
+    std::lock_guard lock(m_mutex);
+    // a concurrent build may have created the same module meanwhile
+    VkShaderModule existing = reuse(hash, &code);
+    m_paths[key] = hash;
+    if (existing != VK_NULL_HANDLE) {
+        vkDestroyShaderModule(m_device, module, nullptr);
+        return existing;
+    }
+    m_modules.emplace(hash, Module{
+                                .module = module,
+                                .refs = 1,
+                                .code = std::move(code),
+                            });
+    m_hashes[module] = hash;
+    m_loads++;
+    return module;
+}
+
+void ShaderCache::release(VkShaderModule module) {
+    if (module == VK_NULL_HANDLE) {
+        return;
+    }
+    std::lock_guard lock(m_mutex);
+    auto hash = m_hashes.find(module);
+    if (hash == m_hashes.end()) {
+        spdlog::warn("release unknown shader module");
+        return;
+    }
+    auto [first, last] = m_modules.equal_range(hash->second);
+    auto it = std::find_if(first, last, [module](const auto &entry) {
+        return entry.second.module == module;
+    });
+    if (--it->second.refs == 0) {
+        // paths of that hash could resolve to another module with it
+        std::erase_if(m_paths, [&](const auto &path) {
+            return path.second == hash->second;
+        });
+        vkDestroyShaderModule(m_device, module, nullptr);
+        m_modules.erase(it);
+        m_hashes.erase(hash);
+    }
+}
+
+} // namespace vbr::shader
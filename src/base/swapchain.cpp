@@ -12,13 +12,11 @@ Swapchain::~Swapchain() {
     }
 
     m_vk_device.waitIdle();
+    destroyRenderDone();
     if (m_color_image) {
         m_color_image.reset();
     }
-    if (m_color_memory != VK_NULL_HANDLE) {
-        vkFreeMemory(*m_vk_device, m_color_memory, nullptr);
-        m_color_memory = VK_NULL_HANDLE;
-    }
+    m_vk_device.freeMemory(m_color_allocation);
 
     if (m_vk_swapchain != VK_NULL_HANDLE) {
         vkDestroySwapchainKHR(*m_vk_device, m_vk_swapchain, nullptr);
@@ -26,6 +24,15 @@ Swapchain::~Swapchain() {
     }
 }
 
+void Swapchain::destroyRenderDone() {
+    for (auto &semaphore : m_vk_render_done) {
+        if (semaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(*m_vk_device, semaphore, nullptr);
+        }
+    }
+    m_vk_render_done.clear();
+}
+
 bool Swapchain::init(const glm::ivec2 &window_size) {
     vkDeviceWaitIdle(*m_vk_device);
 
@@ -71,9 +78,7 @@ bool Swapchain::init(const glm::ivec2 &window_size) {
         if (m_color_image) {
             m_color_image.reset();
         }
-        if (m_color_memory) {
-            vkFreeMemory(*m_vk_device, m_color_memory, nullptr);
-        }
+        m_vk_device.freeMemory(m_color_allocation);
         m_color_image = std::make_unique<vbr::image::Image>(*m_vk_device);
         m_vk_device.internalCreateSampleImage(
             extent.width, extent.height,
@@ -82,10 +87,17 @@ bool Swapchain::init(const glm::ivec2 &window_size) {
             VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT |
                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_color_image->image,
-            m_color_memory);
+            m_color_allocation);
         m_color_image->init(m_vk_device.m_vk_phy_info.surface_format.format);
     }
 
+    // blits into the target need transfer usage, e.g. from a render graph
+    m_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (m_vk_device.m_vk_phy_info.capabilities.supportedUsageFlags &
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT) {
+        m_usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+
     VkSwapchainCreateInfoKHR info{
         .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
         .pNext = nullptr,
@@ -96,7 +108,7 @@ bool Swapchain::init(const glm::ivec2 &window_size) {
         .imageColorSpace = m_vk_device.m_vk_phy_info.surface_format.colorSpace,
         .imageExtent = extent,
         .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage = m_usage,
         .imageSharingMode = sharing_mode,
         .queueFamilyIndexCount = static_cast<uint32_t>(indices.size()),
         .pQueueFamilyIndices = indices.data(),
@@ -143,12 +155,27 @@ bool Swapchain::init(const glm::ivec2 &window_size) {
         return false;
     }
 
+    destroyRenderDone();
+    VkSemaphoreCreateInfo sinfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+    };
+    m_vk_render_done.resize(m_vk_swapchain_images.size(), VK_NULL_HANDLE);
+    for (auto &semaphore : m_vk_render_done) {
+        if (VK_SUCCESS !=
+            vkCreateSemaphore(*m_vk_device, &sinfo, nullptr, &semaphore)) {
+            spdlog::error("failed to create semaphore for render done");
+            return false;
+        }
+    }
+
     return true;
 }
 
 VkResult Swapchain::acquireNext() {
     return vkAcquireNextImageKHR(*m_vk_device, m_vk_swapchain, UINT64_MAX,
-                                 m_vk_device.m_vk_sync.image_available,
+                                 m_vk_device.imageAvailable(),
                                  VK_NULL_HANDLE, &m_current_index);
 }
 
@@ -0,0 +1,49 @@
+#include "../../inc/uniform_ring.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+namespace vbr::uniform {
+
+Ring::Ring(std::unique_ptr<vbr::buffer::Buffer> buffer, VkDeviceSize size,
+           VkDeviceSize alignment, uint32_t frames)
+    : m_buffer(std::move(buffer)), m_size(size),
+      m_alignment(std::max<VkDeviceSize>(alignment, 1)),
+      m_frame_heads(std::max(frames, 1u), 0) {
+    m_data = static_cast<uint8_t *>(m_buffer->data);
+}
+
+void Ring::begin(uint32_t frame) {
+    m_frame_heads[m_frame] = m_head;
+    m_peak_bytes = std::max(m_peak_bytes, m_frame_bytes);
+    m_frame_bytes = 0;
+    m_frame = frame % m_frame_heads.size();
+    // frames finish in order, the slot's last head only moves forward
+    m_tail = std::max(m_tail, m_frame_heads[m_frame]);
+}
+
+void Ring::reset(uint32_t frames) {
+    m_tail = m_head;
+    m_frame_heads.assign(std::max(frames, 1u), m_head);
+    m_frame = 0;
+    m_frame_bytes = 0;
+}
+
+Slice Ring::allocate(VkDeviceSize size) {
+    uint64_t start = (m_head + m_alignment - 1) / m_alignment * m_alignment;
+    // slices never wrap, skip to the next lap instead
+    if (start % m_size + size > m_size) {
+        start = (start / m_size + 1) * m_size;
+    }
+    if (m_data == nullptr || size > m_size || start + size - m_tail > m_size) {
+        spdlog::error("uniform ring of {} bytes is full", m_size);
+        return {};
+    }
+    m_frame_bytes += start + size - m_head;
+    m_head = start + size;
+    return {
+        .data = m_data + start % m_size,
+        .offset = static_cast<uint32_t>(start % m_size),
+    };
+}
+
+} // namespace vbr::uniform
@@ -0,0 +1,326 @@
+#include "../../inc/upload.hpp"
+#include "../../inc/device.hpp"
+#include "../../inc/image.hpp"
+#include "../../inc/util.hpp"
+#include "spdlog/spdlog.h"
+#include "vulkan/vulkan_core.h"
+
+namespace vbr::upload {
+
+Uploader::Uploader(vbr::device::Device &device) : m_device(device) {}
+
+Uploader::~Uploader() {
+    if (*m_device == VK_NULL_HANDLE) {
+        return;
+    }
+    flush();
+    wait(m_submitted);
+    for (auto &cmd : m_free_cmds) {
+        vkFreeCommandBuffers(*m_device, m_cmd_pool, 1, &cmd);
+    }
+    m_free_cmds.clear();
+    if (m_cmd_pool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(*m_device, m_cmd_pool, nullptr);
+        m_cmd_pool = VK_NULL_HANDLE;
+    }
+    if (m_timeline != VK_NULL_HANDLE) {
+        vkDestroySemaphore(*m_device, m_timeline, nullptr);
+        m_timeline = VK_NULL_HANDLE;
+    }
+}
+
+bool Uploader::init(uint32_t family, VkQueue queue, uint32_t owner_family) {
+    m_queue = queue;
+    m_family = family;
+    m_owner_family = owner_family;
+    if (transferOwnership()) {
+        spdlog::info("upload on family {}, transfer ownership to {}", family,
+                     owner_family);
+    }
+    VkCommandPoolCreateInfo pinfo{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT |
+                 VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = family,
+    };
+    if (VK_SUCCESS !=
+        vkCreateCommandPool(*m_device, &pinfo, nullptr, &m_cmd_pool)) {
+        spdlog::error("failed to create upload command pool");
+        return false;
+    }
+
+    VkSemaphoreTypeCreateInfo tinfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext = nullptr,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    VkSemaphoreCreateInfo sinfo{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &tinfo,
+        .flags = 0,
+    };
+    if (VK_SUCCESS !=
+        vkCreateSemaphore(*m_device, &sinfo, nullptr, &m_timeline)) {
+        spdlog::error("failed to create upload timeline semaphore");
+        return false;
+    }
+    m_profiler = std::make_unique<vbr::profile::Profiler>(m_device);
+    return m_profiler->init(family, profile_slots, 1);
+}
+
+VkCommandBuffer Uploader::record() {
+    if (m_recording.cmd != VK_NULL_HANDLE) {
+        return m_recording.cmd;
+    }
+
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    if (!m_free_cmds.empty()) {
+        cmd = m_free_cmds.back();
+        m_free_cmds.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo info{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .pNext = nullptr,
+            .commandPool = m_cmd_pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        if (VK_SUCCESS != vkAllocateCommandBuffers(*m_device, &info, &cmd)) {
+            spdlog::error("failed to create upload command buffer");
+            return VK_NULL_HANDLE;
+        }
+    }
+
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .pNext = nullptr,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = nullptr,
+    };
+    if (VK_SUCCESS != vkBeginCommandBuffer(cmd, &begin_info)) {
+        spdlog::error("failed to begin upload command buffer");
+        m_free_cmds.push_back(cmd);
+        return VK_NULL_HANDLE;
+    }
+    m_recording.cmd = cmd;
+    m_recording.ticket = m_next;
+    // the slot is free once the batch that last used it is done, else
+    // this batch goes unmeasured rather than waiting
+    if (m_profiler->enabled() &&
+        (m_next <= profile_slots || done(m_next - profile_slots))) {
+        m_profiler->begin(cmd, static_cast<uint32_t>(m_next % profile_slots));
+        m_recording.scope = m_profiler->push(cmd, "upload");
+    }
+    return cmd;
+}
+
+void Uploader::release(Batch &batch) {
+    batch.releases.clear();
+    batch.acquires.clear();
+    // the batch is done, no need for the device wait in ~Buffer
+    for (auto &stage : batch.stages) {
+        stage->destroy();
+    }
+    batch.stages.clear();
+    if (batch.cmd != VK_NULL_HANDLE) {
+        m_free_cmds.push_back(batch.cmd);
+        batch.cmd = VK_NULL_HANDLE;
+    }
+}
+
+Ticket Uploader::copyBuffer(std::unique_ptr<vbr::buffer::Buffer> stage,
+                            vbr::buffer::Buffer &dst, VkDeviceSize size) {
+    VkCommandBuffer cmd = record();
+    if (cmd == VK_NULL_HANDLE) {
+        return m_submitted;
+    }
+    VkBufferCopy info{
+        .srcOffset = 0,
+        .dstOffset = 0,
+        .size = size,
+    };
+    vkCmdCopyBuffer(cmd, stage->buffer, dst.buffer, 1, &info);
+    m_recording.stages.push_back(std::move(stage));
+
+    if (transferOwnership()) {
+        VkBufferMemoryBarrier2 barrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext = nullptr,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+            .dstAccessMask = VK_ACCESS_2_NONE,
+            .srcQueueFamilyIndex = m_family,
+            .dstQueueFamilyIndex = m_owner_family,
+            .buffer = dst.buffer,
+            .offset = 0,
+            .size = VK_WHOLE_SIZE,
+        };
+        // release, the dst half is ignored on this queue
+        m_recording.releases.buffer(barrier);
+        // src stages match the wait stages of the upload timeline
+        barrier.srcStageMask = consume_stages;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+        barrier.dstStageMask = consume_stages;
+        barrier.dstAccessMask = consume_access;
+        m_recording.acquires.buffer(barrier);
+    }
+    return m_recording.ticket;
+}
+
+Ticket Uploader::copyTexture(std::unique_ptr<vbr::buffer::Buffer> stage,
+                             vbr::image::Texture &dst, glm::ivec2 size) {
+    VkCommandBuffer cmd = record();
+    if (cmd == VK_NULL_HANDLE) {
+        return m_submitted;
+    }
+    vbr::util::transitionImageLayout(cmd, dst.image, VK_IMAGE_LAYOUT_UNDEFINED,
+                                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    dst.copyFrom(cmd, stage->buffer, size);
+    m_recording.stages.push_back(std::move(stage));
+
+    if (!transferOwnership()) {
+        m_recording.releases.transition(
+            dst.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        return m_recording.ticket;
+    }
+
+    // a transfer only queue has no fragment stage, the layout change is
+    // part of the ownership transfer and finishes at the acquire
+    VkImageMemoryBarrier2 barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask = VK_PIPELINE_STAGE_2_NONE,
+        .dstAccessMask = VK_ACCESS_2_NONE,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = m_family,
+        .dstQueueFamilyIndex = m_owner_family,
+        .image = dst.image,
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+    m_recording.releases.image(barrier);
+    barrier.srcStageMask = consume_stages;
+    barrier.srcAccessMask = VK_ACCESS_2_NONE;
+    barrier.dstStageMask = consume_stages;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    m_recording.acquires.image(barrier);
+    return m_recording.ticket;
+}
+
+Ticket Uploader::flush() {
+    collect();
+    if (m_recording.cmd == VK_NULL_HANDLE) {
+        return m_submitted;
+    }
+
+    Batch batch = std::move(m_recording);
+    m_recording = Batch{};
+    m_next++;
+
+    batch.releases.flush(batch.cmd);
+    m_profiler->pop(batch.cmd, batch.scope);
+    if (VK_SUCCESS != vkEndCommandBuffer(batch.cmd)) {
+        spdlog::error("failed to end upload command buffer");
+        release(batch);
+        return m_submitted;
+    }
+
+    VkTimelineSemaphoreSubmitInfo tinfo{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = nullptr,
+        .waitSemaphoreValueCount = 0,
+        .pWaitSemaphoreValues = nullptr,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues = &batch.ticket,
+    };
+    VkSubmitInfo info{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext = &tinfo,
+        .waitSemaphoreCount = 0,
+        .pWaitSemaphores = nullptr,
+        .pWaitDstStageMask = nullptr,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &batch.cmd,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores = &m_timeline,
+    };
+    if (VK_SUCCESS != vkQueueSubmit(m_queue, 1, &info, VK_NULL_HANDLE)) {
+        spdlog::error("failed to submit upload batch");
+        release(batch);
+        return m_submitted;
+    }
+    m_submitted = batch.ticket;
+    m_acquires.append(batch.acquires);
+    m_pending.push_back(std::move(batch));
+    return m_submitted;
+}
+
+void Uploader::acquire(VkCommandBuffer &cmd) {
+    // src stages match the wait stages of the upload timeline, so the
+    // layout change is ordered after the semaphore wait
+    m_acquires.flush(cmd);
+}
+
+bool Uploader::done(Ticket ticket) {
+    if (ticket > m_submitted) {
+        return false;
+    }
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(*m_device, m_timeline, &value);
+    return value >= ticket;
+}
+
+void Uploader::wait(Ticket ticket) {
+    if (ticket == 0) {
+        return;
+    }
+    if (ticket > m_submitted) {
+        flush();
+    }
+    if (ticket > m_submitted) {
+        spdlog::warn("wait unknown upload {}", ticket);
+        return;
+    }
+    VkSemaphoreWaitInfo info{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .semaphoreCount = 1,
+        .pSemaphores = &m_timeline,
+        .pValues = &ticket,
+    };
+    if (VK_SUCCESS != vkWaitSemaphores(*m_device, &info, UINT64_MAX)) {
+        spdlog::warn("failed to wait upload {}", ticket);
+    }
+    collect();
+}
+
+void Uploader::collect() {
+    if (m_pending.empty()) {
+        return;
+    }
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(*m_device, m_timeline, &value);
+    std::erase_if(m_pending, [this, value](Batch &batch) {
+        if (batch.ticket > value) {
+            return false;
+        }
+        release(batch);
+        return true;
+    });
+}
+
+} // namespace vbr::upload
@@ -168,13 +168,25 @@ fillPipelineDynamicState(const std::vector<VkDynamicState> &states) {
     return ret;
 }
 
-void transitionImageLayout(VkCommandBuffer &cmd, VkImage &image,
-                           VkImageLayout old_layout, VkImageLayout new_layout) {
-    VkImageMemoryBarrier barrier{
-        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+BarrierBatch &BarrierBatch::image(const VkImageMemoryBarrier2 &barrier) {
+    m_images.push_back(barrier);
+    return *this;
+}
+
+BarrierBatch &BarrierBatch::image(VkImage image, VkImageLayout old_layout,
+                                  VkImageLayout new_layout,
+                                  VkPipelineStageFlags2 src_stages,
+                                  VkAccessFlags2 src_access,
+                                  VkPipelineStageFlags2 dst_stages,
+                                  VkAccessFlags2 dst_access,
+                                  VkImageAspectFlags aspect) {
+    m_images.push_back({
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
         .pNext = nullptr,
-        .srcAccessMask = 0,
-        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .srcStageMask = src_stages,
+        .srcAccessMask = src_access,
+        .dstStageMask = dst_stages,
+        .dstAccessMask = dst_access,
         .oldLayout = old_layout,
         .newLayout = new_layout,
         .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -182,51 +194,127 @@ void transitionImageLayout(VkCommandBuffer &cmd, VkImage &image,
         .image = image,
         .subresourceRange =
             {
-                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .aspectMask = aspect,
                 .baseMipLevel = 0,
                 .levelCount = 1,
                 .baseArrayLayer = 0,
                 .layerCount = 1,
             },
-    };
-    VkPipelineStageFlags source_stage = VK_PIPELINE_STAGE_NONE_KHR;
-    VkPipelineStageFlags destination_stage = VK_PIPELINE_STAGE_NONE_KHR;
+    });
+    return *this;
+}
 
+bool BarrierBatch::transition(VkImage target, VkImageLayout old_layout,
+                              VkImageLayout new_layout) {
     if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
         new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        image(target, old_layout, new_layout, VK_PIPELINE_STAGE_2_NONE,
+              VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_COPY_BIT,
+              VK_ACCESS_2_TRANSFER_WRITE_BIT);
     } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
                new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        image(target, old_layout, new_layout, VK_PIPELINE_STAGE_2_COPY_BIT,
+              VK_ACCESS_2_TRANSFER_WRITE_BIT,
+              VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+              VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
     } else if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
                new_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-        source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destination_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        // src is the stage the acquire semaphore is waited at, so the
+        // transition happens after the image is released by present
+        image(target, old_layout, new_layout,
+              VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+              VK_ACCESS_2_NONE,
+              VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+              VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
     } else if (old_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL &&
                new_layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
-        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-        barrier.dstAccessMask = 0;
-
-        source_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        destination_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        image(target, old_layout, new_layout,
+              VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+              VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_2_NONE,
+              VK_ACCESS_2_NONE);
+    } else if (old_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL &&
+               new_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+        image(target, old_layout, new_layout,
+              VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+              VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+              VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+              VK_ACCESS_2_TRANSFER_READ_BIT);
     } else {
         spdlog::warn("unknow layout transmit");
+        return false;
+    }
+    return true;
+}
+
+BarrierBatch &BarrierBatch::buffer(const VkBufferMemoryBarrier2 &barrier) {
+    m_buffers.push_back(barrier);
+    return *this;
+}
+
+BarrierBatch &BarrierBatch::buffer(VkBuffer buffer,
+                                   VkPipelineStageFlags2 src_stages,
+                                   VkAccessFlags2 src_access,
+                                   VkPipelineStageFlags2 dst_stages,
+                                   VkAccessFlags2 dst_access,
+                                   VkDeviceSize offset, VkDeviceSize size) {
+    m_buffers.push_back({
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .pNext = nullptr,
+        .srcStageMask = src_stages,
+        .srcAccessMask = src_access,
+        .dstStageMask = dst_stages,
+        .dstAccessMask = dst_access,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+    });
+    return *this;
+}
+
+BarrierBatch &BarrierBatch::append(const BarrierBatch &other) {
+    m_images.insert(m_images.end(), other.m_images.begin(),
+                    other.m_images.end());
+    m_buffers.insert(m_buffers.end(), other.m_buffers.begin(),
+                     other.m_buffers.end());
+    return *this;
+}
+
+void BarrierBatch::flush(VkCommandBuffer cmd) {
+    if (empty()) {
+        return;
+    }
+    VkDependencyInfo info{
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .pNext = nullptr,
+        .dependencyFlags = 0,
+        .memoryBarrierCount = 0,
+        .pMemoryBarriers = nullptr,
+        .bufferMemoryBarrierCount = static_cast<uint32_t>(m_buffers.size()),
+        .pBufferMemoryBarriers = m_buffers.data(),
+        .imageMemoryBarrierCount = static_cast<uint32_t>(m_images.size()),
+        .pImageMemoryBarriers = m_images.data(),
+    };
+    vkCmdPipelineBarrier2(cmd, &info);
+    clear();
+}
+
+void transitionImageLayout(VkCommandBuffer &cmd, VkImage &image,
+                           VkImageLayout old_layout, VkImageLayout new_layout) {
+    BarrierBatch batch;
+    if (batch.transition(image, old_layout, new_layout)) {
+        batch.flush(cmd);
     }
-    if (source_stage != VK_PIPELINE_STAGE_NONE_KHR &&
-        destination_stage != VK_PIPELINE_STAGE_NONE_KHR) {
-        vkCmdPipelineBarrier(cmd, source_stage, destination_stage, 0, 0,
-                             nullptr, 0, nullptr, 1, &barrier);
+}
+
+uint64_t hash(const void *data, size_t size, uint64_t seed) {
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= bytes[i];
+        h *= 0x100000001b3ull;
     }
+    return h;
 }
 } // namespace vbr::util
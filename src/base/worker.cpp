@@ -0,0 +1,66 @@
+#include "../../inc/worker.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+
+namespace vbr::worker {
+
+Pool::Pool(uint32_t count) {
+    if (count == 0) {
+        count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    m_threads.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        m_threads.emplace_back([this] { run(); });
+    }
+    spdlog::info("worker pool with {} threads", count);
+}
+
+Pool::~Pool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_job_cv.notify_all();
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void Pool::run() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(m_mutex);
+            m_job_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_jobs.empty()) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_running++;
+        }
+        job();
+        {
+            std::lock_guard lock(m_mutex);
+            m_running--;
+            if (m_running == 0 && m_jobs.empty()) {
+                m_idle_cv.notify_all();
+            }
+        }
+    }
+}
+
+void Pool::submit(std::function<void()> job) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_job_cv.notify_one();
+}
+
+void Pool::wait() {
+    std::unique_lock lock(m_mutex);
+    m_idle_cv.wait(lock, [this] { return m_running == 0 && m_jobs.empty(); });
+}
+
+} // namespace vbr::worker
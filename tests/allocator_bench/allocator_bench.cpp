@@ -0,0 +1,176 @@
+#include "allocator_bench.hpp"
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <spdlog/spdlog.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+App::~App() { quit(); }
+
+void App::report(std::string_view name, std::vector<double> &ns) {
+    if (ns.empty()) {
+        return;
+    }
+    std::sort(ns.begin(), ns.end());
+    auto percentile = [&ns](double p) {
+        size_t index = static_cast<size_t>(p * (ns.size() - 1));
+        return ns[index] / 1000.0;
+    };
+    double avg = std::accumulate(ns.begin(), ns.end(), 0.0) / ns.size();
+    spdlog::info("{:<24} n {:>6} avg {:>8.3f} p50 {:>8.3f} p90 {:>8.3f} "
+                 "p99 {:>8.3f} p99.9 {:>8.3f} max {:>9.3f} us",
+                 name, ns.size(), avg / 1000.0, percentile(0.5),
+                 percentile(0.9), percentile(0.99), percentile(0.999),
+                 ns.back() / 1000.0);
+}
+
+void App::benchSubAllocate() {
+    std::vector<vbr::allocator::Allocation> allocations(buffer_count);
+    std::vector<double> alloc_ns(buffer_count);
+    std::vector<double> free_ns(buffer_count);
+    std::mt19937 rng(42);
+
+    for (uint32_t i = 0; i < buffer_count; ++i) {
+        VkMemoryRequirements requirements{
+            .size = 64u << (rng() % 6),
+            .alignment = 256,
+            .memoryTypeBits = UINT32_MAX,
+        };
+        auto begin = Clock::now();
+        bool ret = m_vk_device->allocateMemory(
+            requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true,
+            allocations[i]);
+        alloc_ns[i] = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                               begin)
+                          .count();
+        // failed calls are not timed and nothing is left to free
+        if (!ret) {
+            spdlog::error("failed to sub allocate {}", i);
+            allocations.resize(i);
+            alloc_ns.resize(i);
+            break;
+        }
+    }
+    spdlog::info("{} blocks for {} sub allocations",
+                 m_vk_device->allocator().blockCount(),
+                 m_vk_device->allocator().count());
+
+    std::shuffle(allocations.begin(), allocations.end(), rng);
+    free_ns.resize(allocations.size());
+    for (size_t i = 0; i < allocations.size(); ++i) {
+        auto begin = Clock::now();
+        m_vk_device->freeMemory(allocations[i]);
+        free_ns[i] = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                              begin)
+                         .count();
+    }
+    report("sub allocate", alloc_ns);
+    report("sub free", free_ns);
+}
+
+void App::benchBuffers() {
+    std::vector<std::unique_ptr<vbr::buffer::Buffer>> buffers(buffer_count);
+    std::vector<double> create_ns(buffer_count);
+    std::vector<double> destroy_ns(buffer_count);
+    std::mt19937 rng(7);
+
+    for (uint32_t i = 0; i < buffer_count; ++i) {
+        auto begin = Clock::now();
+        buffers[i] = m_vk_device->createUniformBuffer<glm::mat4>();
+        create_ns[i] = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                                begin)
+                           .count();
+        if (!buffers[i]) {
+            spdlog::error("failed to create buffer {}", i);
+            buffers.resize(i);
+            create_ns.resize(i);
+            break;
+        }
+    }
+    spdlog::info("{} blocks for {} buffers",
+                 m_vk_device->allocator().blockCount(),
+                 m_vk_device->allocator().count());
+
+    std::shuffle(buffers.begin(), buffers.end(), rng);
+    destroy_ns.resize(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        auto begin = Clock::now();
+        buffers[i].reset();
+        destroy_ns[i] = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                                 begin)
+                            .count();
+    }
+    report("buffer create", create_ns);
+    report("buffer destroy", destroy_ns);
+}
+
+// one vkAllocateMemory per resource as before, capped by the driver limit
+void App::benchDedicated() {
+    uint32_t count = std::min<uint32_t>(
+        1000,
+        m_vk_device->propreties().limits.maxMemoryAllocationCount / 2);
+    std::vector<VkDeviceMemory> memories(count, VK_NULL_HANDLE);
+    std::vector<double> alloc_ns(count);
+    std::vector<double> free_ns(count);
+
+    VkMemoryAllocateInfo info{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext = nullptr,
+        .allocationSize = 256,
+        .memoryTypeIndex = m_vk_device->findMemoryType(
+            UINT32_MAX, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+    };
+    for (uint32_t i = 0; i < count; ++i) {
+        auto begin = Clock::now();
+        VkResult ret =
+            vkAllocateMemory(**m_vk_device, &info, nullptr, &memories[i]);
+        alloc_ns[i] = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                               begin)
+                          .count();
+        if (ret != VK_SUCCESS) {
+            spdlog::error("failed to allocate memory {}", i);
+            memories.resize(i);
+            alloc_ns.resize(i);
+            break;
+        }
+    }
+    free_ns.resize(memories.size());
+    for (size_t i = 0; i < memories.size(); ++i) {
+        auto begin = Clock::now();
+        vkFreeMemory(**m_vk_device, memories[i], nullptr);
+        free_ns[i] = std::chrono::duration<double, std::nano>(Clock::now() -
+                                                              begin)
+                         .count();
+    }
+    report("vkAllocateMemory", alloc_ns);
+    report("vkFreeMemory", free_ns);
+}
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    benchDedicated();
+    benchSubAllocate();
+    benchBuffers();
+    m_quit = true;
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::render() {
+    if (begin()) {
+        end();
+    }
+}
+
+void App::quit() {}
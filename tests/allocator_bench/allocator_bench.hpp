@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t buffer_count = 100000;
+
+  private:
+    // latency percentiles of one run, in microseconds
+    static void report(std::string_view name, std::vector<double> &ns);
+    void benchSubAllocate();
+    void benchBuffers();
+    void benchDedicated();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
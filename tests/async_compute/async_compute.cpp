@@ -0,0 +1,233 @@
+#include "async_compute.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    // seeded by the first step, no upload
+    for (auto &particles : m_particles) {
+        particles = m_vk_device->createStorageBuffer(
+            sizeof(Particle) * particle_count,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, true);
+        if (!particles) {
+            return false;
+        }
+    }
+
+    // set i reads the other buffer and writes buffer i
+    m_descriptor = std::make_unique<vbr::descriptor::Descriptor>(
+        **m_vk_device, &m_vk_device->descriptorAllocator(),
+        &m_vk_device->layouts());
+    m_descriptor->addDescriptorBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                       VK_SHADER_STAGE_COMPUTE_BIT);
+    m_descriptor->addDescriptorBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                       VK_SHADER_STAGE_COMPUTE_BIT);
+    m_descriptor->maxSet(2);
+    if (!m_descriptor->init()) {
+        return false;
+    }
+    for (uint32_t i = 0; i < 2; ++i) {
+        m_descriptor->updateBuffer(*m_particles[i ^ 1], 0, 0,
+                                   VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, i);
+        m_descriptor->updateBuffer(*m_particles[i], 1, 0,
+                                   VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, i);
+    }
+
+    m_compute_layout = std::make_unique<vbr::layout::Layout>(
+        **m_vk_device, &m_vk_device->layouts());
+    m_compute_layout->addConstnat(VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                  sizeof(SimulatePush));
+    if (!m_compute_layout->init({**m_descriptor})) {
+        return false;
+    }
+    m_simulate = std::make_unique<vbr::cpipeline::Pipeline>(*m_vk_device);
+    m_simulate->setShader(SHADER_DIR "/async_compute/comp.spv");
+    m_simulate->addConstant(0, group_size);
+    if (!m_simulate->init(**m_compute_layout)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device,
+                                                     &m_vk_device->layouts());
+    m_layout->init();
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          SHADER_DIR "/async_compute/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          SHADER_DIR "/async_compute/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    m_pipeline->addBinding(0, sizeof(Particle));
+    m_pipeline->addAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(Particle, pos));
+    m_pipeline->addAttribute(1, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(Particle, vel));
+    m_pipeline->topology(VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    if (!m_vk_device->asyncCompute().async()) {
+        spdlog::warn("no dedicated compute family, async batches share the "
+                     "graphics queue");
+    }
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::simulate(VkCommandBuffer cmd, uint64_t frame) {
+    uint32_t dst = frame % 2;
+    // the previous step wrote the source
+    vbr::util::BarrierBatch()
+        .buffer(m_particles[dst ^ 1]->buffer,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT)
+        .flush(cmd);
+    SimulatePush push{
+        .dt = 1.0f / 60.0f,
+        .count = particle_count,
+        .steps = steps,
+        .reset = frame == 0 ? 1u : 0u,
+    };
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, **m_simulate);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            **m_compute_layout, 0, 1, &m_descriptor->set(dst),
+                            0, nullptr);
+    vkCmdPushConstants(cmd, **m_compute_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(push), &push);
+    vkCmdDispatch(cmd, (particle_count + group_size - 1) / group_size, 1, 1);
+}
+
+vbr::acompute::Ticket App::submitAsync(uint64_t frame) {
+    auto &compute = m_vk_device->asyncCompute();
+    VkCommandBuffer cmd = compute.begin(static_cast<uint32_t>(frame));
+    if (cmd == VK_NULL_HANDLE) {
+        return 0;
+    }
+    simulate(cmd, frame);
+    // the last submitted graphics frame drew the source, the one before
+    // it drew the buffer being written
+    return compute.submit(compute.graphicsValue() - 1);
+}
+
+void App::drawParticles() {
+    bindPipeline(*m_pipeline);
+    bindVertex(*m_particles[m_frame % 2]);
+    setViewport();
+    setScissor();
+    draw(particle_count);
+}
+
+void App::renderSerial() {
+    if (!beginFrame()) {
+        return;
+    }
+    VkCommandBuffer cmd = commandBuffer();
+    auto &particles = m_particles[m_frame % 2];
+    // the frame before last drew the buffer being written
+    vbr::util::BarrierBatch()
+        .buffer(particles->buffer,
+                VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_NONE)
+        .flush(cmd);
+    simulate(cmd, m_frame);
+    vbr::util::BarrierBatch()
+        .buffer(particles->buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT)
+        .flush(cmd);
+    beginRendering();
+    drawParticles();
+    end();
+    m_frame++;
+    measure();
+}
+
+void App::renderAsync() {
+    if (!beginFrame()) {
+        return;
+    }
+    auto &compute = m_vk_device->asyncCompute();
+    // first async frame, its own step was not submitted ahead
+    if (m_ticket == 0) {
+        m_ticket = submitAsync(m_frame);
+    }
+    // the next frame's step runs while this frame draws
+    vbr::acompute::Ticket next = submitAsync(m_frame + 1);
+    compute.consume(m_ticket, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+    m_ticket = next;
+    beginRendering();
+    drawParticles();
+    end();
+    m_frame++;
+    measure();
+}
+
+void App::measure() {
+    m_mode_frames++;
+    if (m_mode_frames == warmup_frames) {
+        m_start = std::chrono::steady_clock::now();
+        return;
+    }
+    if (m_mode_frames < warmup_frames + frames_per_mode) {
+        return;
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - m_start;
+    uint32_t index = m_mode == Mode::serial ? 0 : 1;
+    m_ms[index] = elapsed.count() / frames_per_mode;
+    spdlog::info("{:<6} {} particles x {} steps {:.3f} ms/frame",
+                 index == 0 ? "serial" : "async", particle_count, steps,
+                 m_ms[index]);
+    m_mode_frames = 0;
+    if (m_mode == Mode::serial) {
+        m_mode = Mode::async;
+        return;
+    }
+    // overlap hides compute behind the draw, the saving is its share
+    spdlog::info("async saves {:.3f} ms/frame, {:.1f}% of serial",
+                 m_ms[0] - m_ms[1], 100.0 * (m_ms[0] - m_ms[1]) / m_ms[0]);
+    m_mode = Mode::done;
+    m_quit = true;
+}
+
+void App::render() {
+    switch (m_mode) {
+    case Mode::serial:
+        renderSerial();
+        break;
+    case Mode::async:
+        renderAsync();
+        break;
+    case Mode::done:
+        break;
+    }
+}
+
+void App::quit() {
+    m_pipeline.reset();
+    m_layout.reset();
+    m_simulate.reset();
+    m_compute_layout.reset();
+    m_descriptor.reset();
+    for (auto &particles : m_particles) {
+        particles.reset();
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/compute_pipeline.hpp"
+#include "../../inc/descriptor.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+struct Particle {
+    glm::vec2 pos;
+    glm::vec2 vel;
+};
+
+struct SimulatePush {
+    float dt;
+    uint32_t count;
+    uint32_t steps;
+    uint32_t reset;
+};
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t particle_count = 1 << 20;
+    static constexpr uint32_t group_size = 256;
+    static constexpr uint32_t steps = 64;
+    static constexpr uint32_t warmup_frames = 30;
+    static constexpr uint32_t frames_per_mode = 300;
+
+    // serial records the simulation into the frame, async runs the next
+    // frame's simulation on the compute queue while this one draws
+    enum class Mode { serial, async, done };
+
+    // ping pong state, frame f draws and writes m_particles[f % 2]
+    std::array<std::unique_ptr<vbr::buffer::Buffer>, 2> m_particles;
+    std::unique_ptr<vbr::descriptor::Descriptor> m_descriptor;
+    std::unique_ptr<vbr::layout::Layout> m_compute_layout;
+    std::unique_ptr<vbr::cpipeline::Pipeline> m_simulate;
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    Mode m_mode = Mode::serial;
+    uint64_t m_frame = 0;
+    uint32_t m_mode_frames = 0;
+    // simulation of m_frame already submitted to the compute queue
+    vbr::acompute::Ticket m_ticket = 0;
+    std::chrono::steady_clock::time_point m_start;
+    std::array<double, 2> m_ms{};
+
+  private:
+    // record the step writing m_particles[frame % 2]
+    void simulate(VkCommandBuffer cmd, uint64_t frame);
+    vbr::acompute::Ticket submitAsync(uint64_t frame);
+    void renderSerial();
+    void renderAsync();
+    void drawParticles();
+    void measure();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
@@ -0,0 +1,133 @@
+#include "bindless.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+    auto *table = m_vk_device->bindless();
+    if (table == nullptr) {
+        spdlog::error("bindless example needs descriptor indexing");
+        return false;
+    }
+
+    // the table's set is the only one, draws pick slots by push constant
+    constexpr VkShaderStageFlags stages =
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout->addConstnat(stages, 0, sizeof(DrawConstants));
+    if (!m_layout->init({table->layout()})) {
+        return false;
+    }
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          SHADER_DIR "/bindless/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          SHADER_DIR "/bindless/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    m_pipeline->addBinding(0, sizeof(VertexInfo));
+    m_pipeline->addAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(VertexInfo, pos));
+    m_pipeline->addAttribute(1, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(VertexInfo, coord));
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    const std::vector<VertexInfo> vertices = {
+        {{-1.0f, -1.0f}, {0.0f, 0.0f}},
+        {{1.0f, -1.0f}, {1.0f, 0.0f}},
+        {{1.0f, 1.0f}, {1.0f, 1.0f}},
+        {{-1.0f, 1.0f}, {0.0f, 1.0f}},
+    };
+    m_vbuffer = m_vk_device->createUsageBuffer<VertexInfo>(
+        vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    std::vector<uint32_t> indexs{0, 1, 2, 2, 3, 0};
+    m_ibuffer = m_vk_device->createUsageBuffer<uint32_t>(
+        indexs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    // every texture has its own view and sampler slot in the table
+    for (uint32_t i = 0; i < texture_count; ++i) {
+        auto texture = m_vk_device->createTexture("../asset/test.png");
+        if (!texture || texture->index == vbr::bindless::invalid_index ||
+            texture->sampler_index == vbr::bindless::invalid_index) {
+            spdlog::error("failed to add texture {} to the bindless table", i);
+            return false;
+        }
+        m_textures.push_back(std::move(texture));
+    }
+
+    // one cell of the grid in clip space, the quad leaves a gap
+    const glm::vec2 cell{2.0f / columns, 2.0f / rows};
+    m_draws.reserve(columns * rows);
+    for (uint32_t y = 0; y < rows; ++y) {
+        for (uint32_t x = 0; x < columns; ++x) {
+            const auto &texture = m_textures[(x + y) % texture_count];
+            m_draws.push_back({
+                .offset = {-1.0f + (x + 0.5f) * cell.x,
+                           -1.0f + (y + 0.5f) * cell.y},
+                .scale = cell.x * 0.4f,
+                .image = texture->index,
+                .sampler = texture->sampler_index,
+            });
+        }
+    }
+    m_last_report = std::chrono::steady_clock::now();
+    return true;
+}
+
+void App::update() {
+    vbr::app::App::update();
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_last_report < std::chrono::seconds(1)) {
+        return;
+    }
+    m_last_report = now;
+    // one set bind a frame, the rest are pipeline, buffers and dynamic state
+    spdlog::info("{} draws over {} textures, {} state calls ({} elided), "
+                 "{:.1f} fps",
+                 m_draws.size(), texture_count, stateCalls(),
+                 elidedStateCalls(), fps());
+}
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::render() {
+    if (begin()) {
+        bindPipeline(*m_pipeline);
+        // once per frame, draws only push their slots
+        bindDescriptorSet(**m_vk_device->bindless(), **m_layout);
+        bindVertex(*m_vbuffer);
+        bindIndex(*m_ibuffer);
+        setViewport();
+        setScissor();
+        for (auto &draw : m_draws) {
+            pushConstant(**m_layout,
+                         VK_SHADER_STAGE_VERTEX_BIT |
+                             VK_SHADER_STAGE_FRAGMENT_BIT,
+                         0, sizeof(DrawConstants), &draw);
+            drawIndex(6);
+        }
+        end();
+    }
+}
+
+void App::quit() {
+    m_textures.clear();
+    m_ibuffer.reset();
+    m_vbuffer.reset();
+    m_layout.reset();
+    m_pipeline.reset();
+}
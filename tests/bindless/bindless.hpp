@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/image.hpp"
+#include "../../inc/layout.hpp"
+#include <chrono>
+#include <memory>
+#include <vector>
+
+struct VertexInfo {
+    glm::vec2 pos;
+    glm::vec2 coord;
+};
+
+// push constants of one draw, the only state that changes between draws
+struct DrawConstants {
+    glm::vec2 offset;
+    float scale;
+    // slots in the device bindless table
+    uint32_t image;
+    uint32_t sampler;
+};
+
+class App : public vbr::app::App {
+  private:
+    // 64 x 64 quads, each one draw, over texture_count textures
+    static constexpr uint32_t columns = 64;
+    static constexpr uint32_t rows = 64;
+    static constexpr uint32_t texture_count = 16;
+
+    std::vector<std::unique_ptr<vbr::image::Texture>> m_textures;
+    std::unique_ptr<vbr::buffer::Buffer> m_vbuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_ibuffer;
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    std::vector<DrawConstants> m_draws;
+    std::chrono::steady_clock::time_point m_last_report;
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+using Clock = std::chrono::high_resolution_clock;
+
+// milliseconds since start
+inline double since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+struct Summary {
+    size_t frames = 0;
+    double avg = 0.0;
+    double p50 = 0.0;
+    double min = 0.0;
+};
+
+// cost of the timed part of every frame of a bench that runs each Mode in
+// order for frames_per_mode frames, Mode counts from 0 and ends with done,
+// names holds one name per mode before done
+template <typename Mode> class Run {
+  private:
+    std::vector<std::string_view> m_names;
+    uint32_t m_frames_per_mode;
+    Mode m_mode = Mode{};
+    uint32_t m_frames = 0;
+    std::vector<double> m_ms;
+    Clock::time_point m_start;
+
+  public:
+    Run(std::vector<std::string_view> names, uint32_t frames_per_mode)
+        : m_names(std::move(names)), m_frames_per_mode(frames_per_mode) {
+        m_ms.reserve(frames_per_mode);
+    }
+
+    Mode mode() const { return m_mode; }
+    bool done() const { return m_mode == Mode::done; }
+    std::string_view name() const {
+        return m_names[static_cast<size_t>(m_mode)];
+    }
+    // frames timed in the current mode
+    uint32_t frame() const { return m_frames; }
+
+    void start() { m_start = Clock::now(); }
+    // end the timed part of a frame, true once the mode has all its frames
+    bool stop() {
+        m_ms.push_back(since(m_start));
+        return ++m_frames >= m_frames_per_mode;
+    }
+
+    // log name, work and the frame times of the current mode
+    Summary report(std::string_view work) {
+        Summary ret;
+        if (m_ms.empty()) {
+            return ret;
+        }
+        std::sort(m_ms.begin(), m_ms.end());
+        ret.frames = m_ms.size();
+        ret.avg = std::accumulate(m_ms.begin(), m_ms.end(), 0.0) / ret.frames;
+        ret.p50 = m_ms[ret.frames / 2];
+        ret.min = m_ms.front();
+        spdlog::info("{:<14} {} x {} frames avg {:>7.3f} ms p50 {:>7.3f} ms "
+                     "min {:>7.3f} ms",
+                     name(), work, ret.frames, ret.avg, ret.p50, ret.min);
+        return ret;
+    }
+
+    // switch to mode and drop the samples, done ends the run
+    void next(Mode mode) {
+        m_mode = mode;
+        m_frames = 0;
+        m_ms.clear();
+    }
+    void next() { next(static_cast<Mode>(static_cast<int>(m_mode) + 1)); }
+};
+
+} // namespace bench
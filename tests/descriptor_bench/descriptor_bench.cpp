@@ -0,0 +1,141 @@
+#include "descriptor_bench.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+
+App::~App() { quit(); }
+
+void App::fillInfos(uint32_t frame) {
+    for (uint32_t i = 0; i < set_count; ++i) {
+        VkDeviceSize offset = ((i + frame) % set_count) * sizeof(Slice);
+        m_infos[i] = {
+            .uniform = {m_uniform->buffer, offset, sizeof(Slice)},
+            .storage = {m_storage->buffer, offset, sizeof(Slice)},
+        };
+    }
+}
+
+// two vkUpdateDescriptorSets per set, as Descriptor::updateBuffer does
+void App::updatePerCall() {
+    for (uint32_t i = 0; i < set_count; ++i) {
+        VkWriteDescriptorSet write_info{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .pNext = nullptr,
+            .dstSet = m_descriptor->set(i),
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            .pImageInfo = nullptr,
+            .pBufferInfo = &m_infos[i].uniform,
+            .pTexelBufferView = nullptr,
+        };
+        vkUpdateDescriptorSets(**m_vk_device, 1, &write_info, 0, nullptr);
+        write_info.dstBinding = 1;
+        write_info.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write_info.pBufferInfo = &m_infos[i].storage;
+        vkUpdateDescriptorSets(**m_vk_device, 1, &write_info, 0, nullptr);
+    }
+}
+
+void App::updateBatched() {
+    for (uint32_t i = 0; i < set_count; ++i) {
+        m_writer->writeBuffer(m_descriptor->set(i), 0, m_infos[i].uniform,
+                              VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        m_writer->writeBuffer(m_descriptor->set(i), 1, m_infos[i].storage,
+                              VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    }
+    m_writer->flush();
+}
+
+void App::updateTemplated() {
+    for (uint32_t i = 0; i < set_count; ++i) {
+        m_template->update(m_descriptor->set(i), &m_infos[i]);
+    }
+}
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    m_descriptor = std::make_unique<vbr::descriptor::Descriptor>(**m_vk_device);
+    m_descriptor->addDescriptorBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    m_descriptor->addDescriptorBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    m_descriptor->maxSet(set_count);
+    if (!m_descriptor->init()) {
+        return false;
+    }
+
+    m_writer = std::make_unique<vbr::descriptor::Writer>(**m_vk_device);
+    m_template = std::make_unique<vbr::descriptor::Template>(**m_vk_device);
+    m_template->addEntry(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                         offsetof(SetInfos, uniform));
+    m_template->addEntry(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                         offsetof(SetInfos, storage));
+    if (!m_template->init(**m_descriptor)) {
+        return false;
+    }
+
+    // 256 byte slices meet any offset alignment
+    m_uniform =
+        m_vk_device->createUniformBuffer<std::array<Slice, set_count>>();
+    m_storage = m_vk_device->createUsageBuffer<Slice>(
+        std::vector<Slice>(set_count), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    if (!m_uniform || !m_storage) {
+        return false;
+    }
+    m_infos.resize(set_count);
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+// the sets are never bound, so updating them while frames are in flight
+// is fine
+void App::render() {
+    if (m_run.done() || !begin()) {
+        return;
+    }
+    fillInfos(m_run.frame());
+    m_run.start();
+    switch (m_run.mode()) {
+    case Mode::per_call:
+        updatePerCall();
+        break;
+    case Mode::batched:
+        updateBatched();
+        break;
+    case Mode::templated:
+        updateTemplated();
+        break;
+    case Mode::done:
+        break;
+    }
+    bool finished = m_run.stop();
+    end();
+
+    if (!finished) {
+        return;
+    }
+    auto summary = m_run.report(std::to_string(set_count) + " sets");
+    spdlog::info("{:<14} {:>6.1f} ns per set", m_run.name(),
+                 summary.avg * 1e6 / set_count);
+    m_run.next();
+    if (m_run.done()) {
+        m_quit = true;
+    }
+}
+
+void App::quit() {
+    m_template.reset();
+    m_writer.reset();
+    m_storage.reset();
+    m_uniform.reset();
+    m_descriptor.reset();
+}
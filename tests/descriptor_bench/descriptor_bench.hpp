@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/descriptor.hpp"
+#include "../common/bench.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+// per object data, one slice per set
+struct Slice {
+    glm::mat4 matrices[4];
+};
+
+// what the template reads for one set
+struct SetInfos {
+    VkDescriptorBufferInfo uniform;
+    VkDescriptorBufferInfo storage;
+};
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t set_count = 10000;
+    static constexpr uint32_t frames_per_mode = 120;
+
+    enum class Mode { per_call, batched, templated, done };
+
+    std::unique_ptr<vbr::descriptor::Descriptor> m_descriptor;
+    std::unique_ptr<vbr::descriptor::Writer> m_writer;
+    std::unique_ptr<vbr::descriptor::Template> m_template;
+    std::unique_ptr<vbr::buffer::Buffer> m_uniform;
+    std::unique_ptr<vbr::buffer::Buffer> m_storage;
+    std::vector<SetInfos> m_infos;
+    // update cost of every frame of the current mode
+    bench::Run<Mode> m_run{{"per call", "batched", "template"},
+                           frames_per_mode};
+
+  private:
+    // point every set at the slices shifted by frame
+    void fillInfos(uint32_t frame);
+    void updatePerCall();
+    void updateBatched();
+    void updateTemplated();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
@@ -0,0 +1,132 @@
+#include "draw_queue_bench.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <spdlog/spdlog.h>
+#include <string>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout->init();
+
+    // one pipeline per material, like a renderer with a variant per
+    // material, so sorting by pipeline has real switches to save
+    for (uint32_t i = 0; i < pipeline_count; ++i) {
+        m_materials[i] = i;
+        m_specializations[i] = {
+            .mapEntryCount = 1,
+            .pMapEntries = &material_entry,
+            .dataSize = sizeof(uint32_t),
+            .pData = &m_materials[i],
+        };
+        auto pipeline =
+            std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+        pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                            "../tests/shaders/base_triangle/vert.spv");
+        pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                            SHADER_DIR "/draw_queue_bench/frag.spv",
+                            &m_specializations[i]);
+        pipeline->addViewport(static_cast<float>(m_window_size.x),
+                              static_cast<float>(m_window_size.y));
+        pipeline->addScissor(m_window_size.x, m_window_size.y);
+        pipeline->addColorBlendAttachemt();
+        pipeline->initAsync(**m_layout);
+        m_pipelines.push_back(std::move(pipeline));
+    }
+    for (auto &pipeline : m_pipelines) {
+        if (!pipeline->wait()) {
+            return false;
+        }
+    }
+
+    // draws in scene order, materials interleaved
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<uint32_t> pick(0, pipeline_count - 1);
+    std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        m_draw_pipelines.push_back(pick(rng));
+        m_draw_depths.push_back(depth(rng));
+    }
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::drawImmediate() {
+    setViewport();
+    setScissor();
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        bindPipeline(*m_pipelines[m_draw_pipelines[i]]);
+        draw(3);
+    }
+}
+
+void App::drawQueued() {
+    setViewport();
+    setScissor();
+    m_queue.clear();
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        m_queue.push({
+            .pipeline = m_pipelines[m_draw_pipelines[i]].get(),
+            .count = 3,
+            .depth = m_draw_depths[i],
+        });
+    }
+    submit(m_queue);
+}
+
+void App::render() {
+    if (m_run.done() || !begin()) {
+        return;
+    }
+    // counts are of the previous frame, the first one belongs to the
+    // previous mode
+    if (m_run.frame() > 0) {
+        m_issued.push_back(stateCalls() - elidedStateCalls());
+    }
+    m_run.start();
+    switch (m_run.mode()) {
+    case Mode::immediate:
+        drawImmediate();
+        break;
+    case Mode::queued:
+        drawQueued();
+        break;
+    case Mode::done:
+        break;
+    }
+    bool finished = m_run.stop();
+    end();
+
+    if (!finished) {
+        return;
+    }
+    m_run.report(std::to_string(draw_count) + " draws");
+    double issued = 0.0;
+    if (!m_issued.empty()) {
+        issued = std::accumulate(m_issued.begin(), m_issued.end(), 0.0) /
+                 m_issued.size();
+    }
+    spdlog::info("{:<14} {:.0f} state calls issued per frame", m_run.name(),
+                 issued);
+    m_issued.clear();
+    m_run.next();
+    if (m_run.done()) {
+        m_quit = true;
+    }
+}
+
+void App::quit() {
+    m_pipelines.clear();
+    m_layout.reset();
+}
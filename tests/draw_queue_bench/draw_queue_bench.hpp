@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/draw_queue.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include "../common/bench.hpp"
+#include <array>
+#include <memory>
+#include <vector>
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t draw_count = 20000;
+    static constexpr uint32_t pipeline_count = 8;
+    static constexpr uint32_t frames_per_mode = 120;
+
+    enum class Mode { immediate, queued, done };
+
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::vector<std::unique_ptr<vbr::gpipeline::Pipeline>> m_pipelines;
+    // material of every pipeline, a specialization constant of the
+    // fragment shader, read while the pipelines build
+    static constexpr VkSpecializationMapEntry material_entry{
+        .constantID = 0,
+        .offset = 0,
+        .size = sizeof(uint32_t),
+    };
+    std::array<uint32_t, pipeline_count> m_materials{};
+    std::array<VkSpecializationInfo, pipeline_count> m_specializations{};
+    // pipeline and depth of every draw, in submission order
+    std::vector<uint32_t> m_draw_pipelines;
+    std::vector<float> m_draw_depths;
+    vbr::draw::Queue m_queue;
+    // recording cost of every frame of the current mode
+    bench::Run<Mode> m_run{{"immediate", "queued"}, frames_per_mode};
+    // state calls that reached the command buffer per frame
+    std::vector<uint32_t> m_issued;
+
+  private:
+    void drawImmediate();
+    void drawQueued();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
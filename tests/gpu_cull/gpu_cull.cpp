@@ -0,0 +1,297 @@
+#include "gpu_cull.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <spdlog/spdlog.h>
+
+using Clock = std::chrono::high_resolution_clock;
+
+App::~App() { quit(); }
+
+void App::report(std::string_view name) {
+    if (m_ms.empty()) {
+        return;
+    }
+    // counts lag the frames in flight, skip the ones of the last mode
+    auto first = m_visible.begin() + std::min<size_t>(m_visible.size(), 8);
+    double visible =
+        first == m_visible.end()
+            ? 0.0
+            : std::accumulate(first, m_visible.end(), 0.0) /
+                  (m_visible.end() - first);
+    double avg = std::accumulate(m_ms.begin(), m_ms.end(), 0.0) / m_ms.size();
+    spdlog::info("{:<10} {} objects, {:.0f} visible ({:.2f}%), recording "
+                 "{:>7.3f} ms",
+                 name, object_count, visible, 100.0 * visible / object_count,
+                 avg);
+    if (m_dropped > 0) {
+        spdlog::warn("{:<10} up to {} draws per frame past capacity dropped",
+                     name, m_dropped);
+    }
+    // fragments per primitive show how much overdraw culling leaves
+    vbr::pstats::report(name, m_pipeline->statistics());
+}
+
+bool App::initDepth() {
+    VkImageCreateInfo info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = depth_format,
+        .extent =
+            {
+                .width = static_cast<uint32_t>(m_window_size.x),
+                .height = static_cast<uint32_t>(m_window_size.y),
+                .depth = 1,
+            },
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+                 VK_IMAGE_USAGE_SAMPLED_BIT,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .queueFamilyIndexCount = 0,
+        .pQueueFamilyIndices = nullptr,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+    if (!m_vk_device->createImage(info, m_depth, m_depth_memory)) {
+        return false;
+    }
+    VkImageViewCreateInfo view_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext = nullptr,
+        .flags = 0,
+        .image = m_depth,
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = depth_format,
+        .components = {},
+        .subresourceRange =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+    if (VK_SUCCESS !=
+        vkCreateImageView(**m_vk_device, &view_info, nullptr, &m_depth_view)) {
+        spdlog::error("failed to create depth view");
+        return false;
+    }
+    depthAttachment(m_depth_view, depth_format);
+    return m_culler->resize({info.extent.width, info.extent.height});
+}
+
+void App::destroyDepth() {
+    depthAttachment(VK_NULL_HANDLE, VK_FORMAT_UNDEFINED);
+    if (m_depth_view != VK_NULL_HANDLE) {
+        vkDestroyImageView(**m_vk_device, m_depth_view, nullptr);
+        m_depth_view = VK_NULL_HANDLE;
+    }
+    m_vk_device->destroyImage(m_depth, m_depth_memory);
+}
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+    if (!m_vk_device->drawIndirectCount()) {
+        spdlog::error("gpu culling needs draw indirect count");
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device,
+                                                     &m_vk_device->layouts());
+    m_layout->addConstnat(VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4));
+    if (!m_layout->init()) {
+        return false;
+    }
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          SHADER_DIR "/gpu_cull/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          SHADER_DIR "/gpu_cull/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    m_pipeline->addBinding(0, sizeof(VertexInfo));
+    m_pipeline->addBinding(1, sizeof(vbr::cull::Object),
+                           VK_VERTEX_INPUT_RATE_INSTANCE);
+    m_pipeline->addAttribute(0, 0, VK_FORMAT_R32G32B32_SFLOAT,
+                             offsetof(VertexInfo, pos));
+    m_pipeline->addAttribute(1, 1, VK_FORMAT_R32G32B32A32_SFLOAT,
+                             offsetof(vbr::cull::Object, sphere));
+    m_pipeline->depth(depth_format);
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    const std::vector<VertexInfo> vertices = {
+        {{-1.0f, -1.0f, -1.0f}}, {{1.0f, -1.0f, -1.0f}},
+        {{1.0f, 1.0f, -1.0f}},   {{-1.0f, 1.0f, -1.0f}},
+        {{-1.0f, -1.0f, 1.0f}},  {{1.0f, -1.0f, 1.0f}},
+        {{1.0f, 1.0f, 1.0f}},    {{-1.0f, 1.0f, 1.0f}},
+    };
+    m_vbuffer = m_vk_device->createUsageBuffer<VertexInfo>(
+        vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    // faces clockwise seen from outside
+    std::vector<uint32_t> indexs{0, 1, 2, 2, 3, 0, 4, 7, 6, 6, 5, 4,
+                                 0, 3, 7, 7, 4, 0, 1, 5, 6, 6, 2, 1,
+                                 3, 2, 6, 6, 7, 3, 0, 4, 5, 5, 1, 0};
+    m_ibuffer = m_vk_device->createUsageBuffer<uint32_t>(
+        indexs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    // buildings on the ground with streets between them, the buffer is
+    // also the per instance stream of the draws
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> size(0.8f, 1.5f);
+    std::vector<vbr::cull::Object> objects;
+    objects.reserve(object_count);
+    for (uint32_t z = 0; z < rows; ++z) {
+        for (uint32_t x = 0; x < columns; ++x) {
+            float half = size(rng);
+            objects.push_back({
+                .sphere = {x * spacing, half, z * spacing,
+                           half * std::sqrt(3.0f)},
+                .index_count = static_cast<uint32_t>(indexs.size()),
+                .first_index = 0,
+                .vertex_offset = 0,
+            });
+        }
+    }
+    m_objects = m_vk_device->createUsageBuffer<vbr::cull::Object>(
+        objects, static_cast<VkBufferUsageFlagBits>(
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+    if (!m_vbuffer || !m_ibuffer || !m_objects) {
+        return false;
+    }
+
+    m_culler = std::make_unique<vbr::cull::Culler>(*m_vk_device);
+    if (!m_culler->init(object_count,
+                        SHADER_DIR "/gpu_cull/cull/comp.spv",
+                        SHADER_DIR "/gpu_cull/pyramid/comp.spv")) {
+        return false;
+    }
+    m_culler->objects(*m_objects, object_count);
+    if (!initDepth()) {
+        return false;
+    }
+    m_visible.reserve(frames_per_mode);
+    m_ms.reserve(frames_per_mode);
+    pipelineStatistics(true);
+    return true;
+}
+
+// walk down a street at eye height, looking around
+void App::update() {
+    vbr::app::App::update();
+    float t = static_cast<float>(m_frames);
+    glm::vec3 eye{(columns / 2 + 0.5f) * spacing, 1.5f, 8.0f + t * 0.25f};
+    float yaw = 0.6f * std::sin(t * 0.02f);
+    glm::vec3 dir{std::sin(yaw), -0.05f, std::cos(yaw)};
+    glm::mat4 view = glm::lookAt(eye, eye + dir, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspectiveRH_ZO(
+        glm::radians(60.0f), m_window_size.x / (float)m_window_size.y, 0.1f,
+        2000.0f);
+    proj[1][1] *= -1;
+    m_view_proj = proj * view;
+}
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::next() {
+    m_frames = 0;
+    m_visible.clear();
+    m_ms.clear();
+    m_dropped = 0;
+    m_pipeline->statistics().reset();
+    m_mode = m_mode == Mode::frustum ? Mode::occlusion : Mode::done;
+    if (m_mode == Mode::done) {
+        m_quit = true;
+    }
+}
+
+void App::render() {
+    if (m_mode == Mode::done || !beginFrame()) {
+        return;
+    }
+    auto start = Clock::now();
+    VkCommandBuffer cmd = commandBuffer();
+    // the pyramid is built from the depth the last frame left
+    if (m_depth_ready) {
+        m_culler->buildPyramid(cmd, m_depth_view,
+                               VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+    }
+    m_culler->cull(cmd, frameIndex(), m_view_proj,
+                   m_mode == Mode::occlusion);
+    m_visible.push_back(m_culler->stats().visible);
+    m_dropped = std::max(m_dropped, m_culler->stats().dropped);
+
+    // cleared by the pass, only the pyramid reads must be done
+    vbr::util::BarrierBatch()
+        .image(m_depth, VK_IMAGE_LAYOUT_UNDEFINED,
+               VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE,
+               VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                   VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+               VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+               VK_IMAGE_ASPECT_DEPTH_BIT)
+        .flush(cmd);
+    beginRendering(0.55f, 0.65f, 0.75f, 1.0f);
+    bindPipeline(*m_pipeline);
+    const std::array<VkBuffer, 2> streams{m_vbuffer->buffer, m_objects->buffer};
+    bindVertex(0, streams);
+    bindIndex(*m_ibuffer);
+    setViewport();
+    setScissor();
+    pushConstant(**m_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                 sizeof(m_view_proj), &m_view_proj);
+    drawIndexedIndirectCount(m_culler->draws());
+    endRendering();
+    vbr::util::BarrierBatch()
+        .image(m_depth, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+               VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+               VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+               VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+               VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+               VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_ASPECT_DEPTH_BIT)
+        .flush(cmd);
+    m_depth_ready = true;
+    std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+    m_ms.push_back(elapsed.count());
+    endFrame();
+
+    if (++m_frames < frames_per_mode) {
+        return;
+    }
+    report(m_mode == Mode::frustum ? "frustum" : "occlusion");
+    next();
+}
+
+void App::quit() {
+    if (m_vk_device) {
+        m_vk_device->waitIdle();
+        destroyDepth();
+    }
+    m_culler.reset();
+    m_objects.reset();
+    m_ibuffer.reset();
+    m_vbuffer.reset();
+    m_layout.reset();
+    m_pipeline.reset();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/gpu_cull.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+struct VertexInfo {
+    glm::vec3 pos;
+};
+
+class App : public vbr::app::App {
+  private:
+    // city blocks, one building per cell
+    static constexpr uint32_t columns = 448;
+    static constexpr uint32_t rows = 448;
+    static constexpr uint32_t object_count = columns * rows;
+    static constexpr float spacing = 4.0f;
+    static constexpr uint32_t frames_per_mode = 240;
+    static constexpr VkFormat depth_format = VK_FORMAT_D32_SFLOAT;
+
+    enum class Mode { frustum, occlusion, done };
+
+    std::unique_ptr<vbr::buffer::Buffer> m_vbuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_ibuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_objects;
+    std::unique_ptr<vbr::cull::Culler> m_culler;
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    VkImage m_depth = VK_NULL_HANDLE;
+    VkImageView m_depth_view = VK_NULL_HANDLE;
+    vbr::allocator::Allocation m_depth_memory;
+    // the depth buffer holds a frame to build the pyramid from
+    bool m_depth_ready = false;
+    glm::mat4 m_view_proj{1.0f};
+    Mode m_mode = Mode::frustum;
+    uint32_t m_frames = 0;
+    // visible objects and recording cost of every frame of the mode
+    std::vector<uint32_t> m_visible;
+    std::vector<double> m_ms;
+    // most draws a frame of the mode lost to the indirect buffer capacity
+    uint32_t m_dropped = 0;
+
+  private:
+    bool initDepth();
+    void destroyDepth();
+    void report(std::string_view name);
+    void next();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
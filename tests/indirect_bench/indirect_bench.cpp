@@ -0,0 +1,171 @@
+#include "indirect_bench.hpp"
+#include "vulkan/vulkan_core.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout->init();
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          SHADER_DIR "/instancing/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          SHADER_DIR "/instancing/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    m_pipeline->addBinding(0, sizeof(VertexInfo));
+    m_pipeline->addBinding(1, sizeof(InstanceInfo),
+                           VK_VERTEX_INPUT_RATE_INSTANCE);
+    m_pipeline->addAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(VertexInfo, pos));
+    m_pipeline->addAttribute(1, 1, VK_FORMAT_R32G32B32_SFLOAT,
+                             offsetof(InstanceInfo, color));
+    m_pipeline->addAttribute(2, 1, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(InstanceInfo, offset));
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    const glm::vec2 cell{2.0f / columns, 2.0f / rows};
+    const glm::vec2 half = cell * 0.4f;
+    const std::vector<VertexInfo> vertices = {
+        {{-half.x, -half.y}},
+        {{half.x, -half.y}},
+        {{half.x, half.y}},
+        {{-half.x, half.y}},
+    };
+    m_vbuffer = m_vk_device->createUsageBuffer<VertexInfo>(
+        vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    std::vector<uint32_t> indexs{0, 1, 2, 2, 3, 0};
+    m_ibuffer = m_vk_device->createUsageBuffer<uint32_t>(
+        indexs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    // every draw picks its quad through first instance
+    std::vector<InstanceInfo> instances;
+    instances.reserve(draw_count);
+    for (uint32_t y = 0; y < rows; ++y) {
+        for (uint32_t x = 0; x < columns; ++x) {
+            float u = static_cast<float>(x) / columns;
+            float v = static_cast<float>(y) / rows;
+            instances.push_back({
+                .color = {u, v, 1.0f - u},
+                .offset = {-1.0f + (x + 0.5f) * cell.x,
+                           -1.0f + (y + 0.5f) * cell.y},
+            });
+        }
+    }
+    m_instances = m_vk_device->createUsageBuffer<InstanceInfo>(
+        instances, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    m_commands = m_vk_device->createIndirectBuffer(draw_count,
+                                                   vbr::indirect::Fill::cpu);
+    if (!m_vbuffer || !m_ibuffer || !m_instances || !m_commands) {
+        return false;
+    }
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::drawDirect() {
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        drawIndex(6, 1, 0, 0, i);
+    }
+}
+
+// written every frame as a cpu culling pass would
+bool App::fillCommands() {
+    if (!m_commands->begin(frameIndex(), framesInFlight())) {
+        return false;
+    }
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        m_commands->push({
+            .indexCount = 6,
+            .instanceCount = 1,
+            .firstIndex = 0,
+            .vertexOffset = 0,
+            .firstInstance = i,
+        });
+    }
+    return true;
+}
+
+void App::next() {
+    m_run.next();
+    // every command picks its quad through firstInstance
+    if (m_run.mode() != Mode::done && m_run.mode() != Mode::direct &&
+        !m_vk_device->drawIndirectFirstInstance()) {
+        spdlog::warn("no draw indirect first instance, indirect skipped");
+        m_run.next(Mode::done);
+    }
+    if (m_run.mode() == Mode::indirect_count &&
+        !m_vk_device->drawIndirectCount()) {
+        spdlog::warn("no draw indirect count, skipped");
+        m_run.next(Mode::done);
+    }
+    if (m_run.done()) {
+        m_quit = true;
+    }
+}
+
+void App::render() {
+    if (m_run.done() || !begin()) {
+        return;
+    }
+    m_run.start();
+    bindPipeline(*m_pipeline);
+    const std::array<VkBuffer, 2> streams{m_vbuffer->buffer,
+                                          m_instances->buffer};
+    bindVertex(0, streams);
+    bindIndex(*m_ibuffer);
+    setViewport();
+    setScissor();
+    switch (m_run.mode()) {
+    case Mode::direct:
+        drawDirect();
+        break;
+    case Mode::indirect:
+        if (fillCommands()) {
+            drawIndexedIndirect(*m_commands, m_commands->count());
+        }
+        break;
+    case Mode::indirect_count:
+        if (fillCommands()) {
+            drawIndexedIndirectCount(*m_commands);
+        }
+        break;
+    case Mode::done:
+        break;
+    }
+    bool finished = m_run.stop();
+    end();
+
+    if (finished) {
+        m_run.report(std::to_string(draw_count) + " draws");
+        next();
+    }
+}
+
+void App::quit() {
+    m_commands.reset();
+    m_instances.reset();
+    m_ibuffer.reset();
+    m_vbuffer.reset();
+    m_layout.reset();
+    m_pipeline.reset();
+}
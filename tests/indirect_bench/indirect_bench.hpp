@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/indirect.hpp"
+#include "../../inc/layout.hpp"
+#include "../common/bench.hpp"
+#include <memory>
+#include <vector>
+
+struct VertexInfo {
+    glm::vec2 pos;
+};
+
+struct InstanceInfo {
+    glm::vec3 color;
+    glm::vec2 offset;
+};
+
+class App : public vbr::app::App {
+  private:
+    // 100 x 100 grid, one draw per quad
+    static constexpr uint32_t columns = 100;
+    static constexpr uint32_t rows = 100;
+    static constexpr uint32_t draw_count = columns * rows;
+    static constexpr uint32_t frames_per_mode = 120;
+
+    enum class Mode { direct, indirect, indirect_count, done };
+
+    std::unique_ptr<vbr::buffer::Buffer> m_vbuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_ibuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_instances;
+    std::unique_ptr<vbr::indirect::Buffer> m_commands;
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    // recording cost of every frame of the current mode
+    bench::Run<Mode> m_run{{"direct", "indirect", "indirect count"},
+                           frames_per_mode};
+
+  private:
+    void drawDirect();
+    bool fillCommands();
+    // the next mode the device supports
+    void next();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
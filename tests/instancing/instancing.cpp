@@ -0,0 +1,100 @@
+#include "instancing.hpp"
+#include "vulkan/vulkan_core.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout->init();
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          SHADER_DIR "/instancing/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          SHADER_DIR "/instancing/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    m_pipeline->addBinding(0, sizeof(VertexInfo));
+    m_pipeline->addBinding(1, sizeof(InstanceInfo),
+                           VK_VERTEX_INPUT_RATE_INSTANCE);
+    m_pipeline->addAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(VertexInfo, pos));
+    m_pipeline->addAttribute(1, 1, VK_FORMAT_R32G32B32_SFLOAT,
+                             offsetof(InstanceInfo, color));
+    m_pipeline->addAttribute(2, 1, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(InstanceInfo, offset));
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    // one cell of the grid in clip space, the quad leaves a gap
+    const glm::vec2 cell{2.0f / columns, 2.0f / rows};
+    const glm::vec2 half = cell * 0.4f;
+    const std::vector<VertexInfo> vertices = {
+        {{-half.x, -half.y}},
+        {{half.x, -half.y}},
+        {{half.x, half.y}},
+        {{-half.x, half.y}},
+    };
+    m_vbuffer = m_vk_device->createUsageBuffer<VertexInfo>(
+        vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+
+    std::vector<uint32_t> indexs{0, 1, 2, 2, 3, 0};
+    m_ibuffer = m_vk_device->createUsageBuffer<uint32_t>(
+        indexs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+    std::vector<InstanceInfo> instances;
+    instances.reserve(instance_count);
+    for (uint32_t y = 0; y < rows; ++y) {
+        for (uint32_t x = 0; x < columns; ++x) {
+            float u = static_cast<float>(x) / columns;
+            float v = static_cast<float>(y) / rows;
+            instances.push_back({
+                .color = {u, v, 1.0f - u},
+                .offset = {-1.0f + (x + 0.5f) * cell.x,
+                           -1.0f + (y + 0.5f) * cell.y},
+            });
+        }
+    }
+    m_instances = m_vk_device->createUsageBuffer<InstanceInfo>(
+        instances, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::render() {
+    if (begin()) {
+        bindPipeline(*m_pipeline);
+        const std::array<VkBuffer, 2> streams{m_vbuffer->buffer,
+                                              m_instances->buffer};
+        bindVertex(0, streams);
+        bindIndex(*m_ibuffer);
+        setViewport();
+        setScissor();
+        // the whole grid in one draw
+        drawIndex(6, instance_count);
+        end();
+    }
+}
+
+void App::quit() {
+    m_instances.reset();
+    m_ibuffer.reset();
+    m_vbuffer.reset();
+    m_layout.reset();
+    m_pipeline.reset();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include <memory>
+
+// per vertex stream, binding 0
+struct VertexInfo {
+    glm::vec2 pos;
+};
+
+// per instance stream, binding 1
+struct InstanceInfo {
+    glm::vec3 color;
+    glm::vec2 offset;
+};
+
+class App : public vbr::app::App {
+  private:
+    // 400 x 250 grid
+    static constexpr uint32_t columns = 400;
+    static constexpr uint32_t rows = 250;
+    static constexpr uint32_t instance_count = columns * rows;
+
+    std::unique_ptr<vbr::buffer::Buffer> m_vbuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_ibuffer;
+    std::unique_ptr<vbr::buffer::Buffer> m_instances;
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
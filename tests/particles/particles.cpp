@@ -0,0 +1,148 @@
+#include "particles.hpp"
+#include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    // random start, simulated on the gpu from then on
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> pos(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> vel(-0.5f, 0.5f);
+    std::vector<Particle> particles(particle_count);
+    for (auto &particle : particles) {
+        particle = {{pos(rng), pos(rng)}, {vel(rng), vel(rng)}};
+    }
+    m_particles = m_vk_device->createUsageBuffer<Particle>(
+        particles, static_cast<VkBufferUsageFlagBits>(
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+    if (!m_particles) {
+        return false;
+    }
+
+    m_descriptor = std::make_unique<vbr::descriptor::Descriptor>(
+        **m_vk_device, &m_vk_device->descriptorAllocator(),
+        &m_vk_device->layouts());
+    m_descriptor->addDescriptorBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                       VK_SHADER_STAGE_COMPUTE_BIT);
+    if (!m_descriptor->init()) {
+        return false;
+    }
+    m_descriptor->updateBuffer(
+        {m_particles->buffer, 0, sizeof(Particle) * particle_count}, 0, 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    m_compute_layout = std::make_unique<vbr::layout::Layout>(
+        **m_vk_device, &m_vk_device->layouts());
+    m_compute_layout->addConstnat(VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                                  sizeof(SimulatePush));
+    if (!m_compute_layout->init({**m_descriptor})) {
+        return false;
+    }
+
+    m_simulate = std::make_unique<vbr::cpipeline::Pipeline>(*m_vk_device);
+    m_simulate->setShader(SHADER_DIR "/particles/comp.spv");
+    m_simulate->addConstant(0, group_size);
+    m_simulate->addConstant(1, 0.8f);
+    if (!m_simulate->init(**m_compute_layout)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device,
+                                                     &m_vk_device->layouts());
+    m_layout->init();
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          SHADER_DIR "/particles/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          SHADER_DIR "/particles/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    m_pipeline->addBinding(0, sizeof(Particle));
+    m_pipeline->addAttribute(0, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(Particle, pos));
+    m_pipeline->addAttribute(1, 0, VK_FORMAT_R32G32_SFLOAT,
+                             offsetof(Particle, vel));
+    m_pipeline->topology(VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    m_last = std::chrono::steady_clock::now();
+    return true;
+}
+
+void App::update() {
+    vbr::app::App::update();
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<float> elapsed = now - m_last;
+    m_last = now;
+    m_push = {
+        // long stalls would tunnel particles through the borders
+        .dt = std::min(elapsed.count(), 0.05f),
+        .gravity = -0.5f,
+        .count = particle_count,
+    };
+}
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::render() {
+    if (!beginFrame()) {
+        return;
+    }
+    VkCommandBuffer cmd = commandBuffer();
+    // last frame's simulation writes must be visible to this one, and its
+    // vertex reads must be done before they are overwritten
+    vbr::util::BarrierBatch()
+        .buffer(m_particles->buffer,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                    VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                    VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)
+        .flush(cmd);
+    bindPipeline(*m_simulate);
+    bindDescriptorSet(m_descriptor->set(), **m_compute_layout, {},
+                      VK_PIPELINE_BIND_POINT_COMPUTE);
+    pushConstant(**m_compute_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                 sizeof(m_push), &m_push);
+    dispatch((particle_count + group_size - 1) / group_size);
+    vbr::util::BarrierBatch()
+        .buffer(m_particles->buffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT,
+                VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT)
+        .flush(cmd);
+
+    beginRendering();
+    bindPipeline(*m_pipeline);
+    bindVertex(*m_particles);
+    setViewport();
+    setScissor();
+    draw(particle_count);
+    end();
+}
+
+void App::quit() {
+    m_pipeline.reset();
+    m_layout.reset();
+    m_simulate.reset();
+    m_compute_layout.reset();
+    m_descriptor.reset();
+    m_particles.reset();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/buffer.hpp"
+#include "../../inc/compute_pipeline.hpp"
+#include "../../inc/descriptor.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include <chrono>
+#include <memory>
+
+// std430 element of the storage buffer, also read as a vertex
+struct Particle {
+    glm::vec2 pos;
+    glm::vec2 vel;
+};
+
+struct SimulatePush {
+    float dt;
+    float gravity;
+    uint32_t count;
+};
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t particle_count = 1 << 18;
+    static constexpr uint32_t group_size = 256;
+
+    std::unique_ptr<vbr::buffer::Buffer> m_particles;
+    std::unique_ptr<vbr::descriptor::Descriptor> m_descriptor;
+    std::unique_ptr<vbr::layout::Layout> m_compute_layout;
+    std::unique_ptr<vbr::cpipeline::Pipeline> m_simulate;
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    std::chrono::steady_clock::time_point m_last;
+    SimulatePush m_push{};
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
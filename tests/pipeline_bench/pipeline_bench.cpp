@@ -0,0 +1,134 @@
+#include "pipeline_bench.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+App::~App() { quit(); }
+
+std::unique_ptr<vbr::gpipeline::Pipeline> App::createPipeline() {
+    auto pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                        "../tests/shaders/base_triangle/vert.spv");
+    pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                        "../tests/shaders/base_triangle/frag.spv");
+    pipeline->addViewport(static_cast<float>(m_window_size.x),
+                          static_cast<float>(m_window_size.y));
+    pipeline->addScissor(m_window_size.x, m_window_size.y);
+    return pipeline;
+}
+
+std::vector<std::unique_ptr<vbr::gpipeline::Pipeline>>
+App::createVariants(VkFrontFace front_face) {
+    const VkPrimitiveTopology topologies[] = {
+        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN,
+    };
+    std::vector<std::unique_ptr<vbr::gpipeline::Pipeline>> ret;
+    for (auto topology : topologies) {
+        for (bool blend : {false, true}) {
+            for (VkColorComponentFlags mask = 1; mask <= 0xf; ++mask) {
+                auto pipeline = createPipeline();
+                pipeline->topology(topology);
+                pipeline->frontFace(front_face);
+                pipeline->addColorBlendAttachemt(
+                    mask, blend, VK_BLEND_FACTOR_SRC_ALPHA,
+                    VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA);
+                ret.push_back(std::move(pipeline));
+            }
+        }
+    }
+    return ret;
+}
+
+void App::benchSerial() {
+    auto pipelines = createVariants(VK_FRONT_FACE_CLOCKWISE);
+    auto begin = bench::Clock::now();
+    uint32_t failed = 0;
+    for (auto &pipeline : pipelines) {
+        if (!pipeline->init(**m_layout)) {
+            failed++;
+        }
+    }
+    spdlog::info("serial   {} pipelines in {:.2f} ms, {} failed",
+                 pipelines.size(), bench::since(begin), failed);
+}
+
+void App::benchParallel() {
+    auto pipelines = createVariants(VK_FRONT_FACE_COUNTER_CLOCKWISE);
+    auto begin = bench::Clock::now();
+    for (auto &pipeline : pipelines) {
+        pipeline->initAsync(**m_layout);
+    }
+    uint32_t failed = 0;
+    for (auto &pipeline : pipelines) {
+        if (!pipeline->wait()) {
+            failed++;
+        }
+    }
+    spdlog::info("parallel {} pipelines in {:.2f} ms on {} workers, {} "
+                 "failed",
+                 pipelines.size(), bench::since(begin),
+                 m_vk_device->workers().size(), failed);
+}
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device,
+                                                     &m_vk_device->layouts());
+    if (!m_layout->init()) {
+        return false;
+    }
+
+    benchSerial();
+    benchParallel();
+
+    // draw with the fallback until the real pipeline is ready
+    m_fallback = createPipeline();
+    m_fallback->addColorBlendAttachemt();
+    if (!m_fallback->init(**m_layout)) {
+        return false;
+    }
+    m_pipeline = createPipeline();
+    m_pipeline->addColorBlendAttachemt(
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+        true, VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA);
+    m_pipeline->fallback(m_fallback.get());
+    m_pipeline->initAsync(**m_layout);
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::render() {
+    if (begin()) {
+        if (!m_pipeline->ready()) {
+            m_fallback_frames++;
+        }
+        if (bindPipeline(*m_pipeline)) {
+            setViewport();
+            setScissor();
+            draw(3);
+        }
+        end();
+        m_frames++;
+    }
+    if (m_frames == render_frames) {
+        spdlog::info("{} of {} frames drawn with the fallback",
+                     m_fallback_frames, m_frames);
+        m_quit = true;
+    }
+}
+
+void App::quit() {
+    m_pipeline.reset();
+    m_fallback.reset();
+    m_layout.reset();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include "../common/bench.hpp"
+#include <memory>
+#include <vector>
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t render_frames = 120;
+
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    // simple pipeline drawn while the real one builds
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_fallback;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    uint32_t m_frames = 0;
+    uint32_t m_fallback_frames = 0;
+
+  private:
+    // one variant per topology, blend and write mask, front face keeps
+    // the sets of both runs apart so neither hits the other in the cache
+    std::vector<std::unique_ptr<vbr::gpipeline::Pipeline>>
+    createVariants(VkFrontFace front_face);
+    std::unique_ptr<vbr::gpipeline::Pipeline> createPipeline();
+    void benchSerial();
+    void benchParallel();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
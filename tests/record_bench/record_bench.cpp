@@ -0,0 +1,116 @@
+#include "record_bench.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <string>
+
+App::~App() { quit(); }
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout->init();
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          "../tests/shaders/base_triangle/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          "../tests/shaders/base_triangle/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+    spdlog::info("recording on {} threads",
+                 m_vk_device->recorder().slots());
+    return true;
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+// every draw into the primary on this thread
+void App::drawSingle() {
+    bindPipeline(*m_pipeline);
+    setViewport();
+    setScissor();
+    for (uint32_t i = 0; i < draw_count; ++i) {
+        draw(3);
+    }
+}
+
+// dynamic state is not inherited, every secondary sets its own
+void App::drawParallel() {
+    VkPipeline pipeline = **m_pipeline;
+    VkViewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = static_cast<float>(m_window_size.x),
+        .height = static_cast<float>(m_window_size.y),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+    VkRect2D scissor{
+        .offset = {0, 0},
+        .extent = {static_cast<uint32_t>(m_window_size.x),
+                   static_cast<uint32_t>(m_window_size.y)},
+    };
+    recordParallel(draw_count, [&](VkCommandBuffer cmd, uint32_t first,
+                                   uint32_t last) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+        for (uint32_t i = first; i < last; ++i) {
+            vkCmdDraw(cmd, 3, 1, 0, 0);
+        }
+    });
+}
+
+void App::render() {
+    if (m_run.done()) {
+        return;
+    }
+    VkRenderingFlags flags =
+        m_run.mode() == Mode::parallel
+            ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT
+            : 0;
+    if (!begin(0.0f, 0.0f, 0.0f, 0.0f, flags)) {
+        return;
+    }
+    m_run.start();
+    switch (m_run.mode()) {
+    case Mode::single:
+        drawSingle();
+        break;
+    case Mode::parallel:
+        drawParallel();
+        break;
+    case Mode::done:
+        break;
+    }
+    bool finished = m_run.stop();
+    end();
+
+    if (!finished) {
+        return;
+    }
+    auto summary = m_run.report(std::to_string(draw_count) + " draws");
+    spdlog::info("{:<14} {:>6.1f} ns per draw", m_run.name(),
+                 summary.avg * 1e6 / draw_count);
+    m_run.next();
+    if (m_run.done()) {
+        m_quit = true;
+    }
+}
+
+void App::quit() {
+    m_pipeline.reset();
+    m_layout.reset();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include "../common/bench.hpp"
+#include <memory>
+
+class App : public vbr::app::App {
+  private:
+    static constexpr uint32_t draw_count = 50000;
+    static constexpr uint32_t frames_per_mode = 120;
+
+    enum class Mode { single, parallel, done };
+
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    // recording cost of every frame of the current mode
+    bench::Run<Mode> m_run{{"single", "parallel"}, frames_per_mode};
+
+  private:
+    void drawSingle();
+    void drawParallel();
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
@@ -0,0 +1,169 @@
+#include "render_graph.hpp"
+#include "vulkan/vulkan_core.h"
+#include <cstdint>
+#include <memory>
+#include <spdlog/spdlog.h>
+
+using vbr::graph::Access;
+
+App::~App() { quit(); }
+
+void App::blit(VkCommandBuffer cmd, VkImage src, VkExtent2D src_extent,
+               VkImage dst, VkOffset2D dst_offset, VkExtent2D extent) {
+    VkImageBlit region{
+        .srcSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .srcOffsets =
+            {
+                {0, 0, 0},
+                {static_cast<int32_t>(src_extent.width),
+                 static_cast<int32_t>(src_extent.height), 1},
+            },
+        .dstSubresource =
+            {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        .dstOffsets =
+            {
+                {dst_offset.x, dst_offset.y, 0},
+                {dst_offset.x + static_cast<int32_t>(extent.width),
+                 dst_offset.y + static_cast<int32_t>(extent.height), 1},
+            },
+    };
+    vkCmdBlitImage(cmd, src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region,
+                   VK_FILTER_LINEAR);
+}
+
+// scene and overlay are drawn into transients and blitted side by side
+// onto the target, the triangle goes on top, the debug pass is never read
+// and gets culled, overlay reuses the memory of scene
+bool App::build() {
+    m_graph->reset();
+    m_graph_size = m_window_size;
+    VkFormat format = m_vk_device->format();
+    VkExtent2D full{static_cast<uint32_t>(m_window_size.x),
+                    static_cast<uint32_t>(m_window_size.y)};
+    VkExtent2D half{full.width / 2, full.height};
+
+    vbr::graph::ImageState present{
+        .layout = m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                             : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .stages = m_headless ? VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT
+                             : VK_PIPELINE_STAGE_2_NONE,
+        .access = m_headless ? VK_ACCESS_2_TRANSFER_READ_BIT
+                             : VK_ACCESS_2_NONE,
+    };
+    // the acquire semaphore is waited at color attachment output
+    m_target = m_graph->importImage(
+        "target", {format, full}, VK_NULL_HANDLE, VK_NULL_HANDLE,
+        {VK_IMAGE_LAYOUT_UNDEFINED,
+         VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE},
+        present);
+    auto scene = m_graph->createImage("scene", {format, full});
+    auto scaled = m_graph->createImage("scaled", {format, half});
+    auto overlay = m_graph->createImage("overlay", {format, full});
+    auto debug = m_graph->createImage("debug", {format, full});
+    auto target = m_target;
+    auto *graph = m_graph.get();
+
+    VkClearValue red{.color = {.float32 = {0.6f, 0.1f, 0.1f, 1.0f}}};
+    VkClearValue blue{.color = {.float32 = {0.1f, 0.1f, 0.6f, 1.0f}}};
+    m_graph->addPass("scene").color(scene, VK_ATTACHMENT_LOAD_OP_CLEAR, red);
+    m_graph->addPass("scale")
+        .use(scene, Access::transfer_src)
+        .use(scaled, Access::transfer_dst)
+        .record([=](VkCommandBuffer cmd) {
+            blit(cmd, graph->image(scene), full, graph->image(scaled), {0, 0},
+                 half);
+        });
+    m_graph->addPass("overlay").color(overlay, VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                      blue);
+    m_graph->addPass("debug").color(debug);
+    m_graph->addPass("compose")
+        .use(scaled, Access::transfer_src)
+        .use(overlay, Access::transfer_src)
+        .use(target, Access::transfer_dst)
+        .record([=](VkCommandBuffer cmd) {
+            blit(cmd, graph->image(scaled), half, graph->image(target),
+                 {0, 0}, half);
+            blit(cmd, graph->image(overlay), full, graph->image(target),
+                 {static_cast<int32_t>(half.width), 0}, half);
+        });
+    m_graph->addPass("triangle")
+        .color(target, VK_ATTACHMENT_LOAD_OP_LOAD)
+        .record([this](VkCommandBuffer cmd) {
+            bindPipeline(*m_pipeline);
+            setViewport();
+            setScissor();
+            vkCmdDraw(cmd, 3, 1, 0, 0);
+        });
+    return m_graph->compile();
+}
+
+bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
+    if (!vbr::app::App::init(flag, sample_count)) {
+        return false;
+    }
+    // compose blits into the target, not every surface allows that
+    if (!(targetUsage() & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        spdlog::error("render graph example blits into the target, the "
+                      "surface has no transfer dst usage");
+        return false;
+    }
+
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout->init();
+
+    m_pipeline = std::make_unique<vbr::gpipeline::Pipeline>(*m_vk_device);
+    m_pipeline->addShader(VK_SHADER_STAGE_VERTEX_BIT,
+                          "../tests/shaders/base_triangle/vert.spv");
+    m_pipeline->addShader(VK_SHADER_STAGE_FRAGMENT_BIT,
+                          "../tests/shaders/base_triangle/frag.spv");
+    m_pipeline->addViewport(static_cast<float>(m_window_size.x),
+                            static_cast<float>(m_window_size.y));
+    m_pipeline->addScissor(m_window_size.x, m_window_size.y);
+    m_pipeline->addColorBlendAttachemt();
+    if (!m_pipeline->init(**m_layout)) {
+        return false;
+    }
+
+    m_graph = std::make_unique<vbr::graph::Graph>(*m_vk_device);
+    return build();
+}
+
+void App::update() { vbr::app::App::update(); }
+
+void App::event(SDL_Event *event) { vbr::app::App::event(event); }
+
+void App::render() {
+    // the swapchain was recreated at a new size
+    if (m_graph_size != m_window_size && !build()) {
+        m_quit = true;
+        return;
+    }
+    if (!beginFrame()) {
+        return;
+    }
+    m_graph->bindImage(m_target, targetImage(), targetView());
+    m_graph->execute(commandBuffer());
+    endFrame();
+}
+
+void App::quit() {
+    // gpu time of every pass, once
+    if (m_graph) {
+        reportProfile();
+    }
+    m_graph.reset();
+    m_layout.reset();
+    m_pipeline.reset();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../../inc/base.hpp"
+#include "../../inc/graphics_pipeline.hpp"
+#include "../../inc/layout.hpp"
+#include "../../inc/render_graph.hpp"
+#include <memory>
+
+class App : public vbr::app::App {
+  private:
+    std::unique_ptr<vbr::layout::Layout> m_layout;
+    std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
+    std::unique_ptr<vbr::graph::Graph> m_graph;
+    // swapchain or offscreen target, rebound every frame
+    vbr::graph::ImageHandle m_target;
+    // window size the graph was compiled for
+    glm::ivec2 m_graph_size{0, 0};
+
+  private:
+    // declare and compile the passes for the current window size
+    bool build();
+    static void blit(VkCommandBuffer cmd, VkImage src, VkExtent2D src_extent,
+                     VkImage dst, VkOffset2D dst_offset, VkExtent2D extent);
+
+  public:
+    using vbr::app::App::App;
+    ~App() override;
+
+    [[nodiscard]] bool
+    init(SDL_InitFlags flag = SDL_INIT_AUDIO,
+         VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT) override;
+    void update() override;
+    void event(SDL_Event *event) override;
+    void render() override;
+    void quit() override;
+};
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// bindings of vbr::bindless::Table
+layout(set = 0, binding = 0) uniform texture2D images[];
+layout(set = 0, binding = 1) uniform sampler samplers[];
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragImage;
+layout(location = 2) flat in uint fragSampler;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(sampler2D(images[nonuniformEXT(fragImage)],
+                                 samplers[nonuniformEXT(fragSampler)]),
+                       fragTexCoord);
+}
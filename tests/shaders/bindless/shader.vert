@@ -0,0 +1,23 @@
+#version 450
+
+layout(push_constant) uniform Draw {
+    vec2 offset;
+    float scale;
+    uint image;
+    uint sampler_index;
+} draw;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+
+layout(location = 0) out vec2 fragTexCoord;
+// slots travel as varyings, the fragment shader indexes with them
+layout(location = 1) flat out uint fragImage;
+layout(location = 2) flat out uint fragSampler;
+
+void main() {
+    gl_Position = vec4(inPosition * draw.scale + draw.offset, 0.0, 1.0);
+    fragTexCoord = inTexCoord;
+    fragImage = draw.image;
+    fragSampler = draw.sampler_index;
+}
@@ -0,0 +1,14 @@
+#version 450
+
+// set per pipeline, every material is its own pipeline variant
+layout(constant_id = 0) const uint material = 0;
+
+layout(location = 0) in vec3 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // darker for lower materials, App::pipeline_count of them
+    float tint = float(material + 1u) / 8.0;
+    outColor = vec4(fragColor * tint, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 450
+
+// unit cube corner
+layout(location = 0) in vec3 inPosition;
+// bounding sphere of the object, fetched through firstInstance
+layout(location = 1) in vec4 inSphere;
+
+layout(push_constant) uniform Push {
+    mat4 view_proj;
+} push;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // the cube fits inside its bounding sphere
+    vec3 world = inSphere.xyz + inPosition * inSphere.w * 0.57735;
+    gl_Position = push.view_proj * vec4(world, 1.0);
+    fragColor = vec3(0.4, 0.45, 0.5) + 0.2 * inPosition;
+}
@@ -0,0 +1,14 @@
+#version 450
+
+// per vertex
+layout(location = 0) in vec2 inPosition;
+// per instance
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inOffset;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition + inOffset, 0.0, 1.0);
+    fragColor = inColor;
+}
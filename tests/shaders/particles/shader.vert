@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inVelocity;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition, 0.0, 1.0);
+    gl_PointSize = 2.0;
+    float speed = clamp(length(inVelocity), 0.0, 1.0);
+    fragColor = mix(vec3(0.1, 0.3, 1.0), vec3(1.0, 0.4, 0.1), speed);
+}
@@ -15,7 +15,8 @@ bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
     }
 
     m_descriptor = std::make_unique<vbr::descriptor::Descriptor>(**m_vk_device);
-    m_descriptor->addDescriptorBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    m_descriptor->addDescriptorBinding(
+        0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
     m_descriptor->addDescriptorBinding(
         1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
         VK_SHADER_STAGE_FRAGMENT_BIT);
@@ -62,9 +63,9 @@ bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
     m_ibuffer = m_vk_device->createUsageBuffer<uint32_t>(
         indexs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
-    m_uniform = m_vk_device->createUniformBuffer<UniformBufferObject>();
-    m_descriptor->updateBuffer(*m_uniform, 0, 0,
-                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    m_descriptor->updateBuffer(
+        m_vk_device->uniformRing().info(sizeof(UniformBufferObject)), 0, 0,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 
     m_texture = m_vk_device->createTexture("../asset/test.png");
     m_descriptor->updateTexture(*m_texture, 1, 0);
@@ -91,27 +92,32 @@ void App::update() {
                          m_window_size.x / (float)m_window_size.y, 0.1f, 10.0f);
     ubo.proj[1][1] *= -1;
 
-    memcpy(m_uniform->data, &ubo, sizeof(ubo));
+    // written into the ring once begin() waited for the frame slot
+    m_ubo = ubo;
 }
 
 void App::event(SDL_Event *event) { vbr::app::App::event(event); }
 
 void App::render() {
     if (begin()) {
-        bindPipeline(*m_pipeline);
-        bindDescriptorSet(m_descriptor->set(), **m_layout);
-        bindVertex(*m_vbuffer);
-        bindIndex(*m_ibuffer);
-        setViewport();
-        setScissor();
-        drawIndex(6);
+        auto slice = m_vk_device->uniformRing().push(m_ubo);
+        // an exhausted ring has no offset to bind, the frame stays empty
+        if (slice.valid()) {
+            bindPipeline(*m_pipeline);
+            bindDescriptorSet(m_descriptor->set(), **m_layout,
+                              {slice.offset});
+            bindVertex(*m_vbuffer);
+            bindIndex(*m_ibuffer);
+            setViewport();
+            setScissor();
+            drawIndex(6);
+        }
         end();
     }
 }
 
 void App::quit() {
     m_texture.reset();
-    m_uniform.reset();
     m_ibuffer.reset();
     m_vbuffer.reset();
     m_descriptor.reset();
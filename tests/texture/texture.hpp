@@ -26,7 +26,6 @@ class App : public vbr::app::App {
     std::unique_ptr<vbr::image::Texture> m_texture;
     std::unique_ptr<vbr::buffer::Buffer> m_vbuffer;
     std::unique_ptr<vbr::buffer::Buffer> m_ibuffer;
-    std::unique_ptr<vbr::buffer::Buffer> m_uniform;
     std::unique_ptr<vbr::layout::Layout> m_layout;
     std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
     UniformBufferObject m_ubo;
@@ -2,6 +2,7 @@
 #include "uniform.hpp"
 #include <SDL3/SDL_init.h>
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #define SDL_MAIN_USE_CALLBACKS 1 /* use the callbacks instead of main() */
 #include <SDL3/SDL.h>
@@ -10,9 +11,15 @@
 std::unique_ptr<App> app;
 
 SDL_AppResult SDL_AppInit(void **appstate [[maybe_unused]],
-                          int argc [[maybe_unused]],
-                          char **argv [[maybe_unused]]) {
-    app = std::make_unique<App>();
+                          int argc, char **argv) {
+    // --headless renders offscreen without window or vsync
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--headless")) {
+            headless = true;
+        }
+    }
+    app = std::make_unique<App>(glm::ivec2{1024, 980}, headless);
     if (!app->init()) {
         return SDL_APP_FAILURE;
     }
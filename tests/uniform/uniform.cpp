@@ -14,13 +14,17 @@ bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
         return false;
     }
 
-    m_descriptor = std::make_unique<vbr::descriptor::Descriptor>(**m_vk_device);
-    m_descriptor->addDescriptorBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    m_descriptor = std::make_unique<vbr::descriptor::Descriptor>(
+        **m_vk_device, &m_vk_device->descriptorAllocator(),
+        &m_vk_device->layouts());
+    m_descriptor->addDescriptorBinding(
+        0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
     if (!m_descriptor->init()) {
         return false;
     }
 
-    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device);
+    m_layout = std::make_unique<vbr::layout::Layout>(**m_vk_device,
+                                                     &m_vk_device->layouts());
     if (!m_layout->init({**m_descriptor})) {
         return false;
     }
@@ -57,12 +61,52 @@ bool App::init(SDL_InitFlags flag, VkSampleCountFlagBits sample_count) {
     m_ibuffer = m_vk_device->createUsageBuffer<uint32_t>(
         indexs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
-    m_uniform = m_vk_device->createUniformBuffer<UniformBufferObject>();
-    m_descriptor->updateBuffer(*m_uniform, 0, 0,
-                               VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    m_descriptor->updateBuffer(
+        m_vk_device->uniformRing().info(sizeof(UniformBufferObject)), 0, 0,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+
+    framesInFlight(FrameBench::counts[0]);
+    m_bench.start = std::chrono::high_resolution_clock::now();
     return true;
 }
 
+void App::bench() {
+    if (m_bench.stage >= FrameBench::counts.size()) {
+        return;
+    }
+    m_bench.frames++;
+    if (m_bench.frames == FrameBench::warmup_frames) {
+        m_bench.start = std::chrono::high_resolution_clock::now();
+        return;
+    }
+    if (m_bench.frames <
+        FrameBench::warmup_frames + FrameBench::measure_frames) {
+        return;
+    }
+
+    auto now = std::chrono::high_resolution_clock::now();
+    double total_ms =
+        std::chrono::duration<double, std::milli>(now - m_bench.start).count();
+    m_bench.avg_ms[m_bench.stage] = total_ms / FrameBench::measure_frames;
+    spdlog::info("frames in flight {}: {:.3f} ms/frame",
+                 FrameBench::counts[m_bench.stage],
+                 m_bench.avg_ms[m_bench.stage]);
+
+    m_bench.stage++;
+    m_bench.frames = 0;
+    if (m_bench.stage < FrameBench::counts.size()) {
+        framesInFlight(FrameBench::counts[m_bench.stage]);
+        return;
+    }
+
+    for (size_t i = 0; i < FrameBench::counts.size(); ++i) {
+        spdlog::info("frames in flight {}: {:.3f} ms/frame ({:.2f}x of 1)",
+                     FrameBench::counts[i], m_bench.avg_ms[i],
+                     m_bench.avg_ms[0] / m_bench.avg_ms[i]);
+    }
+    framesInFlight(2);
+}
+
 void App::update() {
     vbr::app::App::update();
     static auto startTime = std::chrono::high_resolution_clock::now();
@@ -83,26 +127,32 @@ void App::update() {
                          m_window_size.x / (float)m_window_size.y, 0.1f, 10.0f);
     ubo.proj[1][1] *= -1;
 
-    memcpy(m_uniform->data, &ubo, sizeof(ubo));
+    // written into the frame slot once begin() waited for it
+    m_ubo = ubo;
 }
 
 void App::event(SDL_Event *event) { vbr::app::App::event(event); }
 
 void App::render() {
     if (begin()) {
-        bindPipeline(*m_pipeline);
-        bindDescriptorSet(m_descriptor->set(), **m_layout);
-        bindVertex(*m_vbuffer);
-        bindIndex(*m_ibuffer);
-        setViewport();
-        setScissor();
-        drawIndex(6);
+        auto slice = m_vk_device->uniformRing().push(m_ubo);
+        // an exhausted ring has no offset to bind, the frame stays empty
+        if (slice.valid()) {
+            bindPipeline(*m_pipeline);
+            bindDescriptorSet(m_descriptor->set(), **m_layout,
+                              {slice.offset});
+            bindVertex(*m_vbuffer);
+            bindIndex(*m_ibuffer);
+            setViewport();
+            setScissor();
+            drawIndex(6);
+        }
         end();
+        bench();
     }
 }
 
 void App::quit() {
-    m_uniform.reset();
     m_ibuffer.reset();
     m_vbuffer.reset();
     m_descriptor.reset();
@@ -5,7 +5,10 @@
 #include "../../inc/descriptor.hpp"
 #include "../../inc/graphics_pipeline.hpp"
 #include "../../inc/layout.hpp"
+#include <array>
+#include <chrono>
 #include <memory>
+#include <vector>
 
 struct VertexInfo {
     glm::vec2 pos;
@@ -18,15 +21,31 @@ struct UniformBufferObject {
     alignas(16) glm::mat4 proj;
 };
 
+// frame time comparison for different frames in flight count
+struct FrameBench {
+    static constexpr std::array<uint32_t, 3> counts = {1, 2, 3};
+    static constexpr uint32_t warmup_frames = 60;
+    static constexpr uint32_t measure_frames = 600;
+
+    size_t stage = 0;
+    uint32_t frames = 0;
+    std::chrono::high_resolution_clock::time_point start;
+    std::array<double, counts.size()> avg_ms{};
+};
+
 class App : public vbr::app::App {
   private:
+    // one set over the device uniform ring, offset picked per frame
     std::unique_ptr<vbr::descriptor::Descriptor> m_descriptor;
     std::unique_ptr<vbr::buffer::Buffer> m_vbuffer;
     std::unique_ptr<vbr::buffer::Buffer> m_ibuffer;
-    std::unique_ptr<vbr::buffer::Buffer> m_uniform;
     std::unique_ptr<vbr::layout::Layout> m_layout;
     std::unique_ptr<vbr::gpipeline::Pipeline> m_pipeline;
     UniformBufferObject m_ubo;
+    FrameBench m_bench;
+
+  private:
+    void bench();
 
   public:
     using vbr::app::App::App;